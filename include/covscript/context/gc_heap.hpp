@@ -0,0 +1,297 @@
+#pragma once
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <new>
+
+#ifndef COVSCRIPT_GC_PAGE_SIZE
+#define COVSCRIPT_GC_PAGE_SIZE 65536
+#endif
+
+namespace cs
+{
+	/*
+	 * Paged heap of collected objects
+	 * Objects of one type are kept in pages aligned to their size, with live and mark bits in side
+	 * bitmaps at the start of every page, so marking never touches the objects and the page of an
+	 * object is found by masking its address. Allocation pops the free list of the current page.
+	 * A collection only marks, pages are swept one by one when allocation needs free slots,
+	 * and a sweep scans the bitmaps for objects live but unmarked.
+	 */
+	template <typename T, std::size_t page_size = COVSCRIPT_GC_PAGE_SIZE>
+	class gc_heap final
+	{
+		static_assert((page_size & (page_size - 1)) == 0, "page_size must be a power of two.");
+		static_assert(sizeof(T) >= sizeof(void *), "Free slots are linked through the objects.");
+
+		static constexpr std::size_t max_slots = page_size / sizeof(T);
+		static constexpr std::size_t bitmap_words = (max_slots + 63) / 64;
+
+		struct page
+		{
+			gc_heap *owner;
+			page *next;
+			page *next_unswept;
+			void *free_list;
+			std::size_t free_count;
+			std::size_t mark_count;
+			std::uint64_t live[bitmap_words];
+			std::uint64_t marks[bitmap_words];
+		};
+
+		static constexpr std::size_t slots_offset = (sizeof(page) + alignof(T) - 1) / alignof(T) * alignof(T);
+		static constexpr std::size_t slot_count = (page_size - slots_offset) / sizeof(T);
+
+		static_assert(slot_count > 0, "Objects are too large for a page.");
+
+		page *m_pages = nullptr;
+		page *m_current = nullptr;
+		// Pages marked by the last collection and not swept yet
+		page *m_unswept = nullptr;
+		std::size_t m_page_count = 0;
+		// Objects allocated and not found unreachable
+		std::size_t m_size = 0;
+		// Marked objects not traced yet
+		std::vector<T *> m_grey;
+
+		static page *page_of(const T *ptr) noexcept
+		{
+			return reinterpret_cast<page *>(reinterpret_cast<std::uintptr_t>(ptr) & ~std::uintptr_t(page_size - 1));
+		}
+
+		static T *slots(page *p) noexcept
+		{
+			return reinterpret_cast<T *>(reinterpret_cast<char *>(p) + slots_offset);
+		}
+
+		page *new_page()
+		{
+			page *p = ::new (::operator new(page_size, std::align_val_t(page_size))) page;
+			p->owner = this;
+			p->next = m_pages;
+			p->next_unswept = nullptr;
+			p->free_count = slot_count;
+			p->mark_count = 0;
+			std::memset(p->live, 0, sizeof(p->live));
+			std::memset(p->marks, 0, sizeof(p->marks));
+			// Linked in address order
+			T *base = slots(p);
+			p->free_list = base;
+			for (std::size_t i = 0; i + 1 < slot_count; ++i)
+				*reinterpret_cast<void **>(base + i) = base + i + 1;
+			*reinterpret_cast<void **>(base + slot_count - 1) = nullptr;
+			m_pages = p;
+			++m_page_count;
+			return p;
+		}
+
+		static void free_page(page *p) noexcept
+		{
+			p->~page();
+			::operator delete(p, std::align_val_t(page_size));
+		}
+
+		// Destroys objects live but unmarked
+		static void sweep(page *p) noexcept
+		{
+			T *base = slots(p);
+			for (std::size_t w = 0; w < bitmap_words; ++w)
+			{
+				std::uint64_t dead = p->live[w] & ~p->marks[w];
+				p->live[w] &= p->marks[w];
+				while (dead != 0)
+				{
+					T *ptr = base + w * 64 + count_trailing_zeros(dead);
+					dead &= dead - 1;
+					ptr->~T();
+					*reinterpret_cast<void **>(ptr) = p->free_list;
+					p->free_list = ptr;
+					++p->free_count;
+				}
+			}
+		}
+
+		static unsigned count_trailing_zeros(std::uint64_t val) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return __builtin_ctzll(val);
+#else
+			unsigned count = 0;
+			while ((val & 1) == 0)
+			{
+				val >>= 1;
+				++count;
+			}
+			return count;
+#endif
+		}
+
+		void finish_sweep() noexcept
+		{
+			while (m_unswept != nullptr)
+			{
+				page *p = m_unswept;
+				m_unswept = p->next_unswept;
+				sweep(p);
+			}
+		}
+
+		// Pages without objects are returned, except the current one
+		void release_empty_pages() noexcept
+		{
+			for (page **it = &m_pages; *it != nullptr;)
+			{
+				page *p = *it;
+				if (p->free_count == slot_count && p != m_current)
+				{
+					*it = p->next;
+					free_page(p);
+					--m_page_count;
+				}
+				else
+					it = &p->next;
+			}
+		}
+
+		void next_page()
+		{
+			while (m_unswept != nullptr)
+			{
+				page *p = m_unswept;
+				m_unswept = p->next_unswept;
+				sweep(p);
+				if (p->free_list != nullptr)
+				{
+					m_current = p;
+					return;
+				}
+			}
+			m_current = new_page();
+		}
+
+	   public:
+		gc_heap() = default;
+
+		gc_heap(const gc_heap &) = delete;
+
+		gc_heap &operator=(const gc_heap &) = delete;
+
+		~gc_heap()
+		{
+			while (m_pages != nullptr)
+			{
+				page *p = m_pages;
+				m_pages = p->next;
+				T *base = slots(p);
+				for (std::size_t w = 0; w < bitmap_words; ++w)
+				{
+					for (std::uint64_t live = p->live[w]; live != 0; live &= live - 1)
+						base[w * 64 + count_trailing_zeros(live)].~T();
+				}
+				free_page(p);
+			}
+		}
+
+		template <typename... ArgsT>
+		T *allocate(ArgsT &&...args)
+		{
+			if (m_current == nullptr || m_current->free_list == nullptr)
+				next_page();
+			page *p = m_current;
+			void *mem = p->free_list;
+			void *next = *static_cast<void **>(mem);
+			T *ptr;
+			try
+			{
+				ptr = ::new (mem) T(std::forward<ArgsT>(args)...);
+			}
+			catch (...)
+			{
+				*static_cast<void **>(mem) = next;
+				throw;
+			}
+			p->free_list = next;
+			--p->free_count;
+			std::size_t idx = ptr - slots(p);
+			p->live[idx / 64] |= std::uint64_t(1) << (idx % 64);
+			++m_size;
+			return ptr;
+		}
+
+		// Objects allocated and not found unreachable by a collection
+		std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+
+		std::size_t page_count() const noexcept
+		{
+			return m_page_count;
+		}
+
+		static constexpr std::size_t objects_per_page() noexcept
+		{
+			return slot_count;
+		}
+
+		// Marks a live object of any heap, it is traced later by collect
+		static void mark(const T *ptr)
+		{
+			page *p = page_of(ptr);
+			std::size_t idx = ptr - slots(p);
+			std::uint64_t bit = std::uint64_t(1) << (idx % 64);
+			if ((p->marks[idx / 64] & bit) == 0)
+			{
+				p->marks[idx / 64] |= bit;
+				++p->mark_count;
+				p->owner->m_grey.push_back(const_cast<T *>(ptr));
+			}
+		}
+
+		/*
+		 * Runs a collection and returns the count of unreachable objects
+		 * mark_roots() marks objects referred from outside the heap, trace(obj) marks objects referred by obj.
+		 * Unreachable objects are destroyed when their page is swept by a later allocation or collection.
+		 */
+		template <typename roots_t, typename trace_t>
+		std::size_t collect(roots_t &&mark_roots, trace_t &&trace)
+		{
+			finish_sweep();
+			release_empty_pages();
+			for (page *p = m_pages; p != nullptr; p = p->next)
+			{
+				std::memset(p->marks, 0, sizeof(p->marks));
+				p->mark_count = 0;
+			}
+			mark_roots();
+			// Traced by a work list, long chains of objects do not recurse
+			while (!m_grey.empty())
+			{
+				T *ptr = m_grey.back();
+				m_grey.pop_back();
+				trace(*ptr);
+			}
+			std::size_t marked = 0;
+			m_unswept = nullptr;
+			for (page *p = m_pages; p != nullptr; p = p->next)
+			{
+				marked += p->mark_count;
+				p->next_unswept = m_unswept;
+				m_unswept = p;
+			}
+			m_current = nullptr;
+			std::size_t garbage = m_size - marked;
+			m_size = marked;
+			return garbage;
+		}
+
+		// Destroys every unreachable object now
+		void sweep_all() noexcept
+		{
+			finish_sweep();
+			release_empty_pages();
+		}
+	};
+} // namespace cs
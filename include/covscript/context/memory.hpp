@@ -1,9 +1,9 @@
 #pragma once
 #include <covscript/common/platform.hpp>
+#include <covscript/context/gc_heap.hpp>
 #include <covscript/types/types.hpp>
 #include <vector>
 #include <memory>
-#include <list>
 
 #ifndef COVSCRIPT_GC_THRESHOLD
 #define COVSCRIPT_GC_THRESHOLD 1024
@@ -24,29 +24,32 @@ namespace cs
 			const memory_manager *manager = nullptr;
 
 		   public:
-			string name;
+			symbol_t name;
 			stack_visitor() = default;
 			stack_visitor(string_view str) : name(str) {}
+			stack_visitor(symbol_t sym) : name(sym) {}
 		};
 
-		// For visiting heap memory
+		// For visiting heap memory, referred by address and never copied out of the heap
 		class heap_pointer final
 		{
 			friend class memory_manager;
 #ifdef COVSCRIPT_DEBUG
 			string name = "<Unknown>";
 #endif
-			mutable std::size_t reachable_count = 0;
-
-			heap_pointer() = default;
-			heap_pointer(var val) : data(std::move(val)) {}
 
 		   public:
 			var data;
 
-			void mark_reachable() const noexcept
+			heap_pointer() = default;
+			heap_pointer(var val) : data(std::move(val)) {}
+			heap_pointer(const heap_pointer &) = delete;
+			heap_pointer &operator=(const heap_pointer &) = delete;
+
+			// Only for objects allocated by gcnew, objects referred by data are marked by the next gc
+			void mark_reachable() const
 			{
-				++reachable_count;
+				gc_heap<heap_pointer>::mark(this);
 			}
 		};
 
@@ -57,21 +60,26 @@ namespace cs
 			string name = "<Temporary>";
 #endif
 			bool is_temp = true;
+			// Temporaries of the domain are allocated in the arena of the manager
+			bool in_arena = false;
 			std::size_t stack_start = 0;
-			map_t<string, std::size_t> slot_map;
+			// Keyed by interned names, lookups are pointer comparisons
+			map_t<symbol_t, std::size_t> slot_map;
 			std::shared_ptr<bool> is_active = std::make_shared<bool>(true);
 
-			domain() = default;
-
 		   public:
+			domain() = default;
 			~domain() { *is_active = false; }
 		};
 
 	   private:
+		// Declared first, so values on the stack are destroyed before it
+		domain_arena m_arena;
 		stack<std::size_t> m_domain_stack;
-		stack<var> m_stack;
+		// Values never move, references returned by access stay valid while the value is on the stack
+		segmented_stack<var> m_stack;
 
-		std::list<heap_pointer> m_heap;
+		gc_heap<heap_pointer> m_heap;
 		std::size_t m_last_heap_size = 0;
 		std::size_t m_gc_threshold = 0;
 
@@ -93,11 +101,16 @@ namespace cs
 		{
 			std::size_t stack_start = m_stack.size();
 			if (declare)
-				get_top_domain().slot_map.emplace(name, stack_start);
+				get_top_domain().slot_map.emplace(symbol_t(name), stack_start);
+			// Nested temporary domains only, values of the outermost domain live as long as the manager
+			bool in_arena = !declare && !m_domain_stack.empty();
+			if (in_arena)
+				m_arena.enter();
 			m_stack.push(var::make<domain>());
 			m_domain_stack.push(stack_start);
 			domain &d = get_top_domain();
 			d.is_temp = !declare;
+			d.in_arena = in_arena;
 			d.stack_start = stack_start;
 #ifdef COVSCRIPT_DEBUG
 			d.name = name.view();
@@ -109,15 +122,19 @@ namespace cs
 			domain &d = get_top_domain();
 			if (d.is_temp || force_clear)
 			{
+				bool in_arena = d.in_arena;
 				std::size_t stack_start = m_domain_stack.pop();
 				while (m_stack.size() > stack_start)
 					m_stack.pop_no_return();
+				// Values that escaped keep their memory, the rest is released at once
+				if (in_arena)
+					m_arena.leave();
 			}
 			else
 				m_domain_stack.pop_no_return();
 		}
 
-		void declare_var(const string &name, const var &value, bool override = false)
+		void declare_var(symbol_t name, const var &value, bool override = false)
 		{
 			domain &d = get_top_domain();
 			auto it = d.slot_map.find(name);
@@ -126,7 +143,7 @@ namespace cs
 				if (override)
 					m_stack[it->second] = value;
 				else
-					throw runtime_error("Variable \"" + name + "\" already defined in current scope.");
+					throw runtime_error("Variable \"" + string(name.view()) + "\" already defined in current scope.");
 			}
 			else
 			{
@@ -135,6 +152,11 @@ namespace cs
 			}
 		}
 
+		void declare_var(string_view name, const var &value, bool override = false)
+		{
+			declare_var(symbol_t(name), value, override);
+		}
+
 		var &access(stack_visitor &v)
 		{
 			if (v.manager == this && *v.is_active)
@@ -153,7 +175,7 @@ namespace cs
 						return m_stack[v.stack_idx];
 					}
 				}
-				throw runtime_error("Use of undefined variable \"" + v.name + "\".");
+				throw runtime_error("Use of undefined variable \"" + string(v.name.view()) + "\".");
 			}
 		}
 
@@ -181,23 +203,29 @@ namespace cs
 
 		heap_pointer *gcnew()
 		{
-			m_heap.emplace_front();
-			return &m_heap.front();
+			return m_heap.allocate();
 		}
 
 		template <typename T, typename... ArgsT>
 		heap_pointer *gcnew(ArgsT &&...args)
 		{
-			m_heap.emplace_front(var::make<T>(std::forward<ArgsT>(args)...));
-			return &m_heap.front();
+			return m_heap.allocate(var::make<T>(std::forward<ArgsT>(args)...));
+		}
+
+		// Objects on the heap not found unreachable by the last gc
+		std::size_t heap_size() const noexcept
+		{
+			return m_heap.size();
 		}
 
 		std::size_t gc(bool force = false);
 	};
 } // namespace cs
 
+// Variables refer to heap objects by pointer
 template <>
-void cs_impl::mark_reachable<cs::memory_manager::heap_pointer>(const cs::memory_manager::heap_pointer &ptr)
+inline void cs_impl::mark_reachable<cs::memory_manager::heap_pointer *>(cs::memory_manager::heap_pointer *const &ptr)
 {
-	ptr.mark_reachable();
-}
\ No newline at end of file
+	if (ptr != nullptr)
+		ptr->mark_reachable();
+}
@@ -0,0 +1,93 @@
+#pragma once
+#ifdef COVSCRIPT_ALLOC_STATS
+#include <typeinfo>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace cs
+{
+	/*
+	 * Allocation telemetry per allocated type
+	 * Only compiled with COVSCRIPT_ALLOC_STATS, the hooks in slab_allocator and allocator_type vanish otherwise.
+	 * A pool hit is an allocation served from a cache without taking any lock or calling the system allocator.
+	 * std::allocator used in compatibility mode is not instrumented.
+	 */
+	namespace alloc_stats
+	{
+		struct type_counters
+		{
+			const std::type_info &type;
+			std::size_t object_size;
+			// Allocations are hits plus misses, live objects are live bytes over the size
+			std::atomic<std::size_t> pool_hits{0};
+			std::atomic<std::size_t> pool_misses{0};
+			std::atomic<std::size_t> frees{0};
+			// Not cleared by reset, it describes memory still in use
+			std::atomic<std::size_t> live_bytes{0};
+			type_counters *next = nullptr;
+
+			// Registers itself, records are never removed
+			type_counters(const std::type_info &, std::size_t);
+		};
+
+		template <typename T>
+		type_counters &counters_of()
+		{
+			static type_counters counters(typeid(T), sizeof(T));
+			return counters;
+		}
+
+		template <typename T>
+		void record_allocate(std::size_t n, bool pool_hit) noexcept
+		{
+			type_counters &counters = counters_of<T>();
+			(pool_hit ? counters.pool_hits : counters.pool_misses).fetch_add(1, std::memory_order_relaxed);
+			counters.live_bytes.fetch_add(n * sizeof(T), std::memory_order_relaxed);
+		}
+
+		template <typename T>
+		void record_deallocate(std::size_t n) noexcept
+		{
+			type_counters &counters = counters_of<T>();
+			counters.frees.fetch_add(1, std::memory_order_relaxed);
+			counters.live_bytes.fetch_sub(n * sizeof(T), std::memory_order_relaxed);
+		}
+
+		struct type_stats
+		{
+			std::string type_name;
+			std::size_t object_size = 0;
+			std::size_t allocations = 0;
+			std::size_t frees = 0;
+			std::size_t pool_hits = 0;
+			std::size_t pool_misses = 0;
+			std::size_t live_objects = 0;
+			std::size_t live_bytes = 0;
+
+			double hit_rate() const noexcept
+			{
+				return pool_hits + pool_misses == 0 ? 0 : double(pool_hits) / double(pool_hits + pool_misses);
+			}
+		};
+
+		type_stats collect(const type_counters &);
+
+		// Every instrumented type, most live bytes first
+		std::vector<type_stats> snapshot();
+
+		template <typename T>
+		type_stats stats_of()
+		{
+			return collect(counters_of<T>());
+		}
+
+		// {"types": [{"type": ..., "size": ..., "allocations": ..., ...}, ...]}
+		std::string to_json();
+
+		// Clears event counters of all types, live counts are kept
+		void reset() noexcept;
+	} // namespace alloc_stats
+} // namespace cs
+#endif
@@ -1,12 +1,26 @@
 #pragma once
+#include <covscript/types/alloc_stats.hpp>
+#include <covscript/types/slab.hpp>
+#include <initializer_list>
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
+#include <new>
 
 #ifndef COVSCRIPT_STACK_PRESERVE
 #define COVSCRIPT_STACK_PRESERVE 64
 #endif
 
+#ifndef COVSCRIPT_STACK_SEGMENT_SIZE
+#define COVSCRIPT_STACK_SEGMENT_SIZE 256
+#endif
+
 #ifndef COVSCRIPT_BLOCK_ALLOCATOR_SIZE
 #define COVSCRIPT_BLOCK_ALLOCATOR_SIZE 64
 #endif
@@ -16,21 +30,536 @@ namespace cs
 	using bool_t = bool;
 	using char_t = char;
 	using uchar_t = char32_t;
+#ifdef COVSCRIPT_DOUBLE_PRECISION
+	using float_t = double;
+#else
 	using float_t = long double;
+#endif
 	using integer_t = long long int;
 	using byte_string_t = std::basic_string<char>;
 	using byte_string_view = std::basic_string_view<char>;
 	using unicode_string_t = std::basic_string<char32_t>;
 	using unicode_string_view = std::basic_string_view<char32_t>;
 
+	// Move n elements into uninitialized storage one by one, the ranges may overlap
+	template <typename T>
+	void relocate_by_move(T *src, T *dst, std::size_t n) noexcept
+	{
+		if (dst < src)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				::new (dst + i) T(std::move(src[i]));
+				src[i].~T();
+			}
+		}
+		else if (dst > src)
+		{
+			for (std::size_t i = n; i > 0; --i)
+			{
+				::new (dst + i - 1) T(std::move(src[i - 1]));
+				src[i - 1].~T();
+			}
+		}
+	}
+
+	/*
+	 * Customization point of bulk relocation
+	 * Moves n elements into uninitialized storage and ends the lifetime of the sources, the ranges may overlap.
+	 * Trivially copyable types are relocated with a single memmove, specialized for variables in variable.hpp.
+	 */
+	template <typename T>
+	struct relocator
+	{
+		static void relocate(T *src, T *dst, std::size_t n) noexcept
+		{
+			if constexpr (std::is_trivially_copyable_v<T>)
+			{
+				if (n > 0)
+					std::memmove(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(T));
+			}
+			else
+				relocate_by_move(src, dst, n);
+		}
+	};
+
+	/*
+	 * Contiguous container growing by relocation
+	 * Same interface as the subset of std::vector used by the runtime, but elements are moved
+	 * into new storage through relocator, so growing an array of variables is a memmove in common cases.
+	 */
+	template <typename T>
+	class vector final
+	{
+		static_assert(std::is_nothrow_move_constructible_v<T>, "Elements of cs::vector must be nothrow move constructible.");
+
+		std::allocator<T> m_alloc;
+		T *m_data = nullptr;
+		std::size_t m_size = 0;
+		std::size_t m_capacity = 0;
+
+		std::size_t next_capacity(std::size_t required) const noexcept
+		{
+			return std::max(required, m_capacity < 8 ? std::size_t(8) : m_capacity * 2);
+		}
+
+		void reallocate(std::size_t capacity)
+		{
+			T *data = m_alloc.allocate(capacity);
+			relocator<T>::relocate(m_data, data, m_size);
+			release();
+			m_data = data;
+			m_capacity = capacity;
+		}
+
+		void release() noexcept
+		{
+			if (m_data != nullptr)
+				m_alloc.deallocate(m_data, m_capacity);
+			m_data = nullptr;
+			m_capacity = 0;
+		}
+
+		void destroy_range(std::size_t first, std::size_t last) noexcept
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				for (std::size_t i = first; i < last; ++i)
+					m_data[i].~T();
+			}
+		}
+
+		// Construct elements up to count, the size is left unchanged if a constructor throws
+		template <typename construct_t>
+		void grow_to(std::size_t count, construct_t &&construct)
+		{
+			std::size_t size = m_size;
+			try
+			{
+				for (; m_size < count; ++m_size)
+					construct(m_data + m_size);
+			}
+			catch (...)
+			{
+				destroy_range(size, m_size);
+				m_size = size;
+				throw;
+			}
+		}
+
+		// Open a gap of n uninitialized elements at pos
+		T *open_gap(std::size_t pos, std::size_t n)
+		{
+			if (m_size + n > m_capacity)
+			{
+				std::size_t capacity = next_capacity(m_size + n);
+				T *data = m_alloc.allocate(capacity);
+				relocator<T>::relocate(m_data, data, pos);
+				relocator<T>::relocate(m_data + pos, data + pos + n, m_size - pos);
+				release();
+				m_data = data;
+				m_capacity = capacity;
+			}
+			else
+				relocator<T>::relocate(m_data + pos, m_data + pos + n, m_size - pos);
+			m_size += n;
+			return m_data + pos;
+		}
+
+		// Close a gap of n uninitialized elements at pos
+		void close_gap(std::size_t pos, std::size_t n) noexcept
+		{
+			relocator<T>::relocate(m_data + pos + n, m_data + pos, m_size - pos - n);
+			m_size -= n;
+		}
+
+	   public:
+		using value_type = T;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference = T &;
+		using const_reference = const T &;
+		using pointer = T *;
+		using const_pointer = const T *;
+		using iterator = T *;
+		using const_iterator = const T *;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		vector() noexcept = default;
+
+		explicit vector(std::size_t count)
+		{
+			try
+			{
+				resize(count);
+			}
+			catch (...)
+			{
+				release();
+				throw;
+			}
+		}
+
+		vector(std::size_t count, const T &val)
+		{
+			try
+			{
+				resize(count, val);
+			}
+			catch (...)
+			{
+				release();
+				throw;
+			}
+		}
+
+		template <typename It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+		vector(It first, It last)
+		{
+			try
+			{
+				for (; first != last; ++first)
+					emplace_back(*first);
+			}
+			catch (...)
+			{
+				clear();
+				release();
+				throw;
+			}
+		}
+
+		vector(std::initializer_list<T> il) : vector(il.begin(), il.end()) {}
+
+		vector(const vector &other)
+		{
+			reserve(other.m_size);
+			// The destructor does not run if a constructor throws, elements copied so far are destroyed here
+			try
+			{
+				for (; m_size < other.m_size; ++m_size)
+					::new (m_data + m_size) T(other.m_data[m_size]);
+			}
+			catch (...)
+			{
+				clear();
+				release();
+				throw;
+			}
+		}
+
+		vector(vector &&other) noexcept : m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity)
+		{
+			other.m_data = nullptr;
+			other.m_size = 0;
+			other.m_capacity = 0;
+		}
+
+		~vector()
+		{
+			clear();
+			release();
+		}
+
+		vector &operator=(const vector &other)
+		{
+			if (this != &other)
+			{
+				vector copy(other);
+				swap(copy);
+			}
+			return *this;
+		}
+
+		vector &operator=(vector &&other) noexcept
+		{
+			if (this != &other)
+			{
+				vector tmp(std::move(other));
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		void swap(vector &other) noexcept
+		{
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+			std::swap(m_capacity, other.m_capacity);
+		}
+
+		inline bool empty() const noexcept
+		{
+			return m_size == 0;
+		}
+
+		inline std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+
+		inline std::size_t capacity() const noexcept
+		{
+			return m_capacity;
+		}
+
+		void reserve(std::size_t capacity)
+		{
+			if (capacity > m_capacity)
+				reallocate(capacity);
+		}
+
+		void shrink_to_fit()
+		{
+			if (m_size == 0)
+				release();
+			else if (m_size < m_capacity)
+				reallocate(m_size);
+		}
+
+		void resize(std::size_t count)
+		{
+			if (count < m_size)
+			{
+				destroy_range(count, m_size);
+				m_size = count;
+			}
+			else
+			{
+				reserve(count);
+				grow_to(count, [](T *ptr) { ::new (ptr) T(); });
+			}
+		}
+
+		void resize(std::size_t count, const T &val)
+		{
+			if (count < m_size)
+			{
+				destroy_range(count, m_size);
+				m_size = count;
+			}
+			else if (count > m_capacity)
+			{
+				// val may refer to an element of this vector
+				T copy(val);
+				reserve(count);
+				grow_to(count, [&copy](T *ptr) { ::new (ptr) T(copy); });
+			}
+			else
+				grow_to(count, [&val](T *ptr) { ::new (ptr) T(val); });
+		}
+
+		void clear() noexcept
+		{
+			destroy_range(0, m_size);
+			m_size = 0;
+		}
+
+		template <typename... ArgsT>
+		T &emplace_back(ArgsT &&...args)
+		{
+			if (m_size == m_capacity)
+			{
+				// Construct the new element first, arguments may refer to elements of this vector
+				std::size_t capacity = next_capacity(m_size + 1);
+				T *data = m_alloc.allocate(capacity);
+				try
+				{
+					::new (data + m_size) T(std::forward<ArgsT>(args)...);
+				}
+				catch (...)
+				{
+					m_alloc.deallocate(data, capacity);
+					throw;
+				}
+				relocator<T>::relocate(m_data, data, m_size);
+				release();
+				m_data = data;
+				m_capacity = capacity;
+			}
+			else
+				::new (m_data + m_size) T(std::forward<ArgsT>(args)...);
+			return m_data[m_size++];
+		}
+
+		inline void push_back(const T &val)
+		{
+			emplace_back(val);
+		}
+
+		inline void push_back(T &&val)
+		{
+			emplace_back(std::move(val));
+		}
+
+		inline void pop_back() noexcept
+		{
+			m_data[--m_size].~T();
+		}
+
+		template <typename... ArgsT>
+		iterator emplace(const_iterator pos, ArgsT &&...args)
+		{
+			std::size_t offset = pos - m_data;
+			if (offset == m_size)
+			{
+				emplace_back(std::forward<ArgsT>(args)...);
+				return m_data + offset;
+			}
+			T val(std::forward<ArgsT>(args)...);
+			T *slot = open_gap(offset, 1);
+			::new (slot) T(std::move(val));
+			return slot;
+		}
+
+		inline iterator insert(const_iterator pos, const T &val)
+		{
+			return emplace(pos, val);
+		}
+
+		inline iterator insert(const_iterator pos, T &&val)
+		{
+			return emplace(pos, std::move(val));
+		}
+
+		template <typename It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+		iterator insert(const_iterator pos, It first, It last)
+		{
+			std::size_t offset = pos - m_data;
+			vector vals(first, last);
+			T *slot = open_gap(offset, vals.m_size);
+			relocator<T>::relocate(vals.m_data, slot, vals.m_size);
+			vals.m_size = 0;
+			return slot;
+		}
+
+		iterator erase(const_iterator pos) noexcept
+		{
+			return erase(pos, pos + 1);
+		}
+
+		iterator erase(const_iterator first, const_iterator last) noexcept
+		{
+			std::size_t offset = first - m_data, count = last - first;
+			destroy_range(offset, offset + count);
+			close_gap(offset, count);
+			return m_data + offset;
+		}
+
+		inline T &at(std::size_t index)
+		{
+			if (index >= m_size)
+				throw std::out_of_range("cs::vector::at");
+			return m_data[index];
+		}
+
+		inline const T &at(std::size_t index) const
+		{
+			if (index >= m_size)
+				throw std::out_of_range("cs::vector::at");
+			return m_data[index];
+		}
+
+		inline T &operator[](std::size_t index) noexcept
+		{
+			return m_data[index];
+		}
+
+		inline const T &operator[](std::size_t index) const noexcept
+		{
+			return m_data[index];
+		}
+
+		inline T &front() noexcept
+		{
+			return m_data[0];
+		}
+
+		inline const T &front() const noexcept
+		{
+			return m_data[0];
+		}
+
+		inline T &back() noexcept
+		{
+			return m_data[m_size - 1];
+		}
+
+		inline const T &back() const noexcept
+		{
+			return m_data[m_size - 1];
+		}
+
+		inline T *data() noexcept
+		{
+			return m_data;
+		}
+
+		inline const T *data() const noexcept
+		{
+			return m_data;
+		}
+
+		iterator begin() noexcept
+		{
+			return m_data;
+		}
+
+		const_iterator begin() const noexcept
+		{
+			return m_data;
+		}
+
+		iterator end() noexcept
+		{
+			return m_data + m_size;
+		}
+
+		const_iterator end() const noexcept
+		{
+			return m_data + m_size;
+		}
+
+		reverse_iterator rbegin() noexcept
+		{
+			return reverse_iterator(end());
+		}
+
+		const_reverse_iterator rbegin() const noexcept
+		{
+			return const_reverse_iterator(end());
+		}
+
+		reverse_iterator rend() noexcept
+		{
+			return reverse_iterator(begin());
+		}
+
+		const_reverse_iterator rend() const noexcept
+		{
+			return const_reverse_iterator(begin());
+		}
+
+		bool operator==(const vector &other) const
+		{
+			return m_size == other.m_size && std::equal(begin(), end(), other.begin());
+		}
+
+		bool operator!=(const vector &other) const
+		{
+			return !(*this == other);
+		}
+	};
+
 	template <typename T>
 	class stack final
 	{
-		std::vector<T> m_impl;
+		vector<T> m_impl;
 
 	   public:
-		using iterator = typename std::vector<T>::reverse_iterator;
-		using const_iterator = typename std::vector<T>::const_reverse_iterator;
+		using iterator = typename vector<T>::reverse_iterator;
+		using const_iterator = typename vector<T>::const_reverse_iterator;
 
 		void resize(std::size_t size)
 		{
@@ -143,6 +672,244 @@ namespace cs
 		}
 	};
 
+	/*
+	 * Stack of fixed size segments
+	 * Elements never move once pushed, so references stay valid until the element is popped,
+	 * and growing past the capacity allocates one segment instead of relocating every element.
+	 * One empty segment above the top is kept, so pushing and popping across a boundary does not thrash.
+	 */
+	template <typename T, std::size_t segment_size = COVSCRIPT_STACK_SEGMENT_SIZE>
+	class segmented_stack final
+	{
+		static_assert(segment_size > 0 && (segment_size & (segment_size - 1)) == 0, "segment_size must be a power of two.");
+
+		std::allocator<T> m_alloc;
+		std::vector<T *> m_segments;
+		std::size_t m_size = 0;
+		// Segments reserved by resize are never released
+		std::size_t m_reserved = 0;
+
+		T *slot(std::size_t index) const noexcept
+		{
+			return m_segments[index / segment_size] + index % segment_size;
+		}
+
+		void add_segment()
+		{
+			m_segments.push_back(nullptr);
+			try
+			{
+				m_segments.back() = m_alloc.allocate(segment_size);
+			}
+			catch (...)
+			{
+				m_segments.pop_back();
+				throw;
+			}
+		}
+
+		void release_segments(std::size_t keep) noexcept
+		{
+			while (m_segments.size() > keep)
+			{
+				m_alloc.deallocate(m_segments.back(), segment_size);
+				m_segments.pop_back();
+			}
+		}
+
+		template <typename value_t>
+		class basic_iterator final
+		{
+			friend class segmented_stack;
+			const segmented_stack *m_stack = nullptr;
+			// Count of elements from the bottom up to and including this one
+			std::size_t m_pos = 0;
+
+			basic_iterator(const segmented_stack *stack, std::size_t pos) noexcept : m_stack(stack), m_pos(pos) {}
+
+		   public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = value_t *;
+			using reference = value_t &;
+
+			basic_iterator() noexcept = default;
+
+			reference operator*() const noexcept
+			{
+				return *m_stack->slot(m_pos - 1);
+			}
+
+			pointer operator->() const noexcept
+			{
+				return m_stack->slot(m_pos - 1);
+			}
+
+			basic_iterator &operator++() noexcept
+			{
+				--m_pos;
+				return *this;
+			}
+
+			basic_iterator operator++(int) noexcept
+			{
+				basic_iterator it = *this;
+				--m_pos;
+				return it;
+			}
+
+			bool operator==(const basic_iterator &other) const noexcept
+			{
+				return m_pos == other.m_pos;
+			}
+
+			bool operator!=(const basic_iterator &other) const noexcept
+			{
+				return m_pos != other.m_pos;
+			}
+		};
+
+	   public:
+		// From the top to the bottom, as cs::stack
+		using iterator = basic_iterator<T>;
+		using const_iterator = basic_iterator<const T>;
+
+		segmented_stack()
+		{
+			resize(COVSCRIPT_STACK_PRESERVE);
+		}
+
+		explicit segmented_stack(std::size_t s)
+		{
+			resize(s);
+		}
+
+		segmented_stack(const segmented_stack &) = delete;
+
+		segmented_stack &operator=(const segmented_stack &) = delete;
+
+		~segmented_stack()
+		{
+			clear();
+			release_segments(0);
+		}
+
+		// Reserves capacity, as cs::stack
+		void resize(std::size_t size)
+		{
+			std::size_t count = (size + segment_size - 1) / segment_size;
+			while (m_segments.size() < count)
+				add_segment();
+			m_reserved = std::max(m_reserved, count);
+		}
+
+		inline bool empty() const noexcept
+		{
+			return m_size == 0;
+		}
+
+		inline std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+
+		inline T &top()
+		{
+			return *slot(m_size - 1);
+		}
+
+		inline const T &top() const
+		{
+			return *slot(m_size - 1);
+		}
+
+		inline T &bottom()
+		{
+			return *slot(0);
+		}
+
+		inline const T &bottom() const
+		{
+			return *slot(0);
+		}
+
+		inline T &index(std::size_t index)
+		{
+			if (index >= m_size)
+				throw std::out_of_range("cs::segmented_stack::index");
+			return *slot(index);
+		}
+
+		inline const T &index(std::size_t index) const
+		{
+			if (index >= m_size)
+				throw std::out_of_range("cs::segmented_stack::index");
+			return *slot(index);
+		}
+
+		inline T &operator[](std::size_t index)
+		{
+			return *slot(index);
+		}
+
+		inline const T &operator[](std::size_t index) const
+		{
+			return *slot(index);
+		}
+
+		template <typename... ArgsT>
+		inline void push(ArgsT &&...args)
+		{
+			if (m_size == m_segments.size() * segment_size)
+				add_segment();
+			::new (slot(m_size)) T(std::forward<ArgsT>(args)...);
+			++m_size;
+		}
+
+		inline T pop()
+		{
+			T data(std::move(top()));
+			pop_no_return();
+			return data;
+		}
+
+		inline void pop_no_return()
+		{
+			slot(--m_size)->~T();
+			// Keeps the segment of the top and one more
+			std::size_t keep = std::max(m_reserved, m_size / segment_size + 2);
+			if (m_segments.size() > keep)
+				release_segments(keep);
+		}
+
+		inline void clear()
+		{
+			while (m_size > 0)
+				slot(--m_size)->~T();
+		}
+
+		iterator begin() noexcept
+		{
+			return iterator(this, m_size);
+		}
+
+		const_iterator begin() const noexcept
+		{
+			return const_iterator(this, m_size);
+		}
+
+		iterator end() noexcept
+		{
+			return iterator(this, 0);
+		}
+
+		const_iterator end() const noexcept
+		{
+			return const_iterator(this, 0);
+		}
+	};
+
 	template <typename T,
 	          std::size_t block_size = COVSCRIPT_BLOCK_ALLOCATOR_SIZE,
 	          template <typename> class allocator_t = std::allocator>
@@ -171,6 +938,9 @@ namespace cs
 
 		inline T *allocate(std::size_t n)
 		{
+#ifdef COVSCRIPT_ALLOC_STATS
+			alloc_stats::record_allocate<T>(n, n == 1 && m_offset > 0);
+#endif
 			if (n == 1 && m_offset > 0)
 				return m_pool[--m_offset];
 			else
@@ -179,6 +949,9 @@ namespace cs
 
 		inline void deallocate(T *ptr, std::size_t n)
 		{
+#ifdef COVSCRIPT_ALLOC_STATS
+			alloc_stats::record_deallocate<T>(n);
+#endif
 			if (n == 1 && m_offset < block_size)
 				m_pool[m_offset++] = ptr;
 			else
@@ -191,6 +964,6 @@ namespace cs
 	using default_allocator = std::allocator<T>;
 #else
 	template <typename T>
-	using default_allocator = allocator_type<T>;
+	using default_allocator = slab_allocator<T>;
 #endif
 } // namespace cs
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include <covscript/types/basic.hpp>
+#include <charconv>
+#include <cstdint>
+#include <vector>
+
+namespace cs
+{
+	/*
+	 * Arbitrary precision integer
+	 * Sign and magnitude, the magnitude is stored as little-endian 32-bit limbs without leading zeros.
+	 * Zero has no limbs and is never negative. numeric_t promotes to it on overflow of integer_t.
+	 */
+	class bigint final
+	{
+		std::vector<std::uint32_t> m_limbs;
+		bool m_negative = false;
+
+		void trim() noexcept;
+
+		static int compare_magnitude(const std::vector<std::uint32_t> &, const std::vector<std::uint32_t> &) noexcept;
+
+		static std::vector<std::uint32_t> add_magnitude(const std::vector<std::uint32_t> &, const std::vector<std::uint32_t> &);
+
+		// The first magnitude must not be less than the second one
+		static std::vector<std::uint32_t> sub_magnitude(const std::vector<std::uint32_t> &, const std::vector<std::uint32_t> &);
+
+	   public:
+		bigint() = default;
+
+		bigint(integer_t val);
+
+		// Decimal digits with optional sign, throws lang_error if malformed
+		static bigint parse(byte_string_view str);
+
+		// Truncating division, remainder has the sign of dividend. Throws lang_error if divided by zero
+		static void divmod(const bigint &lhs, const bigint &rhs, bigint &quot, bigint &rem);
+
+		bool is_zero() const noexcept
+		{
+			return m_limbs.empty();
+		}
+
+		bool is_negative() const noexcept
+		{
+			return m_negative;
+		}
+
+		std::size_t limb_count() const noexcept
+		{
+			return m_limbs.size();
+		}
+
+		bool fits_integer() const noexcept;
+
+		// Saturates if not fits
+		integer_t to_integer() const noexcept;
+
+		template <typename float_type>
+		float_type to_float() const noexcept
+		{
+			float_type val = 0;
+			for (auto it = m_limbs.rbegin(); it != m_limbs.rend(); ++it)
+				val = val * float_type(4294967296.0) + float_type(*it);
+			return m_negative ? -val : val;
+		}
+
+		// Returns negative, zero or positive
+		int compare(const bigint &) const noexcept;
+
+		bigint operator+(const bigint &) const;
+
+		bigint operator-(const bigint &) const;
+
+		bigint operator*(const bigint &) const;
+
+		bigint operator-() const;
+
+		bool operator==(const bigint &rhs) const noexcept
+		{
+			return m_negative == rhs.m_negative && m_limbs == rhs.m_limbs;
+		}
+
+		bool operator!=(const bigint &rhs) const noexcept
+		{
+			return !(*this == rhs);
+		}
+
+		bool operator<(const bigint &rhs) const noexcept
+		{
+			return compare(rhs) < 0;
+		}
+
+		// Decimal digits, fails with value_too_large if the buffer is short
+		std::to_chars_result to_chars(char *first, char *last) const;
+
+		byte_string_t to_string() const;
+	};
+} // namespace cs
@@ -0,0 +1,355 @@
+#pragma once
+#include <covscript/types/variable.hpp>
+#include <cstdint>
+#include <cstring>
+
+namespace cs
+{
+	/*
+	 * NaN-boxed compact value, 8 bytes per value
+	 * Doubles are stored as is with NaN canonicalized, integers fitting in 48 bits, booleans and null
+	 * live in the payload of negative quiet NaNs. Everything else is boxed into a heap allocated var.
+	 */
+	template <std::size_t align_size,
+	          template <typename> class allocator_t = default_allocator>
+	class basic_compact_var final
+	{
+		using var = basic_var<align_size, allocator_t>;
+
+		static allocator_t<var> &get_allocator()
+		{
+			static allocator_t<var> allocator;
+			return allocator;
+		}
+
+		static_assert(sizeof(void *) <= sizeof(std::uint64_t), "Pointer does not fit into compact var.");
+
+		static constexpr std::uint64_t canonical_nan = 0x7FF8000000000000ull;
+		static constexpr std::uint64_t tag_mask = 0xFFFF000000000000ull;
+		static constexpr std::uint64_t payload_mask = 0x0000FFFFFFFFFFFFull;
+		static constexpr std::uint64_t tag_integer = 0xFFF9000000000000ull;
+		static constexpr std::uint64_t tag_boolean = 0xFFFA000000000000ull;
+		static constexpr std::uint64_t tag_null = 0xFFFB000000000000ull;
+		static constexpr std::uint64_t tag_boxed = 0xFFFC000000000000ull;
+
+		static constexpr integer_t immediate_max = (integer_t(1) << 47) - 1;
+		static constexpr integer_t immediate_min = -(integer_t(1) << 47);
+
+		std::uint64_t m_bits = tag_null;
+
+		static inline std::uint64_t double_bits(double val) noexcept
+		{
+			if (val != val)
+				return canonical_nan;
+			std::uint64_t bits;
+			std::memcpy(&bits, &val, sizeof(bits));
+			return bits;
+		}
+
+		inline std::uint64_t tag_bits() const noexcept
+		{
+			return m_bits & tag_mask;
+		}
+
+		inline bool is_double() const noexcept
+		{
+			return m_bits < tag_integer;
+		}
+
+		inline double unchecked_double() const noexcept
+		{
+			double val;
+			std::memcpy(&val, &m_bits, sizeof(val));
+			return val;
+		}
+
+		inline integer_t unchecked_integer() const noexcept
+		{
+			// Sign extension of the 48 bits payload
+			return static_cast<integer_t>(m_bits << 16) >> 16;
+		}
+
+		inline var *unchecked_boxed() const noexcept
+		{
+			return reinterpret_cast<var *>(static_cast<std::uintptr_t>(m_bits & payload_mask));
+		}
+
+		template <typename... ArgsT>
+		void box(ArgsT &&...args)
+		{
+			var *ptr = get_allocator().allocate(1);
+			::new (ptr) var(std::forward<ArgsT>(args)...);
+			std::uint64_t addr = reinterpret_cast<std::uintptr_t>(ptr);
+			if ((addr & tag_mask) != 0)
+			{
+				ptr->~var();
+				get_allocator().deallocate(ptr, 1);
+				throw internal_error("Pointer out of range of compact var.");
+			}
+			m_bits = tag_boxed | addr;
+		}
+
+		void assign_numeric(const numeric_t &num)
+		{
+			if (num.is_integer())
+			{
+				integer_t val = num.as_integer();
+				if (val >= immediate_min && val <= immediate_max)
+					m_bits = tag_integer | (static_cast<std::uint64_t>(val) & payload_mask);
+				else
+					box(var::template make<numeric_t>(num));
+			}
+			else
+			{
+				float_t val = num.as_float();
+				double dval = static_cast<double>(val);
+				if (static_cast<float_t>(dval) == val || val != val)
+					m_bits = double_bits(dval);
+				else
+					box(var::template make<numeric_t>(num));
+			}
+		}
+
+		void assign_var(const var &val)
+		{
+			switch (val.tag())
+			{
+				case var_tag::null:
+					m_bits = tag_null;
+					break;
+				case var_tag::numeric:
+					assign_numeric(val.template const_val<numeric_t>());
+					break;
+				case var_tag::boolean:
+					m_bits = tag_boolean | val.template const_val<bool_t>();
+					break;
+				default:
+					box(val);
+					break;
+			}
+		}
+
+		void assign_var(var &&val)
+		{
+			switch (val.tag())
+			{
+				case var_tag::null:
+				case var_tag::numeric:
+				case var_tag::boolean:
+					assign_var(static_cast<const var &>(val));
+					break;
+				default:
+					box(std::move(val));
+					break;
+			}
+		}
+
+		void destroy() noexcept
+		{
+			if (is_boxed())
+			{
+				var *ptr = unchecked_boxed();
+				ptr->~var();
+				get_allocator().deallocate(ptr, 1);
+			}
+			m_bits = tag_null;
+		}
+
+	   public:
+		basic_compact_var() noexcept = default;
+
+		basic_compact_var(const numeric_t &num)
+		{
+			assign_numeric(num);
+		}
+
+		template <typename T, typename = std::enable_if_t<std::is_same_v<T, bool_t>>>
+		basic_compact_var(T val) noexcept : m_bits(tag_boolean | val) {}
+
+		basic_compact_var(const var &val)
+		{
+			assign_var(val);
+		}
+
+		basic_compact_var(var &&val)
+		{
+			assign_var(std::move(val));
+		}
+
+		basic_compact_var(const basic_compact_var &other)
+		{
+			if (other.is_boxed())
+				box(*other.unchecked_boxed());
+			else
+				m_bits = other.m_bits;
+		}
+
+		basic_compact_var(basic_compact_var &&other) noexcept : m_bits(other.m_bits)
+		{
+			other.m_bits = tag_null;
+		}
+
+		~basic_compact_var()
+		{
+			destroy();
+		}
+
+		basic_compact_var &operator=(const basic_compact_var &other)
+		{
+			if (this != &other)
+			{
+				destroy();
+				if (other.is_boxed())
+					box(*other.unchecked_boxed());
+				else
+					m_bits = other.m_bits;
+			}
+			return *this;
+		}
+
+		basic_compact_var &operator=(basic_compact_var &&other) noexcept
+		{
+			if (this != &other)
+			{
+				destroy();
+				m_bits = other.m_bits;
+				other.m_bits = tag_null;
+			}
+			return *this;
+		}
+
+		void swap(basic_compact_var &other) noexcept
+		{
+			std::swap(m_bits, other.m_bits);
+		}
+
+		inline bool is_null() const noexcept
+		{
+			return m_bits == tag_null;
+		}
+
+		inline bool is_boxed() const noexcept
+		{
+			return tag_bits() == tag_boxed;
+		}
+
+		var_tag tag() const noexcept
+		{
+			if (is_double())
+				return var_tag::numeric;
+			switch (tag_bits())
+			{
+				case tag_integer:
+					return var_tag::numeric;
+				case tag_boolean:
+					return var_tag::boolean;
+				case tag_boxed:
+					return unchecked_boxed()->tag();
+				default:
+					return var_tag::null;
+			}
+		}
+
+		numeric_t as_numeric() const
+		{
+			if (is_double())
+				return static_cast<float_t>(unchecked_double());
+			switch (tag_bits())
+			{
+				case tag_integer:
+					return unchecked_integer();
+				case tag_boxed:
+					return unchecked_boxed()->template const_val<numeric_t>();
+				case tag_null:
+					throw runtime_error("Instance null variable.");
+				default:
+					throw runtime_error("Instance compact variable with wrong type. Expected numeric.");
+			}
+		}
+
+		bool_t as_bool() const
+		{
+			switch (tag_bits())
+			{
+				case tag_boolean:
+					return m_bits & 1;
+				case tag_boxed:
+					return unchecked_boxed()->template const_val<bool_t>();
+				case tag_null:
+					throw runtime_error("Instance null variable.");
+				default:
+					throw runtime_error("Instance compact variable with wrong type. Expected boolean.");
+			}
+		}
+
+		// Boxed variable, nullptr for immediate values
+		const var *boxed() const noexcept
+		{
+			return is_boxed() ? unchecked_boxed() : nullptr;
+		}
+
+		var *boxed() noexcept
+		{
+			return is_boxed() ? unchecked_boxed() : nullptr;
+		}
+
+		var to_var() const
+		{
+			if (is_double())
+				return var::template make<numeric_t>(static_cast<float_t>(unchecked_double()));
+			switch (tag_bits())
+			{
+				case tag_integer:
+					return var::template make<numeric_t>(unchecked_integer());
+				case tag_boolean:
+					return var::template make<bool_t>(m_bits & 1);
+				case tag_boxed:
+					return *unchecked_boxed();
+				default:
+					return var();
+			}
+		}
+
+		std::size_t hash() const
+		{
+			if (is_boxed())
+				return unchecked_boxed()->hash();
+			else
+				return to_var().hash();
+		}
+
+		void gc_mark_reachable() const
+		{
+			if (is_boxed())
+				unchecked_boxed()->gc_mark_reachable();
+		}
+
+		bool compare(const basic_compact_var &other) const
+		{
+			// Identical bits of immediate values, NaN is canonical but never equal to itself
+			if (m_bits == other.m_bits && !is_boxed())
+				return m_bits != canonical_nan;
+			if (is_boxed() && other.is_boxed())
+				return unchecked_boxed()->compare(*other.unchecked_boxed());
+			var_tag lhs_tag = tag();
+			if (lhs_tag != other.tag())
+				return false;
+			if (lhs_tag == var_tag::numeric)
+				return as_numeric() == other.as_numeric();
+			else
+				return false;
+		}
+
+		bool operator==(const basic_compact_var &other) const
+		{
+			return compare(other);
+		}
+
+		bool operator!=(const basic_compact_var &other) const
+		{
+			return !compare(other);
+		}
+	};
+
+	using compact_var = basic_compact_var<COVSCRIPT_SVO_ALIGN_SIZE, default_allocator>;
+} // namespace cs
@@ -1,396 +1,825 @@
 #pragma once
 #include <covscript/types/basic.hpp>
+#include <covscript/types/bigint.hpp>
 #include <type_traits>
+#include <functional>
+#include <charconv>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <string>
+#include <cmath>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
 namespace cs
 {
-	class numeric_t final
+	namespace numeric_detail
+	{
+		// Overflow checked integer arithmetic, returns true if overflowed
+		inline bool add_overflow(integer_t lhs, integer_t rhs, integer_t *res) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return __builtin_add_overflow(lhs, rhs, res);
+#else
+			if ((rhs > 0 && lhs > INT64_MAX - rhs) || (rhs < 0 && lhs < INT64_MIN - rhs))
+				return true;
+			*res = lhs + rhs;
+			return false;
+#endif
+		}
+
+		inline bool sub_overflow(integer_t lhs, integer_t rhs, integer_t *res) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return __builtin_sub_overflow(lhs, rhs, res);
+#else
+			if ((rhs < 0 && lhs > INT64_MAX + rhs) || (rhs > 0 && lhs < INT64_MIN + rhs))
+				return true;
+			*res = lhs - rhs;
+			return false;
+#endif
+		}
+
+		inline bool mul_overflow(integer_t lhs, integer_t rhs, integer_t *res) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return __builtin_mul_overflow(lhs, rhs, res);
+#else
+			if (lhs > 0 ? (rhs > 0 ? lhs > INT64_MAX / rhs : rhs < INT64_MIN / lhs)
+			            : (rhs > 0 ? lhs < INT64_MIN / rhs : lhs != 0 && rhs < INT64_MAX / lhs))
+				return true;
+			*res = lhs * rhs;
+			return false;
+#endif
+		}
+
+		// Exponentiation by squaring, exp must not be negative. Returns true if overflowed
+		inline bool pow_overflow(integer_t base, integer_t exp, integer_t *res) noexcept
+		{
+			integer_t result = 1;
+			for (;;)
+			{
+				if ((exp & 1) && mul_overflow(result, base, &result))
+					return true;
+				exp >>= 1;
+				if (exp == 0)
+					break;
+				// Remaining bits need at least the square, so overflow here means overflow of result
+				if (mul_overflow(base, base, &base))
+					return true;
+			}
+			*res = result;
+			return false;
+		}
+
+		// High half of the full 64x64 bits signed multiplication
+		inline integer_t mul_high(integer_t lhs, integer_t rhs) noexcept
+		{
+#if defined(__SIZEOF_INT128__)
+			return static_cast<integer_t>((static_cast<__int128_t>(lhs) * rhs) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+			return __mulh(lhs, rhs);
+#else
+			std::uint64_t a = lhs, b = rhs;
+			std::uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<std::uint32_t>(a), lb = static_cast<std::uint32_t>(b);
+			std::uint64_t rl = la * lb, rm0 = ha * lb, rm1 = la * hb;
+			std::uint64_t mid = (rl >> 32) + static_cast<std::uint32_t>(rm0) + static_cast<std::uint32_t>(rm1);
+			std::uint64_t hi = ha * hb + (rm0 >> 32) + (rm1 >> 32) + (mid >> 32);
+			// Unsigned to signed correction
+			hi -= (lhs < 0 ? b : 0) + (rhs < 0 ? a : 0);
+			return static_cast<integer_t>(hi);
+#endif
+		}
+	} // namespace numeric_detail
+
+	/*
+	 * Division by an invariant integer: the divisor is turned into a magic multiplier and a shift
+	 * once, then every quotient costs a multiplication instead of a hardware division.
+	 * Worth it when the same divisor is used in a loop, truncates like the builtin operators.
+	 */
+	class integer_divisor final
+	{
+		static constexpr std::uint8_t shift_mask = 0x3F, add_marker = 0x40, negative_divisor = 0x80;
+
+		integer_t m_divisor = 1;
+		integer_t m_magic = 0;
+		std::uint8_t m_more = 0;
+
+	   public:
+		integer_divisor() = default;
+
+		// Throws lang_error if divisor is zero
+		explicit integer_divisor(integer_t divisor);
+
+		integer_t divisor() const noexcept
+		{
+			return m_divisor;
+		}
+
+		// Quotient of INT64_MIN by -1 wraps around
+		integer_t quot(integer_t numer) const noexcept
+		{
+			std::uint8_t shift = m_more & shift_mask;
+			integer_t sign = static_cast<std::int8_t>(m_more) >> 7;
+			if (m_magic == 0)
+			{
+				// Power of two, round towards zero before the arithmetic shift
+				std::uint64_t mask = (std::uint64_t(1) << shift) - 1;
+				integer_t q = static_cast<integer_t>(static_cast<std::uint64_t>(numer) + (static_cast<std::uint64_t>(numer >> 63) & mask)) >> shift;
+				return static_cast<integer_t>((static_cast<std::uint64_t>(q) ^ sign) - sign);
+			}
+			integer_t q = numeric_detail::mul_high(m_magic, numer);
+			if (m_more & add_marker)
+				q = static_cast<integer_t>(static_cast<std::uint64_t>(q) + ((static_cast<std::uint64_t>(numer) ^ sign) - sign));
+			q >>= shift;
+			return q + (q < 0);
+		}
+
+		// Remainder has the sign of numer
+		integer_t rem(integer_t numer) const noexcept
+		{
+			return static_cast<integer_t>(static_cast<std::uint64_t>(numer) - static_cast<std::uint64_t>(quot(numer)) * static_cast<std::uint64_t>(m_divisor));
+		}
+	};
+
+	/*
+	 * Precision policy: float_type is the backing of floating values, double or long double
+	 * Integers are kept in integer_t and promoted to shared immutable bigint on overflow,
+	 * results of bigint arithmetic are demoted back as soon as they fit.
+	 */
+	template <typename float_type>
+	class basic_numeric final
 	{
+		struct big_block
+		{
+			std::atomic<std::size_t> ref_count;
+			bigint value;
+
+			explicit big_block(bigint &&val) : ref_count(1), value(std::move(val)) {}
+		};
+
 		union
 		{
-			float_t _num;
+			float_type _num;
 			integer_t _int;
+			big_block *_big;
 		} data;
-		bool type = 1;
 
-		inline static std::uint8_t get_composite_type(bool lhs, bool rhs) noexcept
+		static constexpr std::uint8_t kind_float = 0, kind_integer = 1, kind_big = 2;
+		std::uint8_t type = kind_integer;
+
+		enum class arith_op
 		{
-			return lhs << 1 | rhs;
+			add,
+			sub,
+			mul,
+			div,
+			mod,
+			pow
+		};
+
+		// Kinds take two bits, composites other than float and integer involve a bigint
+		inline static std::uint8_t get_composite_type(std::uint8_t lhs, std::uint8_t rhs) noexcept
+		{
+			return lhs << 2 | rhs;
+		}
+
+		void release() noexcept
+		{
+			if (type == kind_big && data._big->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				delete data._big;
 		}
 
+		// Slow paths, defined in sources/types/numeric.cpp. Operands are passed by value
+		// so the fast paths never take address of them and keep them in registers
+		static basic_numeric arith_slow(arith_op, basic_numeric, basic_numeric);
+
+		// Exact integer powers are computed as bigint up to this many bits, floats take over beyond
+		static constexpr double max_pow_bits = 1 << 16;
+
+		static basic_numeric pow_slow(const basic_numeric &, const basic_numeric &);
+
+		// Returns -1, 0 or 1, and 2 if unordered
+		static int compare_slow(basic_numeric, basic_numeric) noexcept;
+
 	   public:
-		numeric_t()
+		using value_type = float_type;
+
+		basic_numeric()
 		{
 			data._int = 0;
 		}
 
-		numeric_t(float_t num)
+		template <typename T, typename = std::enable_if_t<std::is_floating_point<T>::value>>
+		basic_numeric(T num)
 		{
-			type = 0;
+			type = kind_float;
 			data._num = num;
 		}
 
-		numeric_t(integer_t num)
+		basic_numeric(integer_t num)
 		{
-			type = 1;
+			type = kind_integer;
 			data._int = num;
 		}
 
-		numeric_t(const numeric_t &rhs) : data(rhs.data), type(rhs.type) {}
+		explicit basic_numeric(bigint num)
+		{
+			if (num.fits_integer())
+				data._int = num.to_integer();
+			else
+			{
+				type = kind_big;
+				data._big = new big_block(std::move(num));
+			}
+		}
+
+		// Copies of bigints share the immutable payload
+		basic_numeric(const basic_numeric &other) noexcept : data(other.data), type(other.type)
+		{
+			if (type == kind_big)
+				data._big->ref_count.fetch_add(1, std::memory_order_relaxed);
+		}
 
-		numeric_t(numeric_t &&rhs) noexcept : data(rhs.data), type(rhs.type) {}
+		basic_numeric(basic_numeric &&other) noexcept : data(other.data), type(other.type)
+		{
+			other.type = kind_integer;
+			other.data._int = 0;
+		}
 
-		~numeric_t() = default;
+		~basic_numeric()
+		{
+			release();
+		}
 
-		numeric_t operator+(const numeric_t &rhs) const noexcept
+		basic_numeric operator+(const basic_numeric &rhs) const
 		{
+			integer_t res;
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num + rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num + rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int + rhs.data._num;
-				case 0b11:
-					return data._int + rhs.data._int;
+				case 0b0101:
+					if (!numeric_detail::add_overflow(data._int, rhs.data._int, &res))
+						return res;
+					[[fallthrough]];
+				default:
+					return arith_slow(arith_op::add, *this, rhs);
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
-		numeric_t operator+(T &&rhs) const noexcept
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
+		basic_numeric operator+(T &&rhs) const
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this + basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int + rhs;
 			else
-				return data._num + rhs;
+				return as_float() + rhs;
 		}
 
-		numeric_t operator-(const numeric_t &rhs) const noexcept
+		basic_numeric operator-(const basic_numeric &rhs) const
 		{
+			integer_t res;
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num - rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num - rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int - rhs.data._num;
-				case 0b11:
-					return data._int - rhs.data._int;
+				case 0b0101:
+					if (!numeric_detail::sub_overflow(data._int, rhs.data._int, &res))
+						return res;
+					[[fallthrough]];
+				default:
+					return arith_slow(arith_op::sub, *this, rhs);
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
-		numeric_t operator-(T &&rhs) const noexcept
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
+		basic_numeric operator-(T &&rhs) const
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this - basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int - rhs;
 			else
-				return data._num - rhs;
+				return as_float() - rhs;
 		}
 
-		numeric_t operator*(const numeric_t &rhs) const noexcept
+		basic_numeric operator*(const basic_numeric &rhs) const
 		{
+			integer_t res;
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num * rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num * rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int * rhs.data._num;
-				case 0b11:
-					return data._int * rhs.data._int;
+				case 0b0101:
+					if (!numeric_detail::mul_overflow(data._int, rhs.data._int, &res))
+						return res;
+					[[fallthrough]];
+				default:
+					return arith_slow(arith_op::mul, *this, rhs);
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
-		numeric_t operator*(T &&rhs) const noexcept
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
+		basic_numeric operator*(T &&rhs) const
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this * basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int * rhs;
 			else
-				return data._num * rhs;
+				return as_float() * rhs;
 		}
 
-		numeric_t operator/(const numeric_t &rhs) const noexcept
+		basic_numeric operator/(const basic_numeric &rhs) const
 		{
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num / rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num / rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int / rhs.data._num;
-				case 0b11:
-					std::lldiv_t divres = std::lldiv(data._int, rhs.data._int);
-					if (divres.rem == 0)
-						return divres.quot;
+				case 0b0101:
+					if (rhs.data._int == 0)
+					{
+						// Infinity or NaN as floats give, same as the remainder by zero
+						return static_cast<float_type>(data._int) / static_cast<float_type>(0);
+					}
+					else if (rhs.data._int != -1)
+					{
+						std::lldiv_t divres = std::lldiv(data._int, rhs.data._int);
+						if (divres.rem == 0)
+							return divres.quot;
+						else
+							return static_cast<float_type>(data._int) / rhs.data._int;
+					}
 					else
-						return static_cast<float_t>(data._int) / rhs.data._int;
+						return -*this;
+				default:
+					return arith_slow(arith_op::div, *this, rhs);
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
-		numeric_t operator/(T &&rhs) const noexcept
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
+		basic_numeric operator/(T &&rhs) const
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this / basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int / rhs;
 			else
-				return data._num / rhs;
+				return as_float() / rhs;
 		}
 
-		numeric_t &operator=(const numeric_t &num)
+		// Truncated remainder like fmod, the result has the sign of lhs
+		basic_numeric operator%(const basic_numeric &rhs) const
 		{
-			if (this != &num)
+			switch (get_composite_type(type, rhs.type))
 			{
-				data = num.data;
-				type = num.type;
+				case 0b0000:
+					return std::fmod(data._num, rhs.data._num);
+				case 0b0001:
+					return std::fmod(data._num, static_cast<float_type>(rhs.data._int));
+				case 0b0100:
+					return std::fmod(static_cast<float_type>(data._int), rhs.data._num);
+				case 0b0101:
+					if (rhs.data._int == -1)
+						return integer_t(0);
+					else if (rhs.data._int != 0)
+						return data._int % rhs.data._int;
+					[[fallthrough]];
+				default:
+					return arith_slow(arith_op::mod, *this, rhs);
+			}
+		}
+
+		template <typename T, typename = std::enable_if_t<std::is_arithmetic<std::decay_t<T>>::value>>
+		basic_numeric operator%(T &&rhs) const
+		{
+			return *this % basic_numeric(rhs);
+		}
+
+		// Power as in scripts, not xor. Beware of the precedence in C++, lower than comparisons
+		basic_numeric operator^(const basic_numeric &rhs) const
+		{
+			integer_t res;
+			switch (get_composite_type(type, rhs.type))
+			{
+				case 0b0000:
+					return std::pow(data._num, rhs.data._num);
+				case 0b0001:
+					return std::pow(data._num, static_cast<float_type>(rhs.data._int));
+				case 0b0100:
+					return std::pow(static_cast<float_type>(data._int), rhs.data._num);
+				case 0b0101:
+					if (rhs.data._int >= 0 && !numeric_detail::pow_overflow(data._int, rhs.data._int, &res))
+						return res;
+					[[fallthrough]];
+				default:
+					return arith_slow(arith_op::pow, *this, rhs);
+			}
+		}
+
+		template <typename T, typename = std::enable_if_t<std::is_arithmetic<std::decay_t<T>>::value>>
+		basic_numeric operator^(T &&rhs) const
+		{
+			return *this ^ basic_numeric(rhs);
+		}
+
+		basic_numeric &operator=(const basic_numeric &other) noexcept
+		{
+			if (&other != this)
+			{
+				if (other.type == kind_big)
+					other.data._big->ref_count.fetch_add(1, std::memory_order_relaxed);
+				release();
+				data = other.data;
+				type = other.type;
+			}
+			return *this;
+		}
+
+		basic_numeric &operator=(basic_numeric &&other) noexcept
+		{
+			if (&other != this)
+			{
+				release();
+				data = other.data;
+				type = other.type;
+				other.type = kind_integer;
+				other.data._int = 0;
 			}
 			return *this;
 		}
 
-		numeric_t &operator=(float_t num)
+		template <typename T, typename = std::enable_if_t<std::is_floating_point<T>::value>>
+		basic_numeric &operator=(T num)
 		{
-			type = 0;
+			release();
+			type = kind_float;
 			data._num = num;
 			return *this;
 		}
 
-		numeric_t &operator=(integer_t num)
+		basic_numeric &operator=(integer_t num)
 		{
-			type = 1;
+			release();
+			type = kind_integer;
 			data._int = num;
 			return *this;
 		}
 
-		bool operator<(const numeric_t &rhs) const noexcept
+		bool operator<(const basic_numeric &rhs) const noexcept
 		{
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num < rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num < rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int < rhs.data._num;
-				case 0b11:
+				case 0b0101:
 					return data._int < rhs.data._int;
+				default:
+				{
+					int c = compare_slow(*this, rhs);
+					return c == -1;
+				}
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
 		bool operator<(T &&rhs) const noexcept
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this < basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int < rhs;
 			else
-				return data._num < rhs;
+				return as_float() < rhs;
 		}
 
-		bool operator<=(const numeric_t &rhs) const noexcept
+		bool operator<=(const basic_numeric &rhs) const noexcept
 		{
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num <= rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num <= rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int <= rhs.data._num;
-				case 0b11:
+				case 0b0101:
 					return data._int <= rhs.data._int;
+				default:
+				{
+					int c = compare_slow(*this, rhs);
+					return c == -1 || c == 0;
+				}
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
 		bool operator<=(T &&rhs) const noexcept
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this <= basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int <= rhs;
 			else
-				return data._num <= rhs;
+				return as_float() <= rhs;
 		}
 
-		bool operator>(const numeric_t &rhs) const noexcept
+		bool operator>(const basic_numeric &rhs) const noexcept
 		{
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num > rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num > rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int > rhs.data._num;
-				case 0b11:
+				case 0b0101:
 					return data._int > rhs.data._int;
+				default:
+				{
+					int c = compare_slow(*this, rhs);
+					return c == 1;
+				}
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
 		bool operator>(T &&rhs) const noexcept
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this > basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int > rhs;
 			else
-				return data._num > rhs;
+				return as_float() > rhs;
 		}
 
-		bool operator>=(const numeric_t &rhs) const noexcept
+		bool operator>=(const basic_numeric &rhs) const noexcept
 		{
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num >= rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num >= rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int >= rhs.data._num;
-				case 0b11:
+				case 0b0101:
 					return data._int >= rhs.data._int;
+				default:
+				{
+					int c = compare_slow(*this, rhs);
+					return c == 1 || c == 0;
+				}
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
 		bool operator>=(T &&rhs) const noexcept
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this >= basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int >= rhs;
 			else
-				return data._num >= rhs;
+				return as_float() >= rhs;
 		}
 
-		bool operator==(const numeric_t &rhs) const noexcept
+		bool operator==(const basic_numeric &rhs) const noexcept
 		{
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num == rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num == rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int == rhs.data._num;
-				case 0b11:
+				case 0b0101:
 					return data._int == rhs.data._int;
+				default:
+				{
+					int c = compare_slow(*this, rhs);
+					return c == 0;
+				}
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
 		bool operator==(T &&rhs) const noexcept
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this == basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int == rhs;
 			else
-				return data._num == rhs;
+				return as_float() == rhs;
 		}
 
-		bool operator!=(const numeric_t &rhs) const noexcept
+		bool operator!=(const basic_numeric &rhs) const noexcept
 		{
 			switch (get_composite_type(type, rhs.type))
 			{
-				default:
-				case 0b00:
+				case 0b0000:
 					return data._num != rhs.data._num;
-				case 0b01:
+				case 0b0001:
 					return data._num != rhs.data._int;
-				case 0b10:
+				case 0b0100:
 					return data._int != rhs.data._num;
-				case 0b11:
+				case 0b0101:
 					return data._int != rhs.data._int;
+				default:
+				{
+					int c = compare_slow(*this, rhs);
+					return c != 0;
+				}
 			}
 		}
 
-		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, numeric_t>::value>>
+		template <typename T, typename = std::enable_if_t<!std::is_same<std::decay_t<T>, basic_numeric>::value>>
 		bool operator!=(T &&rhs) const noexcept
 		{
-			if (type)
+			if constexpr (std::is_arithmetic<std::decay_t<T>>::value)
+				return *this != basic_numeric(rhs);
+			else if (type == kind_integer)
 				return data._int != rhs;
 			else
-				return data._num != rhs;
+				return as_float() != rhs;
 		}
 
-		numeric_t &operator++() noexcept
+		basic_numeric &operator++()
 		{
-			if (type)
+			if (type == kind_float)
+				++data._num;
+			else if (type == kind_integer && data._int != INT64_MAX)
 				++data._int;
 			else
-				++data._num;
+				*this = *this + basic_numeric(integer_t(1));
 			return *this;
 		}
 
-		numeric_t &operator--() noexcept
+		basic_numeric &operator--()
 		{
-			if (type)
+			if (type == kind_float)
+				--data._num;
+			else if (type == kind_integer && data._int != INT64_MIN)
 				--data._int;
 			else
-				--data._num;
+				*this = *this - basic_numeric(integer_t(1));
 			return *this;
 		}
 
-		numeric_t operator++(int) noexcept
+		basic_numeric operator++(int)
 		{
-			if (type)
-				return data._int++;
-			else
-				return data._num++;
+			basic_numeric old(*this);
+			++*this;
+			return old;
 		}
 
-		numeric_t operator--(int) noexcept
+		basic_numeric operator--(int)
 		{
-			if (type)
-				return data._int--;
-			else
-				return data._num--;
+			basic_numeric old(*this);
+			--*this;
+			return old;
 		}
 
-		numeric_t operator-() const noexcept
+		basic_numeric operator-() const
 		{
-			if (type)
+			if (type == kind_float)
+				return -data._num;
+			else if (type == kind_integer && data._int != INT64_MIN)
 				return -data._int;
 			else
-				return -data._num;
+				return basic_numeric(-to_bigint());
 		}
 
 		bool is_integer() const noexcept
 		{
-			return type;
+			return type != kind_float;
 		}
 
 		bool is_float() const noexcept
 		{
-			return !type;
+			return type == kind_float;
 		}
 
+		// Integer not fits in integer_t
+		bool is_big() const noexcept
+		{
+			return type == kind_big;
+		}
+
+		// Saturates if the value is a bigint
 		integer_t as_integer() const noexcept
 		{
-			if (type)
+			if (type == kind_integer)
 				return data._int;
-			else
+			else if (type == kind_float)
 				return data._num;
+			else
+				return data._big->value.to_integer();
 		}
 
-		float_t as_float() const noexcept
+		float_type as_float() const noexcept
 		{
-			if (type)
+			if (type == kind_integer)
 				return data._int;
-			else
+			else if (type == kind_float)
 				return data._num;
+			else
+				return data._big->value.template to_float<float_type>();
 		}
 
+		// Floats are truncated
+		bigint to_bigint() const
+		{
+			if (type == kind_big)
+				return data._big->value;
+			else
+				return bigint(as_integer());
+		}
+
+		// Integral floats hash as integers, so numerics comparing equal have same hash.
+		// Bigints compare with floats by conversion, so they hash as their converted floats
+		std::size_t hash() const noexcept
+		{
+			switch (type)
+			{
+				case kind_integer:
+					return std::hash<integer_t>{}(data._int);
+				case kind_big:
+					return std::hash<float_type>{}(as_float());
+				default:
+					break;
+			}
+			constexpr float_type integer_limit = 9223372036854775808.0L;
+			if (data._num >= -integer_limit && data._num < integer_limit)
+			{
+				integer_t val = static_cast<integer_t>(data._num);
+				if (static_cast<float_type>(val) == data._num)
+					return std::hash<integer_t>{}(val);
+			}
+			return std::hash<float_type>{}(data._num);
+		}
+
+		// Enough for any integer_t or float in shortest form, bigints may need more
+		static constexpr std::size_t max_chars = 64;
+
+		// Shortest text that parses back to the same value, fails with value_too_large if the buffer is short
+		std::to_chars_result to_chars(char *first, char *last) const;
+
+		// Integer if there is no fraction or exponent, promoted to bigint if too large. Float otherwise
+		static std::from_chars_result from_chars(const char *first, const char *last, basic_numeric &value);
+
+		// Throws lang_error unless the whole string is a numeric
+		static basic_numeric parse(byte_string_view str);
+
 		byte_string_t to_string() const;
 	};
-} // namespace cs
\ No newline at end of file
+
+	using numeric_t = basic_numeric<float_t>;
+	using double_numeric_t = basic_numeric<double>;
+	using long_double_numeric_t = basic_numeric<long double>;
+
+	extern template class basic_numeric<double>;
+	extern template class basic_numeric<long double>;
+} // namespace cs
+
+namespace std
+{
+	template <typename float_type>
+	struct hash<cs::basic_numeric<float_type>>
+	{
+		std::size_t operator()(const cs::basic_numeric<float_type> &num) const noexcept
+		{
+			return num.hash();
+		}
+	};
+} // namespace std
\ No newline at end of file
@@ -0,0 +1,468 @@
+#pragma once
+#include <covscript/types/basic.hpp>
+#include <covscript/types/string.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <atomic>
+#include <vector>
+
+namespace cs
+{
+	/*
+	 * Immutable rope string
+	 * A rope is a slice (offset and length) of a shared node. Leaves own a flat buffer, concatenation
+	 * nodes only refer to both sides, so slicing is O(1), concatenation is O(log n) and never copies long strings.
+	 * Concatenation nodes are flattened on the first random access and the flat buffer is kept for
+	 * every later access. Nodes are immutable once published, so ropes can be shared between threads.
+	 */
+	template <typename CharT>
+	class basic_rope final
+	{
+	   public:
+		using stl_string = std::basic_string<CharT>;
+		using stl_string_view = std::basic_string_view<CharT>;
+
+		static constexpr std::size_t npos = std::size_t(-1);
+
+		// Concatenations not longer than this are copied into a flat leaf
+		static constexpr std::size_t short_limit = 128;
+
+	   private:
+		struct node;
+
+		node *m_node = nullptr;
+		std::size_t m_offset = 0;
+		std::size_t m_length = 0;
+
+		basic_rope(node *nd, std::size_t offset, std::size_t length) noexcept : m_node(nd), m_offset(offset), m_length(length) {}
+
+		void release() noexcept;
+
+		// Whole content of a node, without flattening
+		bool whole_node() const noexcept;
+
+		// Visit flat pieces of range in order
+		template <typename F>
+		static void visit(const node *nd, std::size_t offset, std::size_t length, F &&func);
+
+		static basic_rope make_concat(const basic_rope &lhs, const basic_rope &rhs);
+
+		// Concatenation keeping depths of both sides of every node within one, like joining AVL trees
+		static basic_rope join(const basic_rope &lhs, const basic_rope &rhs);
+
+		static void collect_leaves(const basic_rope &rope, std::vector<basic_rope> &leaves);
+
+		static basic_rope build_balanced(const basic_rope *first, std::size_t count);
+
+	   public:
+		basic_rope() noexcept = default;
+
+		basic_rope(stl_string str);
+
+		basic_rope(stl_string_view str) : basic_rope(stl_string(str)) {}
+
+		basic_rope(const CharT *str) : basic_rope(stl_string(str)) {}
+
+		basic_rope(const basic_rope &other) noexcept;
+
+		basic_rope(basic_rope &&other) noexcept : m_node(other.m_node), m_offset(other.m_offset), m_length(other.m_length)
+		{
+			other.m_node = nullptr;
+			other.m_offset = other.m_length = 0;
+		}
+
+		~basic_rope()
+		{
+			release();
+		}
+
+		basic_rope &operator=(const basic_rope &other) noexcept
+		{
+			basic_rope(other).swap(*this);
+			return *this;
+		}
+
+		basic_rope &operator=(basic_rope &&other) noexcept
+		{
+			basic_rope(std::move(other)).swap(*this);
+			return *this;
+		}
+
+		void swap(basic_rope &other) noexcept
+		{
+			std::swap(m_node, other.m_node);
+			std::swap(m_offset, other.m_offset);
+			std::swap(m_length, other.m_length);
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_length;
+		}
+
+		std::size_t length() const noexcept
+		{
+			return m_length;
+		}
+
+		bool empty() const noexcept
+		{
+			return m_length == 0;
+		}
+
+		// Whether random access needs no flattening
+		bool is_flat() const noexcept;
+
+		// Levels of concatenation nodes, 0 for leaves
+		std::size_t depth() const noexcept;
+
+		// Shares the buffer, throws std::out_of_range if pos is greater than size
+		basic_rope substr(std::size_t pos, std::size_t len = npos) const;
+
+		friend basic_rope operator+(const basic_rope &lhs, const basic_rope &rhs)
+		{
+			return concat(lhs, rhs);
+		}
+
+		basic_rope &operator+=(const basic_rope &rhs)
+		{
+			*this = concat(*this, rhs);
+			return *this;
+		}
+
+		static basic_rope concat(const basic_rope &lhs, const basic_rope &rhs);
+
+		// Random access, flattens
+		stl_string_view view() const;
+
+		const CharT *data() const
+		{
+			return view().data();
+		}
+
+		CharT operator[](std::size_t idx) const
+		{
+			return view()[idx];
+		}
+
+		CharT at(std::size_t idx) const
+		{
+			if (idx >= m_length)
+				throw std::out_of_range("cs::basic_rope::at");
+			return view()[idx];
+		}
+
+		// Flat pieces in order, never flattens
+		template <typename F>
+		void for_each_piece(F &&func) const
+		{
+			if (m_length > 0)
+				visit(m_node, m_offset, m_length, func);
+		}
+
+		// Copy without flattening
+		stl_string str() const
+		{
+			stl_string res;
+			res.reserve(m_length);
+			for_each_piece([&res](stl_string_view piece) { res.append(piece); });
+			return res;
+		}
+
+		// Borrows the buffer if it is null terminated at end of the slice, copies otherwise
+		basic_string_borrower<CharT> borrow() const
+		{
+			stl_string_view sv = view();
+			if (m_length == 0)
+				return static_cast<const CharT *>(&null_char);
+			else if (m_offset + m_length == m_node->flat.load(std::memory_order_acquire)->size())
+				return sv;
+			else
+				return stl_string(sv);
+		}
+
+		int compare(const basic_rope &other) const
+		{
+			return view().compare(other.view());
+		}
+
+		bool operator==(const basic_rope &other) const
+		{
+			return m_length == other.m_length && (m_length == 0 || (m_node == other.m_node && m_offset == other.m_offset) || view() == other.view());
+		}
+
+		bool operator!=(const basic_rope &other) const
+		{
+			return !(*this == other);
+		}
+
+		bool operator<(const basic_rope &other) const
+		{
+			return compare(other) < 0;
+		}
+
+		bool operator<=(const basic_rope &other) const
+		{
+			return compare(other) <= 0;
+		}
+
+		bool operator>(const basic_rope &other) const
+		{
+			return compare(other) > 0;
+		}
+
+		bool operator>=(const basic_rope &other) const
+		{
+			return compare(other) >= 0;
+		}
+
+	   private:
+		static constexpr CharT null_char = CharT();
+	};
+
+	template <typename CharT>
+	struct basic_rope<CharT>::node
+	{
+		std::atomic<std::size_t> ref_count;
+		std::size_t length;
+		std::size_t depth;
+		// Sides of concatenation, empty in leaves
+		basic_rope left, right;
+		stl_string leaf;
+		// Points to leaf, or to the flattened copy of concatenation once built
+		std::atomic<const stl_string *> flat;
+
+		explicit node(stl_string &&str) : ref_count(1), length(str.size()), depth(0), leaf(std::move(str)), flat(&leaf) {}
+
+		node(const basic_rope &lhs, const basic_rope &rhs)
+		    : ref_count(1), length(lhs.size() + rhs.size()), depth(std::max(lhs.depth(), rhs.depth()) + 1),
+		      left(lhs), right(rhs), flat(nullptr) {}
+
+		~node()
+		{
+			const stl_string *p = flat.load(std::memory_order_relaxed);
+			if (p != &leaf)
+				delete p;
+		}
+
+		// Racing flatteners build their own copies, only the first one is published
+		const stl_string &flatten()
+		{
+			const stl_string *p = flat.load(std::memory_order_acquire);
+			if (p != nullptr)
+				return *p;
+			stl_string *buff = new stl_string;
+			buff->reserve(length);
+			visit(this, 0, length, [buff](stl_string_view piece) { buff->append(piece); });
+			if (flat.compare_exchange_strong(p, buff, std::memory_order_acq_rel, std::memory_order_acquire))
+				return *buff;
+			delete buff;
+			return *p;
+		}
+	};
+
+	template <typename CharT>
+	basic_rope<CharT>::basic_rope(stl_string str)
+	{
+		if (!str.empty())
+		{
+			m_length = str.size();
+			m_node = new node(std::move(str));
+		}
+	}
+
+	template <typename CharT>
+	basic_rope<CharT>::basic_rope(const basic_rope &other) noexcept : m_node(other.m_node), m_offset(other.m_offset), m_length(other.m_length)
+	{
+		if (m_node != nullptr)
+			m_node->ref_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	template <typename CharT>
+	void basic_rope<CharT>::release() noexcept
+	{
+		if (m_node != nullptr && m_node->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			delete m_node;
+		m_node = nullptr;
+	}
+
+	template <typename CharT>
+	bool basic_rope<CharT>::whole_node() const noexcept
+	{
+		return m_node != nullptr && m_offset == 0 && m_length == m_node->length;
+	}
+
+	template <typename CharT>
+	std::size_t basic_rope<CharT>::depth() const noexcept
+	{
+		return m_node != nullptr ? m_node->depth : 0;
+	}
+
+	template <typename CharT>
+	bool basic_rope<CharT>::is_flat() const noexcept
+	{
+		return m_node == nullptr || m_node->flat.load(std::memory_order_acquire) != nullptr;
+	}
+
+	template <typename CharT>
+	template <typename F>
+	void basic_rope<CharT>::visit(const node *nd, std::size_t offset, std::size_t length, F &&func)
+	{
+		const stl_string *p = nd->flat.load(std::memory_order_acquire);
+		if (p != nullptr)
+		{
+			func(stl_string_view(p->data() + offset, length));
+			return;
+		}
+		std::size_t left_len = nd->left.m_length;
+		if (offset < left_len)
+		{
+			std::size_t len = std::min(length, left_len - offset);
+			visit(nd->left.m_node, nd->left.m_offset + offset, len, func);
+			length -= len;
+			offset = left_len;
+		}
+		if (length > 0)
+			visit(nd->right.m_node, nd->right.m_offset + offset - left_len, length, func);
+	}
+
+	template <typename CharT>
+	basic_rope<CharT> basic_rope<CharT>::make_concat(const basic_rope &lhs, const basic_rope &rhs)
+	{
+		node *nd = new node(lhs, rhs);
+		return basic_rope(nd, 0, nd->length);
+	}
+
+	template <typename CharT>
+	basic_rope<CharT> basic_rope<CharT>::join(const basic_rope &lhs, const basic_rope &rhs)
+	{
+		// Slices of a node can not be split into its sides, they are joined as they are
+		if (lhs.depth() > rhs.depth() + 1 && lhs.whole_node())
+		{
+			const basic_rope &outer = lhs.m_node->left;
+			basic_rope inner = join(lhs.m_node->right, rhs);
+			if (inner.depth() <= outer.depth() + 1)
+				return make_concat(outer, inner);
+			// Two levels deeper than outer, rotate
+			const basic_rope &mid = inner.m_node->left, &last = inner.m_node->right;
+			if (mid.depth() <= last.depth() || !mid.whole_node())
+				return make_concat(make_concat(outer, mid), last);
+			return make_concat(make_concat(outer, mid.m_node->left), make_concat(mid.m_node->right, last));
+		}
+		if (rhs.depth() > lhs.depth() + 1 && rhs.whole_node())
+		{
+			const basic_rope &outer = rhs.m_node->right;
+			basic_rope inner = join(lhs, rhs.m_node->left);
+			if (inner.depth() <= outer.depth() + 1)
+				return make_concat(inner, outer);
+			const basic_rope &first = inner.m_node->left, &mid = inner.m_node->right;
+			if (mid.depth() <= first.depth() || !mid.whole_node())
+				return make_concat(first, make_concat(mid, outer));
+			return make_concat(make_concat(first, mid.m_node->left), make_concat(mid.m_node->right, outer));
+		}
+		return make_concat(lhs, rhs);
+	}
+
+	template <typename CharT>
+	void basic_rope<CharT>::collect_leaves(const basic_rope &rope, std::vector<basic_rope> &leaves)
+	{
+		if (rope.empty())
+			return;
+		if (rope.is_flat())
+		{
+			leaves.push_back(rope);
+			return;
+		}
+		const node *nd = rope.m_node;
+		std::size_t left_len = nd->left.m_length;
+		if (rope.m_offset < left_len)
+			collect_leaves(nd->left.substr(rope.m_offset, rope.m_length), leaves);
+		if (rope.m_offset + rope.m_length > left_len)
+		{
+			std::size_t begin = rope.m_offset > left_len ? rope.m_offset - left_len : 0;
+			collect_leaves(nd->right.substr(begin, rope.m_offset + rope.m_length - left_len - begin), leaves);
+		}
+	}
+
+	template <typename CharT>
+	basic_rope<CharT> basic_rope<CharT>::build_balanced(const basic_rope *first, std::size_t count)
+	{
+		if (count == 1)
+			return *first;
+		std::size_t half = count / 2;
+		return make_concat(build_balanced(first, half), build_balanced(first + half, count - half));
+	}
+
+	template <typename CharT>
+	basic_rope<CharT> basic_rope<CharT>::concat(const basic_rope &lhs, const basic_rope &rhs)
+	{
+		if (lhs.empty())
+			return rhs;
+		if (rhs.empty())
+			return lhs;
+		if (lhs.size() + rhs.size() <= short_limit)
+		{
+			stl_string str;
+			str.reserve(lhs.size() + rhs.size());
+			lhs.for_each_piece([&str](stl_string_view piece) { str.append(piece); });
+			rhs.for_each_piece([&str](stl_string_view piece) { str.append(piece); });
+			return basic_rope(std::move(str));
+		}
+		// Short pieces appended one by one are merged into the last leaf down the right spine instead of a node each
+		if (rhs.size() < short_limit && lhs.whole_node() && lhs.m_node->depth > 0)
+			return join(lhs.m_node->left, concat(lhs.m_node->right, rhs));
+		basic_rope res = join(lhs, rhs);
+		// Joined trees stay below 1.44 log2(leaves), deeper ones come from slices and are rebuilt
+		std::size_t depth_limit = 8;
+		for (std::size_t len = res.size(); len > 1; len >>= 1)
+			depth_limit += 2;
+		if (res.depth() > depth_limit)
+		{
+			std::vector<basic_rope> leaves;
+			collect_leaves(res, leaves);
+			res = build_balanced(leaves.data(), leaves.size());
+		}
+		return res;
+	}
+
+	template <typename CharT>
+	basic_rope<CharT> basic_rope<CharT>::substr(std::size_t pos, std::size_t len) const
+	{
+		if (pos > m_length)
+			throw std::out_of_range("cs::basic_rope::substr");
+		len = std::min(len, m_length - pos);
+		if (len == 0)
+			return basic_rope();
+		// Narrow to the smallest side holding the range, so flattening the slice never copies more than needed
+		node *nd = m_node;
+		std::size_t offset = m_offset + pos;
+		while (nd->flat.load(std::memory_order_acquire) == nullptr)
+		{
+			if (offset + len <= nd->left.m_length)
+			{
+				offset += nd->left.m_offset;
+				nd = nd->left.m_node;
+			}
+			else if (offset >= nd->left.m_length)
+			{
+				offset += nd->right.m_offset - nd->left.m_length;
+				nd = nd->right.m_node;
+			}
+			else
+				break;
+		}
+		nd->ref_count.fetch_add(1, std::memory_order_relaxed);
+		return basic_rope(nd, offset, len);
+	}
+
+	template <typename CharT>
+	typename basic_rope<CharT>::stl_string_view basic_rope<CharT>::view() const
+	{
+		if (m_length == 0)
+			return stl_string_view();
+		return stl_string_view(m_node->flatten().data() + m_offset, m_length);
+	}
+
+	using byte_rope_t = basic_rope<char>;
+	using unicode_rope_t = basic_rope<char32_t>;
+} // namespace cs
@@ -0,0 +1,78 @@
+#pragma once
+#include <covscript/types/basic.hpp>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Vectorised kernels of homogeneous arrays and UTF-8 strings, defined in sources/types/simd.cpp
+ * SSE2 kernels are the baseline on x86, AVX2 kernels are selected at runtime when the CPU supports them,
+ * other architectures use the scalar kernels. Define COVSCRIPT_DISABLE_SIMD to always use the scalar kernels.
+ * Floating point reductions sum in several lanes, so rounding may differ from a sequential loop.
+ * Integer kernels wrap around and return false if a step overflowed. Sums in several lanes may report
+ * an overflow the sequential sum would not have, callers redo such cases exactly.
+ */
+namespace cs::simd
+{
+	enum class arith_op
+	{
+		add,
+		sub,
+		mul,
+		div
+	};
+
+	enum class compare_op
+	{
+		eq,
+		ne,
+		lt,
+		le,
+		gt,
+		ge
+	};
+
+	// Name of the instruction set in use, "avx2", "sse2" or "scalar"
+	const char *active_isa() noexcept;
+
+	bool reduce_add(const integer_t *data, std::size_t n, integer_t &sum) noexcept;
+
+	double reduce_add(const double *data, std::size_t n) noexcept;
+
+	// Count of non-zero bytes
+	std::size_t count_nonzero(const std::uint8_t *data, std::size_t n) noexcept;
+
+	bool dot(const integer_t *lhs, const integer_t *rhs, std::size_t n, integer_t &sum) noexcept;
+
+	double dot(const double *lhs, const double *rhs, std::size_t n) noexcept;
+
+	// arith_op::div is not supported for integers
+	bool elementwise(arith_op op, const integer_t *lhs, const integer_t *rhs, integer_t *out, std::size_t n) noexcept;
+
+	void elementwise(arith_op op, const double *lhs, const double *rhs, double *out, std::size_t n) noexcept;
+
+	// Mask of lhs[i] op rhs, one byte of 0 or 1 per element
+	void compare(compare_op op, const integer_t *lhs, integer_t rhs, std::uint8_t *out, std::size_t n) noexcept;
+
+	void compare(compare_op op, const double *lhs, double rhs, std::uint8_t *out, std::size_t n) noexcept;
+
+	// Index of the first element equal to val, n if not found
+	std::size_t find(const integer_t *data, std::size_t n, integer_t val) noexcept;
+
+	std::size_t find(const double *data, std::size_t n, double val) noexcept;
+
+	std::size_t find(const std::uint8_t *data, std::size_t n, std::uint8_t val) noexcept;
+
+	// UTF-8 kernels of cs::unicode. Well-formed means no overlongs, surrogates or code points above U+10FFFF
+	bool utf8_validate(const char *data, std::size_t n) noexcept;
+
+	// Count of code points, input must be well-formed
+	std::size_t utf8_length(const char *data, std::size_t n) noexcept;
+
+	// Input must be well-formed, out must hold utf8_length code points. Returns the end of output
+	char32_t *utf8_to_utf32(const char *data, std::size_t n, char32_t *out) noexcept;
+
+	// Surrogates and code points above U+10FFFF are encoded as U+FFFD
+	std::size_t utf32_to_utf8_length(const char32_t *data, std::size_t n) noexcept;
+
+	char *utf32_to_utf8(const char32_t *data, std::size_t n, char *out) noexcept;
+} // namespace cs::simd
@@ -0,0 +1,335 @@
+#pragma once
+#include <covscript/types/alloc_stats.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace cs
+{
+	/*
+	 * Size-class slab allocator
+	 * Small blocks are carved from slabs of one size class. Every thread owns a heap of slabs and
+	 * serves allocations from the free list of its current slab without locking. Slabs are aligned
+	 * to their size, so the slab of a block is found by masking its address. Blocks freed by other
+	 * threads are pushed onto a lock-free list of the slab and taken back by the owner in bulk.
+	 * Empty slabs are returned to the system, slabs of exited threads are adopted by others.
+	 */
+	namespace slab_detail
+	{
+		// Blocks are multiples of granularity, which is also their alignment
+		constexpr std::size_t granularity = 16;
+
+		// Larger requests go to operator new
+		constexpr std::size_t max_size = 512;
+
+		constexpr std::size_t class_count = max_size / granularity;
+
+		constexpr std::size_t slab_size = 64 * 1024;
+
+		struct heap;
+
+		// Header at the start of every slab
+		struct slab
+		{
+			std::atomic<heap *> owner;
+			// Freed by other threads, taken by the owner all at once
+			std::atomic<void *> remote_free;
+			// Only touched by the owner
+			void *local_free;
+			char *bump;
+			char *end;
+			std::size_t block_size;
+			std::size_t size_class;
+			// Blocks not yet known to the owner as freed
+			std::size_t used;
+			bool full;
+			slab *prev;
+			slab *next;
+		};
+
+		struct arena;
+
+		struct arena_frame;
+
+		struct heap
+		{
+			// Serves every allocation of the thread while set, see domain_arena
+			arena *active_arena = nullptr;
+			// Frames of any arena not left yet, latest first, the arena of the first one is active
+			arena_frame *open_frames = nullptr;
+			// Slabs with free blocks, the first one serves the fast path
+			slab *available[class_count] = {};
+			// Slabs found without free blocks, checked for remote frees before a new slab is made
+			slab *full[class_count] = {};
+		};
+
+		// Size class of arena chunks, which share the header of slabs
+		constexpr std::size_t arena_class = class_count;
+
+		// Every arena block is preceded by its frame
+		constexpr std::size_t arena_prefix = granularity;
+
+		/*
+		 * Blocks allocated between entering and leaving a frame
+		 * Counts are split so the owner thread never needs atomics: local_live is only touched by the owner,
+		 * frees from other threads decrement remote. Once retired, remote alone holds the count of survivors.
+		 */
+		// Frames that escaped make their next siblings run on the slabs, twice as many every time
+		struct escape_backoff
+		{
+			std::size_t skip = 0;
+			std::size_t span = 0;
+		};
+
+		struct arena_frame
+		{
+			heap *owner;
+			arena *home;
+			arena_frame *parent;
+			// Links of heap::open_frames, frames of different arenas may be left in any order
+			arena_frame *open_prev;
+			arena_frame *open_next;
+			// Bump position before the frame, restored when nothing survives
+			slab *chunk;
+			char *mark;
+			std::size_t local_live;
+			std::atomic<std::ptrdiff_t> remote;
+			bool retired;
+			// Chunks kept alive by a retired outermost frame
+			slab *chunks;
+			// Bytes left to bump, the slabs serve the frame once exhausted, zero from the start if demoted
+			std::size_t budget;
+			// Of the children
+			escape_backoff children;
+		};
+
+		struct arena
+		{
+			// Chunks linked by next, the ones after current are spare
+			slab *first = nullptr;
+			slab *current = nullptr;
+			arena_frame *top = nullptr;
+			// Of the outermost frames
+			escape_backoff outermost;
+		};
+
+		inline std::size_t arena_need(std::size_t size) noexcept
+		{
+			return (std::max<std::size_t>(size, 1) + granularity - 1) / granularity * granularity + arena_prefix;
+		}
+
+		void *arena_allocate_slow(arena *a, std::size_t size);
+
+		// Null if the frame is served by the slabs
+		inline void *arena_allocate(arena *a, std::size_t size)
+		{
+			std::size_t need = arena_need(size);
+			arena_frame *f = a->top;
+			if (f->budget < need)
+				return nullptr;
+			slab *c = a->current;
+			if (c != nullptr && std::size_t(c->end - c->bump) >= need)
+			{
+				char *ptr = c->bump;
+				c->bump += need;
+				f->budget -= need;
+				*reinterpret_cast<arena_frame **>(ptr) = f;
+				++f->local_live;
+				return ptr + arena_prefix;
+			}
+			return arena_allocate_slow(a, size);
+		}
+
+		// Null before the first allocation of a thread, and after it exits
+		inline thread_local heap *current_heap = nullptr;
+
+		void *allocate_slow(std::size_t size);
+
+		void deallocate_slow(slab *s, void *ptr) noexcept;
+
+		inline std::size_t class_of(std::size_t size) noexcept
+		{
+			return size == 0 ? 0 : (size - 1) / granularity;
+		}
+
+		inline slab *slab_of(void *ptr) noexcept
+		{
+			return reinterpret_cast<slab *>(reinterpret_cast<std::uintptr_t>(ptr) & ~std::uintptr_t(slab_size - 1));
+		}
+
+		// Whether allocate would be served by the fast path
+		inline bool cached(std::size_t size) noexcept
+		{
+			heap *h = current_heap;
+			if (size > max_size || h == nullptr)
+				return false;
+			if (h->active_arena != nullptr && h->active_arena->top->budget >= arena_need(size))
+				return true;
+			slab *s = h->available[class_of(size)];
+			return s != nullptr && s->local_free != nullptr;
+		}
+
+		inline void *allocate(std::size_t size)
+		{
+			if (size > max_size)
+				return ::operator new(size);
+			heap *h = current_heap;
+			if (h != nullptr)
+			{
+				if (h->active_arena != nullptr)
+				{
+					void *ptr = arena_allocate(h->active_arena, size);
+					if (ptr != nullptr)
+						return ptr;
+				}
+				slab *s = h->available[class_of(size)];
+				if (s != nullptr && s->local_free != nullptr)
+				{
+					void *ptr = s->local_free;
+					s->local_free = *static_cast<void **>(ptr);
+					++s->used;
+					return ptr;
+				}
+			}
+			return allocate_slow(size);
+		}
+
+		inline void deallocate(void *ptr, std::size_t size) noexcept
+		{
+			if (size > max_size)
+			{
+				::operator delete(ptr);
+				return;
+			}
+			slab *s = slab_of(ptr);
+			heap *h = current_heap;
+			// Arena chunks have no owner, full slabs have to be moved back, the last block may release the slab
+			if (h != nullptr && s->owner.load(std::memory_order_relaxed) == h && !s->full && s->used > 1)
+			{
+				*static_cast<void **>(ptr) = s->local_free;
+				s->local_free = ptr;
+				--s->used;
+				return;
+			}
+			if (s->size_class == arena_class && h != nullptr)
+			{
+				arena_frame *f = *reinterpret_cast<arena_frame **>(static_cast<char *>(ptr) - arena_prefix);
+				if (f->owner == h && !f->retired)
+				{
+					--f->local_live;
+					return;
+				}
+			}
+			deallocate_slow(s, ptr);
+		}
+
+		void enter_frame(arena *a);
+
+		void leave_frame(arena *a) noexcept;
+
+		void destroy_arena(arena *a) noexcept;
+
+		std::size_t arena_used(const arena *a) noexcept;
+	} // namespace slab_detail
+
+	// Stateless, any instance frees blocks of any other
+	template <typename T>
+	class slab_allocator
+	{
+	   public:
+		using value_type = T;
+
+		slab_allocator() noexcept = default;
+
+		template <typename U>
+		slab_allocator(const slab_allocator<U> &) noexcept {}
+
+		T *allocate(std::size_t n)
+		{
+			if (n > std::size_t(-1) / sizeof(T))
+				throw std::bad_array_new_length();
+#ifdef COVSCRIPT_ALLOC_STATS
+			alloc_stats::record_allocate<T>(n, alignof(T) <= slab_detail::granularity && slab_detail::cached(n * sizeof(T)));
+#endif
+			if constexpr (alignof(T) > slab_detail::granularity)
+				return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+			else
+				return static_cast<T *>(slab_detail::allocate(n * sizeof(T)));
+		}
+
+		void deallocate(T *ptr, std::size_t n) noexcept
+		{
+#ifdef COVSCRIPT_ALLOC_STATS
+			alloc_stats::record_deallocate<T>(n);
+#endif
+			if constexpr (alignof(T) > slab_detail::granularity)
+				::operator delete(ptr, std::align_val_t(alignof(T)));
+			else
+				slab_detail::deallocate(ptr, n * sizeof(T));
+		}
+
+		template <typename U>
+		bool operator==(const slab_allocator<U> &) const noexcept
+		{
+			return true;
+		}
+
+		template <typename U>
+		bool operator!=(const slab_allocator<U> &) const noexcept
+		{
+			return false;
+		}
+	};
+
+	/*
+	 * Region allocation for nested scopes
+	 * While a frame is entered, every slab_allocator allocation of the thread is bumped from the arena,
+	 * and frees only decrement the count of blocks alive in their frame. Leaving a frame whose blocks
+	 * are all freed releases them with one pointer reset. Blocks that escaped the frame are detected by
+	 * that count, their frame is retired instead and its memory is kept until the last one is freed,
+	 * from any thread. Frames are entered and left in stack order by the thread that owns the arena.
+	 * Arenas of several managers on one thread may interleave, the latest frame still entered serves.
+	 * Nothing freed is reused before its frame is left, so a frame bumps at most 1 MiB and then
+	 * allocates from the slabs. After a frame escaped, its next siblings are served by the slabs
+	 * as well, 16 of them the first time and twice as many after every further escape.
+	 */
+	class domain_arena final
+	{
+		slab_detail::arena m_arena;
+
+	   public:
+		domain_arena() = default;
+
+		domain_arena(const domain_arena &) = delete;
+
+		domain_arena &operator=(const domain_arena &) = delete;
+
+		~domain_arena()
+		{
+			slab_detail::destroy_arena(&m_arena);
+		}
+
+		void enter()
+		{
+			slab_detail::enter_frame(&m_arena);
+		}
+
+		void leave() noexcept
+		{
+			slab_detail::leave_frame(&m_arena);
+		}
+
+		bool empty() const noexcept
+		{
+			return m_arena.top == nullptr;
+		}
+
+		// Bytes bumped in chunks still owned by the arena, zero once every frame is left without survivors
+		std::size_t used() const noexcept
+		{
+			return slab_detail::arena_used(&m_arena);
+		}
+	};
+} // namespace cs
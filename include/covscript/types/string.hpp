@@ -7,82 +7,88 @@ namespace cs
 {
 	using std::to_string;
 
+	/*
+	 * String either borrowed or owned
+	 * Borrowed strings are kept as views, so the length is known without strlen. Owned strings
+	 * are stored in place, short ones stay in the small buffer of stl_string and nothing is
+	 * allocated at all. Borrowed strings must be null terminated if data() is used as C string.
+	 * allocator_t is kept for compatibility, owned strings are no longer allocated separately.
+	 */
 	template <typename CharT,
 	          template <typename> class allocator_t = default_allocator>
 	class basic_string_borrower final
 	{
 		using stl_string = std::basic_string<CharT>;
 		using stl_string_view = std::basic_string_view<CharT>;
-		using allocator_type = allocator_t<stl_string>;
 
-		static allocator_type &get_allocator()
+		union
 		{
-			static allocator_type allocator;
-			return allocator;
-		}
-
-		void *m_data = nullptr;
+			stl_string_view m_view;
+			stl_string m_str;
+		};
 		bool m_own = false;
 
-		void destroy()
+		void destroy() noexcept
 		{
-			if (m_own && m_data)
+			if (m_own)
 			{
-				stl_string *p = static_cast<stl_string *>(m_data);
-				p->~basic_string();
-				get_allocator().deallocate(p, 1);
+				m_str.~basic_string();
+				::new (&m_view) stl_string_view();
 			}
-			m_data = nullptr;
+			else
+				m_view = stl_string_view();
 			m_own = false;
 		}
 
+		// Requires empty this
+		void take(basic_string_borrower &&other) noexcept
+		{
+			if (other.m_own)
+			{
+				::new (&m_str) stl_string(std::move(other.m_str));
+				m_own = true;
+				other.destroy();
+			}
+			else
+			{
+				m_view = other.m_view;
+				other.m_view = stl_string_view();
+			}
+		}
+
 	   public:
-		basic_string_borrower() noexcept = default;
+		basic_string_borrower() noexcept : m_view() {}
 
-		basic_string_borrower(const CharT *str) noexcept : m_data(const_cast<CharT *>(str)), m_own(false) {}
+		basic_string_borrower(const CharT *str) noexcept : m_view(str != nullptr ? stl_string_view(str) : stl_string_view()) {}
 
-		basic_string_borrower(stl_string_view view) noexcept : m_data(const_cast<CharT *>(view.data())), m_own(false) {}
+		basic_string_borrower(stl_string_view view) noexcept : m_view(view) {}
 
-		basic_string_borrower(stl_string str) : m_own(true)
-		{
-			stl_string *p = get_allocator().allocate(1);
-			::new (p) stl_string(std::move(str));
-			m_data = p;
-		}
+		basic_string_borrower(stl_string str) : m_str(std::move(str)), m_own(true) {}
 
-		basic_string_borrower(const basic_string_borrower &other) : m_own(other.m_own)
+		basic_string_borrower(const basic_string_borrower &other) : m_view(), m_own(false)
 		{
 			if (other.m_own)
 			{
-				stl_string *p = get_allocator().allocate(1);
-				::new (p) stl_string(*static_cast<stl_string *>(other.m_data));
-				m_data = p;
+				::new (&m_str) stl_string(other.m_str);
+				m_own = true;
 			}
 			else
-				m_data = other.m_data;
+				m_view = other.m_view;
 		}
 
-		basic_string_borrower(basic_string_borrower &&other) noexcept
-		    : m_data(other.m_data), m_own(other.m_own)
+		basic_string_borrower(basic_string_borrower &&other) noexcept : m_view()
 		{
-			other.m_data = nullptr;
-			other.m_own = false;
+			take(std::move(other));
 		}
 
 		basic_string_borrower &operator=(const basic_string_borrower &other)
 		{
 			if (this != &other)
 			{
-				destroy();
-				m_own = other.m_own;
-				if (other.m_own)
-				{
-					stl_string *p = get_allocator().allocate(1);
-					::new (p) stl_string(*static_cast<stl_string *>(other.m_data));
-					m_data = p;
-				}
+				if (m_own && other.m_own)
+					m_str = other.m_str;
 				else
-					m_data = other.m_data;
+					*this = basic_string_borrower(other);
 			}
 			return *this;
 		}
@@ -92,42 +98,35 @@ namespace cs
 			if (this != &other)
 			{
 				destroy();
-				m_data = other.m_data;
-				m_own = other.m_own;
-				other.m_data = nullptr;
-				other.m_own = false;
+				take(std::move(other));
 			}
 			return *this;
 		}
 
 		~basic_string_borrower()
 		{
-			destroy();
+			if (m_own)
+				m_str.~basic_string();
 		}
 
 		stl_string_view view() const noexcept
 		{
-			if (m_own)
-				return *static_cast<stl_string *>(m_data);
-			else if (m_data)
-				return stl_string_view(static_cast<CharT *>(m_data));
-			else
-				return stl_string_view{};
+			return m_own ? stl_string_view(m_str) : m_view;
 		}
 
 		const CharT *data() const noexcept
 		{
-			if (m_own)
-				return static_cast<stl_string *>(m_data)->data();
-			else if (m_data)
-				return static_cast<CharT *>(m_data);
-			else
-				return nullptr;
+			return m_own ? m_str.data() : m_view.data();
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_own ? m_str.size() : m_view.size();
 		}
 
 		bool usable() const noexcept
 		{
-			return m_data != nullptr;
+			return m_own || m_view.data() != nullptr;
 		}
 
 		operator bool() const noexcept
@@ -137,7 +136,7 @@ namespace cs
 
 		stl_string *access() noexcept
 		{
-			return m_own ? static_cast<stl_string *>(m_data) : nullptr;
+			return m_own ? &m_str : nullptr;
 		}
 	};
 
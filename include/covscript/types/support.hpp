@@ -1,6 +1,12 @@
 #pragma once
 #include <covscript/types/string.hpp>
 #include <covscript/types/exception.hpp>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
 namespace cs_impl
 {
@@ -121,6 +127,106 @@ namespace cs_impl
 	};
 
 	// Hash
+	namespace hash_detail
+	{
+		static constexpr std::uint64_t secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+		                                            0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+		// Full 64x64 bits multiplication, low and high halves returned in place
+		inline void multiply(std::uint64_t &lo, std::uint64_t &hi) noexcept
+		{
+#if defined(__SIZEOF_INT128__)
+			__uint128_t r = static_cast<__uint128_t>(lo) * hi;
+			lo = static_cast<std::uint64_t>(r);
+			hi = static_cast<std::uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+			lo = _umul128(lo, hi, &hi);
+#else
+			std::uint64_t ha = lo >> 32, hb = hi >> 32, la = static_cast<std::uint32_t>(lo), lb = static_cast<std::uint32_t>(hi);
+			std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+			lo = t + (rm1 << 32);
+			c += lo < t;
+			hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+		}
+
+		inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) noexcept
+		{
+			multiply(a, b);
+			return a ^ b;
+		}
+
+		inline std::uint64_t read64(const unsigned char *p) noexcept
+		{
+			std::uint64_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline std::uint64_t read32(const unsigned char *p) noexcept
+		{
+			std::uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+	} // namespace hash_detail
+
+	/*
+	 * Hash of byte sequence, wyhash construction
+	 * Reads eight bytes at a time with a single wide multiplication per step, much faster than
+	 * byte-wise hashing of the standard library on long strings. Not stable across platforms.
+	 */
+	inline std::size_t hash_bytes(const void *data, std::size_t len) noexcept
+	{
+		using namespace hash_detail;
+		const unsigned char *p = static_cast<const unsigned char *>(data);
+		std::uint64_t seed = mix(secret[0], secret[1]), a, b;
+		if (len <= 16)
+		{
+			if (len >= 4)
+			{
+				a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+				b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+			}
+			else if (len > 0)
+			{
+				a = (std::uint64_t(p[0]) << 16) | (std::uint64_t(p[len >> 1]) << 8) | p[len - 1];
+				b = 0;
+			}
+			else
+				a = b = 0;
+		}
+		else
+		{
+			std::size_t i = len;
+			if (i > 48)
+			{
+				std::uint64_t see1 = seed, see2 = seed;
+				do
+				{
+					seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+					see1 = mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ see1);
+					see2 = mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ see2);
+					p += 48;
+					i -= 48;
+				} while (i > 48);
+				seed ^= see1 ^ see2;
+			}
+			while (i > 16)
+			{
+				seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+				i -= 16;
+				p += 16;
+			}
+			a = read64(p + i - 16);
+			b = read64(p + i - 8);
+		}
+		a ^= secret[1];
+		b ^= seed;
+		multiply(a, b);
+		return static_cast<std::size_t>(mix(a ^ secret[0] ^ len, b ^ secret[1]));
+	}
+
 	template <typename T, typename = void>
 	struct hash_helper
 	{
@@ -201,6 +307,13 @@ namespace cs_impl
 		return to_string_if<T, to_string_helper<T>::value>::to_string(val);
 	}
 
+	// Appends the text of to_string to out, specialize to write in place without temporaries
+	template <typename T>
+	static void to_stream(cs::byte_string_t &out, const T &val)
+	{
+		out.append(to_string(val).view());
+	}
+
 	template <typename T>
 	static cs::integer_t to_integer(const T &val)
 	{
@@ -289,6 +402,27 @@ namespace cs_impl
 	template <typename T>
 	using var_storage_t = typename var_storage<std::decay_t<T>>::type;
 
+	// Specialize to share heap payload of type between copies, cloned on first mutable access
+	template <typename T>
+	struct var_cow
+	{
+		static constexpr bool value = false;
+	};
+
+	// Specialize to keep the hash of type in spare storage of variables, invalidated on mutable access
+	template <typename T>
+	struct var_hash_cache
+	{
+		static constexpr bool value = false;
+	};
+
+	// Whether an inline stored value of type can be moved to another address by memcpy
+	template <typename T>
+	struct var_relocatable
+	{
+		static constexpr bool value = std::is_trivially_copyable_v<T>;
+	};
+
 	namespace operators
 	{
 		enum class type
@@ -0,0 +1,92 @@
+#pragma once
+#include <covscript/types/basic.hpp>
+#include <functional>
+#include <cstddef>
+
+namespace cs
+{
+	/*
+	 * Interned symbol
+	 * Every distinct string is stored once in the global symbol table and never released,
+	 * symbols only keep a pointer to the entry. So comparison is pointer equality,
+	 * id and hash are computed once while interning. The empty string is the null symbol with id 0.
+	 */
+	class symbol_t final
+	{
+	   public:
+		struct entry
+		{
+			byte_string_t str;
+			std::size_t id;
+			std::size_t hash;
+		};
+
+	   private:
+		const entry *m_entry = nullptr;
+
+		// Defined in sources/types/symbol.cpp, thread safe
+		static const entry *intern(byte_string_view str);
+
+	   public:
+		// Count of interned symbols, the null symbol is not counted
+		static std::size_t table_size() noexcept;
+
+		symbol_t() noexcept = default;
+
+		explicit symbol_t(byte_string_view str) : m_entry(str.empty() ? nullptr : intern(str)) {}
+
+		inline std::size_t id() const noexcept
+		{
+			return m_entry != nullptr ? m_entry->id : 0;
+		}
+
+		inline std::size_t hash() const noexcept
+		{
+			return m_entry != nullptr ? m_entry->hash : std::hash<byte_string_view>{}(byte_string_view());
+		}
+
+		inline bool empty() const noexcept
+		{
+			return m_entry == nullptr;
+		}
+
+		inline byte_string_view view() const noexcept
+		{
+			return m_entry != nullptr ? byte_string_view(m_entry->str) : byte_string_view();
+		}
+
+		// Null terminated, valid as long as the program runs
+		inline const char_t *data() const noexcept
+		{
+			return m_entry != nullptr ? m_entry->str.c_str() : "";
+		}
+
+		inline bool operator==(const symbol_t &other) const noexcept
+		{
+			return m_entry == other.m_entry;
+		}
+
+		inline bool operator!=(const symbol_t &other) const noexcept
+		{
+			return m_entry != other.m_entry;
+		}
+
+		// Ordered by interning order, not lexicographically
+		inline bool operator<(const symbol_t &other) const noexcept
+		{
+			return id() < other.id();
+		}
+	};
+} // namespace cs
+
+namespace std
+{
+	template <>
+	struct hash<cs::symbol_t>
+	{
+		std::size_t operator()(const cs::symbol_t &sym) const noexcept
+		{
+			return sym.hash();
+		}
+	};
+} // namespace std
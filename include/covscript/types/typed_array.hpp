@@ -0,0 +1,492 @@
+#pragma once
+#include <covscript/types/types.hpp>
+#include <covscript/types/simd.hpp>
+#include <memory>
+
+namespace cs
+{
+	/*
+	 * Homogeneous array
+	 * Integers, floats exactly representable as double and booleans are stored unboxed and contiguously,
+	 * so reductions, elementwise arithmetic, comparisons and search run on vectorised kernels.
+	 * The kind is decided by the first inserted value. Inserting a value not matching the kind
+	 * promotes the array to a generic cs::array, which is never reverted.
+	 */
+	class typed_array final
+	{
+	   public:
+		enum class kind_type : std::uint8_t
+		{
+			none,
+			integer,
+			floating,
+			boolean,
+			generic
+		};
+
+		static constexpr std::size_t npos = std::size_t(-1);
+
+	   private:
+		kind_type m_kind = kind_type::none;
+		vector<integer_t> m_integers;
+		vector<double> m_floats;
+		vector<std::uint8_t> m_booleans;
+		std::unique_ptr<array> m_generic;
+
+		// Float of numeric kept unboxed only if double holds it exactly
+		static inline bool as_double(const numeric_t &num, double &out) noexcept
+		{
+			float_t val = num.as_float();
+			out = static_cast<double>(val);
+			return static_cast<float_t>(out) == val || val != val;
+		}
+
+		static kind_type kind_of(const var &val)
+		{
+			double tmp;
+			switch (val.tag())
+			{
+				case var_tag::numeric:
+				{
+					const numeric_t &num = val.const_val<numeric_t>();
+					if (num.is_big())
+						return kind_type::generic;
+					else if (num.is_integer())
+						return kind_type::integer;
+					else if (as_double(num, tmp))
+						return kind_type::floating;
+					else
+						return kind_type::generic;
+				}
+				case var_tag::boolean:
+					return kind_type::boolean;
+				default:
+					return kind_type::generic;
+			}
+		}
+
+		bool matches(const var &val) const
+		{
+			return m_kind == kind_type::generic || kind_of(val) == m_kind;
+		}
+
+		void check_index(std::size_t idx) const
+		{
+			if (idx >= size())
+				throw runtime_error("Out of range.");
+		}
+
+		var unchecked_get(std::size_t idx) const
+		{
+			switch (m_kind)
+			{
+				case kind_type::integer:
+					return var::make<numeric_t>(m_integers[idx]);
+				case kind_type::floating:
+					return var::make<numeric_t>(static_cast<float_t>(m_floats[idx]));
+				case kind_type::boolean:
+					return var::make<bool_t>(m_booleans[idx] != 0);
+				default:
+					return (*m_generic)[idx];
+			}
+		}
+
+		// Value of matching kind
+		void unchecked_push(const var &val)
+		{
+			switch (m_kind)
+			{
+				case kind_type::integer:
+					m_integers.push_back(val.const_val<numeric_t>().as_integer());
+					break;
+				case kind_type::floating:
+					m_floats.push_back(static_cast<double>(val.const_val<numeric_t>().as_float()));
+					break;
+				case kind_type::boolean:
+					m_booleans.push_back(val.const_val<bool_t>());
+					break;
+				default:
+					m_generic->push_back(val);
+					break;
+			}
+		}
+
+		void unchecked_set(std::size_t idx, const var &val)
+		{
+			switch (m_kind)
+			{
+				case kind_type::integer:
+					m_integers[idx] = val.const_val<numeric_t>().as_integer();
+					break;
+				case kind_type::floating:
+					m_floats[idx] = static_cast<double>(val.const_val<numeric_t>().as_float());
+					break;
+				case kind_type::boolean:
+					m_booleans[idx] = val.const_val<bool_t>();
+					break;
+				default:
+					(*m_generic)[idx] = val;
+					break;
+			}
+		}
+
+		// Elementwise operation through variables, used by generic and mixed kinds
+		template <typename FuncT>
+		typed_array generic_elementwise(const typed_array &other, FuncT &&func) const
+		{
+			typed_array result;
+			for (std::size_t i = 0, n = size(); i < n; ++i)
+				result.push_back(func(unchecked_get(i).const_val<numeric_t>(), other.unchecked_get(i).const_val<numeric_t>()));
+			return result;
+		}
+
+		numeric_t generic_sum() const
+		{
+			numeric_t sum;
+			for (std::size_t i = 0, n = size(); i < n; ++i)
+				sum = sum + unchecked_get(i).const_val<numeric_t>();
+			return sum;
+		}
+
+	   public:
+		typed_array() = default;
+
+		explicit typed_array(kind_type kind) : m_kind(kind)
+		{
+			if (kind == kind_type::generic)
+				m_generic = std::make_unique<array>();
+		}
+
+		typed_array(std::initializer_list<var> il)
+		{
+			for (auto &val : il)
+				push_back(val);
+		}
+
+		typed_array(const typed_array &other)
+		    : m_kind(other.m_kind), m_integers(other.m_integers), m_floats(other.m_floats), m_booleans(other.m_booleans)
+		{
+			if (other.m_generic)
+				m_generic = std::make_unique<array>(*other.m_generic);
+		}
+
+		typed_array(typed_array &&) noexcept = default;
+
+		typed_array &operator=(const typed_array &other)
+		{
+			if (this != &other)
+			{
+				typed_array copy(other);
+				*this = std::move(copy);
+			}
+			return *this;
+		}
+
+		typed_array &operator=(typed_array &&) noexcept = default;
+
+		inline kind_type kind() const noexcept
+		{
+			return m_kind;
+		}
+
+		inline bool is_generic() const noexcept
+		{
+			return m_kind == kind_type::generic;
+		}
+
+		std::size_t size() const noexcept
+		{
+			switch (m_kind)
+			{
+				case kind_type::integer:
+					return m_integers.size();
+				case kind_type::floating:
+					return m_floats.size();
+				case kind_type::boolean:
+					return m_booleans.size();
+				case kind_type::generic:
+					return m_generic->size();
+				default:
+					return 0;
+			}
+		}
+
+		inline bool empty() const noexcept
+		{
+			return size() == 0;
+		}
+
+		// Unboxed storage, only valid for the corresponding kind
+		inline const integer_t *integers() const noexcept
+		{
+			return m_integers.data();
+		}
+
+		inline const double *floats() const noexcept
+		{
+			return m_floats.data();
+		}
+
+		inline const std::uint8_t *booleans() const noexcept
+		{
+			return m_booleans.data();
+		}
+
+		// Convert into generic array, all elements are boxed into variables
+		void promote()
+		{
+			if (m_kind == kind_type::generic)
+				return;
+			auto generic = std::make_unique<array>();
+			for (std::size_t i = 0, n = size(); i < n; ++i)
+				generic->push_back(unchecked_get(i));
+			m_integers = vector<integer_t>();
+			m_floats = vector<double>();
+			m_booleans = vector<std::uint8_t>();
+			m_generic = std::move(generic);
+			m_kind = kind_type::generic;
+		}
+
+		const array &generic()
+		{
+			promote();
+			return *m_generic;
+		}
+
+		array to_array() const
+		{
+			if (m_kind == kind_type::generic)
+				return *m_generic;
+			array arr;
+			for (std::size_t i = 0, n = size(); i < n; ++i)
+				arr.push_back(unchecked_get(i));
+			return arr;
+		}
+
+		void clear()
+		{
+			m_integers.clear();
+			m_floats.clear();
+			m_booleans.clear();
+			if (m_generic)
+				m_generic->clear();
+		}
+
+		void push_back(const var &val)
+		{
+			if (m_kind == kind_type::none)
+			{
+				m_kind = kind_of(val);
+				if (m_kind == kind_type::generic)
+					m_generic = std::make_unique<array>();
+			}
+			else if (!matches(val))
+				promote();
+			unchecked_push(val);
+		}
+
+		void pop_back()
+		{
+			if (empty())
+				throw runtime_error("Pop from empty array.");
+			switch (m_kind)
+			{
+				case kind_type::integer:
+					m_integers.pop_back();
+					break;
+				case kind_type::floating:
+					m_floats.pop_back();
+					break;
+				case kind_type::boolean:
+					m_booleans.pop_back();
+					break;
+				default:
+					m_generic->pop_back();
+					break;
+			}
+		}
+
+		var get(std::size_t idx) const
+		{
+			check_index(idx);
+			return unchecked_get(idx);
+		}
+
+		void set(std::size_t idx, const var &val)
+		{
+			check_index(idx);
+			if (!matches(val))
+				promote();
+			unchecked_set(idx, val);
+		}
+
+		numeric_t sum() const
+		{
+			switch (m_kind)
+			{
+				case kind_type::none:
+					return numeric_t();
+				case kind_type::integer:
+				{
+					integer_t sum;
+					if (simd::reduce_add(m_integers.data(), m_integers.size(), sum))
+						return sum;
+					// Promoted to bigint like numeric_t
+					return generic_sum();
+				}
+				case kind_type::floating:
+					return static_cast<float_t>(simd::reduce_add(m_floats.data(), m_floats.size()));
+				case kind_type::boolean:
+					return static_cast<integer_t>(simd::count_nonzero(m_booleans.data(), m_booleans.size()));
+				default:
+					return generic_sum();
+			}
+		}
+
+		numeric_t dot(const typed_array &other) const
+		{
+			if (size() != other.size())
+				throw lang_error("Size of arrays mismatch.");
+			if (m_kind == other.m_kind && m_kind == kind_type::integer)
+			{
+				integer_t sum;
+				if (simd::dot(m_integers.data(), other.m_integers.data(), m_integers.size(), sum))
+					return sum;
+			}
+			else if (m_kind == other.m_kind && m_kind == kind_type::floating)
+				return static_cast<float_t>(simd::dot(m_floats.data(), other.m_floats.data(), m_floats.size()));
+			numeric_t sum;
+			for (std::size_t i = 0, n = size(); i < n; ++i)
+				sum = sum + unchecked_get(i).const_val<numeric_t>() * other.unchecked_get(i).const_val<numeric_t>();
+			return sum;
+		}
+
+		// Elementwise arithmetic of numeric arrays with same size
+		typed_array arith(simd::arith_op op, const typed_array &other) const
+		{
+			if (size() != other.size())
+				throw lang_error("Size of arrays mismatch.");
+			if (m_kind == other.m_kind && m_kind == kind_type::integer && op != simd::arith_op::div)
+			{
+				typed_array result(kind_type::integer);
+				result.m_integers.resize(m_integers.size());
+				if (simd::elementwise(op, m_integers.data(), other.m_integers.data(), result.m_integers.data(), m_integers.size()))
+					return result;
+				// Overflowed elements become bigints, the result is generic
+			}
+			else if (m_kind == other.m_kind && m_kind == kind_type::floating)
+			{
+				typed_array result(kind_type::floating);
+				result.m_floats.resize(m_floats.size());
+				simd::elementwise(op, m_floats.data(), other.m_floats.data(), result.m_floats.data(), m_floats.size());
+				return result;
+			}
+			// Division of integers may produce floats, same as numeric_t
+			switch (op)
+			{
+				default:
+				case simd::arith_op::add:
+					return generic_elementwise(other, [](const numeric_t &a, const numeric_t &b) { return a + b; });
+				case simd::arith_op::sub:
+					return generic_elementwise(other, [](const numeric_t &a, const numeric_t &b) { return a - b; });
+				case simd::arith_op::mul:
+					return generic_elementwise(other, [](const numeric_t &a, const numeric_t &b) { return a * b; });
+				case simd::arith_op::div:
+					return generic_elementwise(other, [](const numeric_t &a, const numeric_t &b) { return a / b; });
+			}
+		}
+
+		// Boolean mask of element op val
+		typed_array compare(simd::compare_op op, const var &val) const
+		{
+			typed_array result(kind_type::boolean);
+			std::size_t n = size();
+			kind_type val_kind = kind_of(val);
+			if (m_kind == kind_type::integer && val_kind == kind_type::integer)
+			{
+				result.m_booleans.resize(n);
+				simd::compare(op, m_integers.data(), val.const_val<numeric_t>().as_integer(), result.m_booleans.data(), n);
+				return result;
+			}
+			else if (m_kind == kind_type::floating && val_kind == kind_type::floating)
+			{
+				result.m_booleans.resize(n);
+				simd::compare(op, m_floats.data(), static_cast<double>(val.const_val<numeric_t>().as_float()), result.m_booleans.data(), n);
+				return result;
+			}
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				var elem = unchecked_get(i);
+				bool_t res;
+				switch (op)
+				{
+					default:
+					case simd::compare_op::eq:
+						res = elem.compare(val);
+						break;
+					case simd::compare_op::ne:
+						res = !elem.compare(val);
+						break;
+					case simd::compare_op::lt:
+						res = elem.operate(var::operators_type::undcmp, &val).const_data()->const_val<bool_t>();
+						break;
+					case simd::compare_op::le:
+						res = elem.operate(var::operators_type::ueqcmp, &val).const_data()->const_val<bool_t>();
+						break;
+					case simd::compare_op::gt:
+						res = elem.operate(var::operators_type::abocmp, &val).const_data()->const_val<bool_t>();
+						break;
+					case simd::compare_op::ge:
+						res = elem.operate(var::operators_type::aepcmp, &val).const_data()->const_val<bool_t>();
+						break;
+				}
+				result.m_booleans.push_back(res);
+			}
+			return result;
+		}
+
+		// Index of first element equal to val, npos if not found
+		std::size_t find(const var &val) const
+		{
+			std::size_t n = size(), idx = n;
+			kind_type val_kind = kind_of(val);
+			if (m_kind == kind_type::integer && val_kind == kind_type::integer)
+				idx = simd::find(m_integers.data(), n, val.const_val<numeric_t>().as_integer());
+			else if (m_kind == kind_type::floating && val_kind == kind_type::floating)
+				idx = simd::find(m_floats.data(), n, static_cast<double>(val.const_val<numeric_t>().as_float()));
+			else if (m_kind == kind_type::boolean && val_kind == kind_type::boolean)
+				idx = simd::find(m_booleans.data(), n, static_cast<std::uint8_t>(val.const_val<bool_t>()));
+			else
+			{
+				// Mixed kinds, numerics of different kinds may still be equal
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					if (unchecked_get(i).compare(val))
+					{
+						idx = i;
+						break;
+					}
+				}
+			}
+			return idx == n ? npos : idx;
+		}
+
+		void gc_mark_reachable() const
+		{
+			if (m_generic)
+			{
+				for (auto &val : *m_generic)
+					val.gc_mark_reachable();
+			}
+		}
+	};
+} // namespace cs
+
+namespace cs_impl
+{
+	template <>
+	void mark_reachable<cs::typed_array>(const cs::typed_array &data)
+	{
+		data.gc_mark_reachable();
+	}
+} // namespace cs_impl
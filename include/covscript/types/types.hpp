@@ -1,9 +1,13 @@
 #pragma once
 #include <covscript/types/basic.hpp>
 #include <covscript/types/string.hpp>
+#include <covscript/types/rope.hpp>
+#include <covscript/types/utf8_string.hpp>
 #include <covscript/types/numeric.hpp>
 #include <covscript/types/exception.hpp>
+#include <covscript/types/symbol.hpp>
 #include <covscript/types/variable.hpp>
+#include <covscript/types/compact.hpp>
 
 #ifndef CS_COMPATIBILITY_MODE
 #include <parallel_hashmap/phmap.h>
@@ -17,20 +21,24 @@
 #include <deque>
 #include <vector>
 #include <utility>
+#include <functional>
 
 namespace cs
 {
 	using string = byte_string_t;
 	using string_view = byte_string_view;
 	using string_borrower = byte_string_borrower;
+	using rope = byte_rope_t;
 	using utf_string = unicode_string_t;
 	using utf_string_view = unicode_string_view;
 	using utf_string_borrower = unicode_string_borrower;
+	using utf8_string = utf8_string_t;
 	using list = std::list<var>;
 	using fwd_list = std::forward_list<var>;
 	using array = std::deque<var>;
-	using fwd_array = std::vector<var>;
+	using fwd_array = vector<var>;
 	using pair = std::pair<var, var>;
+	using compact_array = std::deque<compact_var>;
 
 #ifndef CS_COMPATIBILITY_MODE
 	template <typename _kT, typename _vT>
@@ -44,8 +52,159 @@ namespace cs
 	using set_t = std::unordered_set<_Tp>;
 #endif
 
-	using hash_set = set_t<var>;
-	using hash_map = map_t<var, var>;
+	// Transparent hashing of variables, hashes of keys are the same as var::hash()
+	struct var_hash
+	{
+		using is_transparent = void;
+
+		std::size_t operator()(const var &val) const
+		{
+			return val.hash();
+		}
+
+		std::size_t operator()(string_view str) const noexcept
+		{
+			return cs_impl::hash_bytes(str.data(), str.size());
+		}
+
+		// Exact match, strings convert to both var and string_view
+		std::size_t operator()(const string &str) const noexcept
+		{
+			return operator()(string_view(str));
+		}
+
+		std::size_t operator()(const char *str) const noexcept
+		{
+			return operator()(string_view(str));
+		}
+
+		std::size_t operator()(integer_t num) const noexcept
+		{
+			return std::hash<integer_t>{}(num);
+		}
+
+		std::size_t operator()(const numeric_t &num) const noexcept
+		{
+			return num.hash();
+		}
+	};
+
+	struct var_equal
+	{
+		using is_transparent = void;
+
+		bool operator()(const var &lhs, const var &rhs) const
+		{
+			return lhs.compare(rhs);
+		}
+
+		bool operator()(const var &lhs, string_view rhs) const
+		{
+			if (lhs.tag() == var_tag::string)
+				return lhs.const_val<string>() == rhs;
+			// Ropes and UTF-8 strings hash and compare like strings of the same content
+			if (lhs.is_type_of<rope>())
+			{
+				const rope &str = lhs.const_val<rope>();
+				return str.size() == rhs.size() && str.view() == rhs;
+			}
+			if (lhs.is_type_of<utf8_string>())
+				return lhs.const_val<utf8_string>().view() == rhs;
+			return false;
+		}
+
+		bool operator()(const var &lhs, const string &rhs) const
+		{
+			return operator()(lhs, string_view(rhs));
+		}
+
+		bool operator()(const var &lhs, const char *rhs) const
+		{
+			return operator()(lhs, string_view(rhs));
+		}
+
+		bool operator()(const var &lhs, integer_t rhs) const
+		{
+			return lhs.tag() == var_tag::numeric && lhs.const_val<numeric_t>() == rhs;
+		}
+
+		bool operator()(const var &lhs, const numeric_t &rhs) const
+		{
+			return lhs.tag() == var_tag::numeric && lhs.const_val<numeric_t>() == rhs;
+		}
+
+		template <typename T>
+		bool operator()(const T &lhs, const var &rhs) const
+		{
+			return operator()(rhs, lhs);
+		}
+	};
+
+#ifndef CS_COMPATIBILITY_MODE
+	using hash_set = phmap::flat_hash_set<var, var_hash, var_equal>;
+	using hash_map = phmap::flat_hash_map<var, var, var_hash, var_equal>;
+#define CS_TRANSPARENT_LOOKUP
+#else
+	using hash_set = std::unordered_set<var, var_hash, var_equal>;
+	using hash_map = std::unordered_map<var, var, var_hash, var_equal>;
+#if defined(__cpp_lib_generic_unordered_lookup)
+#define CS_TRANSPARENT_LOOKUP
+#endif
+#endif
+
+	namespace lookup_detail
+	{
+		inline const var &key_of(const var &key)
+		{
+			return key;
+		}
+
+		inline var key_of(string_view key)
+		{
+			return var::make<string>(key);
+		}
+
+		inline var key_of(const string &key)
+		{
+			return var::make<string>(key);
+		}
+
+		inline var key_of(const char *key)
+		{
+			return var::make<string>(key);
+		}
+
+		inline var key_of(integer_t key)
+		{
+			return var::make<numeric_t>(key);
+		}
+
+		inline var key_of(const numeric_t &key)
+		{
+			return var::make<numeric_t>(key);
+		}
+	} // namespace lookup_detail
+
+	// Lookup in hash_map or hash_set without constructing a key variable when supported
+	template <typename map_t, typename key_t>
+	auto hash_find(map_t &map, const key_t &key) -> decltype(map.find(std::declval<const var &>()))
+	{
+#ifdef CS_TRANSPARENT_LOOKUP
+		return map.find(key);
+#else
+		return map.find(lookup_detail::key_of(key));
+#endif
+	}
+
+	template <typename map_t, typename key_t>
+	std::size_t hash_count(const map_t &map, const key_t &key)
+	{
+#ifdef CS_TRANSPARENT_LOOKUP
+		return map.count(key);
+#else
+		return map.count(lookup_detail::key_of(key));
+#endif
+	}
 } // namespace cs
 
 #include "covscript/types/xtra_impl.cpp"
@@ -0,0 +1,288 @@
+#pragma once
+#include <covscript/types/basic.hpp>
+#include <covscript/types/string.hpp>
+#include <stdexcept>
+#include <iterator>
+#include <atomic>
+#include <vector>
+
+namespace cs
+{
+	/*
+	 * UTF-8 string indexed by code points
+	 * Content is validated once on construction and kept as UTF-8, so unicode operations no longer
+	 * need a UTF-32 copy four times the size. Length is counted on construction. The byte offset of
+	 * every index_stride-th code point is recorded on the first positional access, so indexing and
+	 * slicing by code point scan at most one stride. Pure ASCII content needs no index at all.
+	 * The index is published atomically, so concurrent readers of one string are safe.
+	 */
+	class utf8_string_t final
+	{
+	   public:
+		static constexpr std::size_t npos = std::size_t(-1);
+
+		// Code points between two entries of the offset index
+		static constexpr std::size_t index_stride = 64;
+
+		class const_iterator;
+
+	   private:
+		struct offset_index
+		{
+			// Byte offset of code point k * index_stride
+			std::vector<std::size_t> offsets;
+		};
+
+		byte_string_t m_str;
+		std::size_t m_length = 0;
+		mutable std::atomic<const offset_index *> m_index{nullptr};
+
+		struct trusted_tag
+		{
+		};
+
+		// Content already known to be valid
+		utf8_string_t(trusted_tag, byte_string_t str, std::size_t length) noexcept : m_str(std::move(str)), m_length(length) {}
+
+		const offset_index &get_index() const;
+
+		std::size_t offset_slow(std::size_t pos) const;
+
+		void reset_index() noexcept
+		{
+			delete m_index.exchange(nullptr, std::memory_order_acq_rel);
+		}
+
+	   public:
+		utf8_string_t() noexcept = default;
+
+		// Throws lang_error if str is not valid UTF-8
+		explicit utf8_string_t(byte_string_t str);
+
+		explicit utf8_string_t(byte_string_view str) : utf8_string_t(byte_string_t(str)) {}
+
+		explicit utf8_string_t(const char *str) : utf8_string_t(byte_string_t(str)) {}
+
+		// Invalid code points are replaced by U+FFFD
+		explicit utf8_string_t(unicode_string_view str);
+
+		utf8_string_t(const utf8_string_t &other);
+
+		utf8_string_t(utf8_string_t &&other) noexcept : m_str(std::move(other.m_str)), m_length(other.m_length),
+		                                                m_index(other.m_index.exchange(nullptr, std::memory_order_acq_rel))
+		{
+			other.m_str.clear();
+			other.m_length = 0;
+		}
+
+		~utf8_string_t()
+		{
+			reset_index();
+		}
+
+		utf8_string_t &operator=(const utf8_string_t &other)
+		{
+			if (this != &other)
+				*this = utf8_string_t(other);
+			return *this;
+		}
+
+		utf8_string_t &operator=(utf8_string_t &&other) noexcept
+		{
+			if (this != &other)
+			{
+				reset_index();
+				m_str = std::move(other.m_str);
+				m_length = other.m_length;
+				m_index.store(other.m_index.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_release);
+				other.m_str.clear();
+				other.m_length = 0;
+			}
+			return *this;
+		}
+
+		// Count of code points
+		std::size_t length() const noexcept
+		{
+			return m_length;
+		}
+
+		// Count of bytes
+		std::size_t size() const noexcept
+		{
+			return m_str.size();
+		}
+
+		bool empty() const noexcept
+		{
+			return m_str.empty();
+		}
+
+		bool is_ascii() const noexcept
+		{
+			return m_length == m_str.size();
+		}
+
+		const byte_string_t &str() const noexcept
+		{
+			return m_str;
+		}
+
+		byte_string_view view() const noexcept
+		{
+			return m_str;
+		}
+
+		// Null terminated
+		const char *data() const noexcept
+		{
+			return m_str.c_str();
+		}
+
+		// Byte offset of code point pos, size() if pos is length(). Throws std::out_of_range beyond that
+		std::size_t offset_of(std::size_t pos) const
+		{
+			if (is_ascii() && pos <= m_length)
+				return pos;
+			return offset_slow(pos);
+		}
+
+		uchar_t operator[](std::size_t pos) const;
+
+		uchar_t at(std::size_t pos) const;
+
+		// Bytes of code points [pos, pos + len)
+		byte_string_view view(std::size_t pos, std::size_t len = npos) const;
+
+		utf8_string_t substr(std::size_t pos, std::size_t len = npos) const;
+
+		unicode_string_t to_unicode() const;
+
+		const_iterator begin() const noexcept;
+
+		const_iterator end() const noexcept;
+
+		utf8_string_t &operator+=(const utf8_string_t &rhs)
+		{
+			m_str += rhs.m_str;
+			m_length += rhs.m_length;
+			reset_index();
+			return *this;
+		}
+
+		friend utf8_string_t operator+(const utf8_string_t &lhs, const utf8_string_t &rhs)
+		{
+			byte_string_t str;
+			str.reserve(lhs.size() + rhs.size());
+			str.append(lhs.m_str).append(rhs.m_str);
+			return utf8_string_t(trusted_tag(), std::move(str), lhs.m_length + rhs.m_length);
+		}
+
+		// Byte order of UTF-8 is the order of code points
+		bool operator==(const utf8_string_t &other) const noexcept
+		{
+			return m_str == other.m_str;
+		}
+
+		bool operator!=(const utf8_string_t &other) const noexcept
+		{
+			return m_str != other.m_str;
+		}
+
+		bool operator<(const utf8_string_t &other) const noexcept
+		{
+			return m_str < other.m_str;
+		}
+
+		bool operator<=(const utf8_string_t &other) const noexcept
+		{
+			return m_str <= other.m_str;
+		}
+
+		bool operator>(const utf8_string_t &other) const noexcept
+		{
+			return m_str > other.m_str;
+		}
+
+		bool operator>=(const utf8_string_t &other) const noexcept
+		{
+			return m_str >= other.m_str;
+		}
+	};
+
+	// Decodes code points forward, content is valid so nothing is checked
+	class utf8_string_t::const_iterator final
+	{
+		const unsigned char *m_ptr = nullptr;
+
+	   public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = uchar_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const uchar_t *;
+		using reference = uchar_t;
+
+		const_iterator() noexcept = default;
+
+		explicit const_iterator(const char *ptr) noexcept : m_ptr(reinterpret_cast<const unsigned char *>(ptr)) {}
+
+		uchar_t operator*() const noexcept
+		{
+			unsigned char c = m_ptr[0];
+			if (c < 0x80)
+				return c;
+			else if (c < 0xE0)
+				return uchar_t(c & 0x1F) << 6 | (m_ptr[1] & 0x3F);
+			else if (c < 0xF0)
+				return uchar_t(c & 0x0F) << 12 | uchar_t(m_ptr[1] & 0x3F) << 6 | (m_ptr[2] & 0x3F);
+			else
+				return uchar_t(c & 0x07) << 18 | uchar_t(m_ptr[1] & 0x3F) << 12 | uchar_t(m_ptr[2] & 0x3F) << 6 | (m_ptr[3] & 0x3F);
+		}
+
+		const_iterator &operator++() noexcept
+		{
+			unsigned char c = *m_ptr;
+			m_ptr += c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+			return *this;
+		}
+
+		const_iterator operator++(int) noexcept
+		{
+			const_iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		bool operator==(const const_iterator &other) const noexcept
+		{
+			return m_ptr == other.m_ptr;
+		}
+
+		bool operator!=(const const_iterator &other) const noexcept
+		{
+			return m_ptr != other.m_ptr;
+		}
+	};
+
+	inline utf8_string_t::const_iterator utf8_string_t::begin() const noexcept
+	{
+		return const_iterator(m_str.data());
+	}
+
+	inline utf8_string_t::const_iterator utf8_string_t::end() const noexcept
+	{
+		return const_iterator(m_str.data() + m_str.size());
+	}
+
+	inline uchar_t utf8_string_t::operator[](std::size_t pos) const
+	{
+		return *const_iterator(m_str.data() + offset_of(pos));
+	}
+
+	inline uchar_t utf8_string_t::at(std::size_t pos) const
+	{
+		if (pos >= m_length)
+			throw std::out_of_range("cs::utf8_string_t::at");
+		return (*this)[pos];
+	}
+} // namespace cs
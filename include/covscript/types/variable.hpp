@@ -8,8 +8,10 @@
 #include <type_traits>
 #include <typeindex>
 #include <cstring>
+#include <cstddef>
 #include <cstdint>
 #include <bitset>
+#include <atomic>
 
 #ifndef COVSCRIPT_SVO_ALIGN_SIZE
 #define COVSCRIPT_SVO_ALIGN_SIZE COVSCRIPT_CACHELINE_SIZE
@@ -21,6 +23,61 @@ namespace cs
 	{
 	};
 
+	// Compact tags of builtin types, so hot checks and operators do not go through the operation table
+	enum class var_tag : std::uint8_t
+	{
+		null,
+		numeric,
+		boolean,
+		string,
+		other
+	};
+} // namespace cs
+
+namespace cs_impl
+{
+	template <typename T>
+	struct var_tag_of
+	{
+		static constexpr cs::var_tag value = cs::var_tag::other;
+	};
+
+	template <>
+	struct var_tag_of<cs::numeric_t>
+	{
+		static constexpr cs::var_tag value = cs::var_tag::numeric;
+	};
+
+	template <>
+	struct var_tag_of<cs::bool_t>
+	{
+		static constexpr cs::var_tag value = cs::var_tag::boolean;
+	};
+
+	template <>
+	struct var_tag_of<cs::byte_string_t>
+	{
+		static constexpr cs::var_tag value = cs::var_tag::string;
+	};
+
+	// Compact type ids, builtin types use the value of their tag
+	std::size_t alloc_type_id() noexcept;
+
+	template <typename T>
+	inline std::size_t get_type_id()
+	{
+		if constexpr (var_tag_of<T>::value != cs::var_tag::other)
+			return static_cast<std::size_t>(var_tag_of<T>::value);
+		else
+		{
+			static const std::size_t id = alloc_type_id();
+			return id;
+		}
+	}
+} // namespace cs_impl
+
+namespace cs
+{
 	template <std::size_t align_size, template <typename> class allocator_t>
 	class basic_var_borrower;
 
@@ -35,49 +92,96 @@ namespace cs
 			return allocator;
 		}
 
+		// Operation table pointer and type tag, padded to the storage alignment
+		static constexpr std::size_t header_size = (sizeof(void *) + sizeof(var_tag) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
 		static_assert(align_size % 8 == 0, "align_size must be a multiple of 8.");
-		static_assert(align_size >= std::max(alignof(std::max_align_t), 2 * sizeof(void *)),
+		static_assert(align_size > header_size,
 		              "align_size must greater than alignof(std::max_align_t).");
 
-		using aligned_storage_t = std::aligned_storage_t<align_size - (std::max) (alignof(std::max_align_t), 2 * sizeof(void *)), alignof(std::max_align_t)>;
+		using aligned_storage_t = std::aligned_storage_t<align_size - header_size, alignof(std::max_align_t)>;
 
-		enum class var_op
-		{
-			get,
-			copy,
-			move,
-			destroy,
-			rtti_type,
-			type_name,
-			to_integer,
-			to_string,
-			hash,
-			mark_reachable
-		};
+	   public:
+		using operators_type = cs_impl::operators::type;
+
+	   private:
+		template <typename T>
+		static basic_var_borrower<align_size, allocator_t> call_operator(operators_type, bool, const basic_var *, void *);
 
-		union var_op_result
+		using operator_t = basic_var_borrower<align_size, allocator_t> (*)(operators_type, bool, const basic_var *, void *);
+
+		/*
+		 * Per-type operation table
+		 * One constexpr instance exists for every stored type, basic_var only keeps a pointer to it.
+		 */
+		struct var_op_table
 		{
-			const std::type_info *_typeid;
-			integer_t _int;
-			std::size_t _hash;
-			void *_ptr;
-			var_op_result() : _ptr(nullptr) {}
+			const std::type_info *rtti_type;
+			void *(*get)(const basic_var *) noexcept;
+			void *(*get_unique)(basic_var *);
+			void (*copy)(const basic_var *, basic_var *);
+			void (*move)(basic_var *, basic_var *);
+			void (*destroy)(basic_var *) noexcept;
+			byte_string_view (*type_name)();
+			integer_t (*to_integer)(const basic_var *);
+			byte_string_borrower (*to_string)(const basic_var *);
+			void (*to_stream)(const basic_var *, byte_string_t &);
+			std::size_t (*hash)(const basic_var *);
+			void (*mark_reachable)(const basic_var *);
+			operator_t call_operator;
+			std::size_t (*type_id)();
+			// Storage can be moved by memcpy, move is skipped and the source is dropped without destroy
+			bool relocatable;
 		};
 
 		template <typename T>
 		struct var_op_svo_dispatcher
 		{
+			static constexpr bool relocatable = cs_impl::var_relocatable<T>::value;
+
 			template <typename... ArgsT>
 			static void construct(basic_var *val, ArgsT &&...args)
 			{
 				::new (&val->m_store.buffer) T(std::forward<ArgsT>(args)...);
 			}
-			static var_op_result dispatcher(var_op, const basic_var *, void *);
+
+			static inline T *get(const basic_var *val) noexcept
+			{
+				return reinterpret_cast<T *>(const_cast<aligned_storage_t *>(&val->m_store.buffer));
+			}
+
+			static inline T *get_unique(basic_var *val) noexcept
+			{
+				return get(val);
+			}
+
+			static inline T *get_mutable(basic_var *val) noexcept
+			{
+				return get(val);
+			}
+
+			static void copy(const basic_var *lhs, basic_var *rhs)
+			{
+				::new (&rhs->m_store.buffer) T(*get(lhs));
+			}
+
+			static void move(basic_var *lhs, basic_var *rhs)
+			{
+				::new (&rhs->m_store.buffer) T(std::move(*get(lhs)));
+				get(lhs)->~T();
+			}
+
+			static void destroy(basic_var *val) noexcept
+			{
+				get(val)->~T();
+			}
 		};
 
 		template <typename T>
 		struct var_op_heap_dispatcher
 		{
+			static constexpr bool relocatable = true;
+
 			template <typename... ArgsT>
 			static void construct(basic_var *val, ArgsT &&...args)
 			{
@@ -85,24 +189,309 @@ namespace cs
 				::new (ptr) T(std::forward<ArgsT>(args)...);
 				val->m_store.ptr = ptr;
 			}
-			static var_op_result dispatcher(var_op, const basic_var *, void *);
+
+			static inline T *get(const basic_var *val) noexcept
+			{
+				return static_cast<T *>(val->m_store.ptr);
+			}
+
+			static inline T *get_unique(basic_var *val) noexcept
+			{
+				return get(val);
+			}
+
+			static inline T *get_mutable(basic_var *val) noexcept
+			{
+				return get(val);
+			}
+
+			static void copy(const basic_var *lhs, basic_var *rhs)
+			{
+				T *ptr = get_allocator<T>().allocate(1);
+				::new (ptr) T(*get(lhs));
+				rhs->m_store.ptr = ptr;
+			}
+
+			static void move(basic_var *lhs, basic_var *rhs) noexcept
+			{
+				rhs->m_store.ptr = lhs->m_store.ptr;
+				lhs->m_store.ptr = nullptr;
+			}
+
+			static void destroy(basic_var *val) noexcept
+			{
+				T *ptr = get(val);
+				ptr->~T();
+				get_allocator<T>().deallocate(ptr, 1);
+			}
 		};
 
-		using dispatcher_t = var_op_result (*)(var_op, const basic_var *, void *);
+		template <typename T>
+		struct var_op_cow_dispatcher
+		{
+			struct payload
+			{
+				std::atomic<std::size_t> ref_count;
+				// Cleared once a mutable reference is handed out, copies of the payload are deep since then
+				bool shareable = true;
+				T data;
+
+				template <typename... ArgsT>
+				explicit payload(ArgsT &&...args) : ref_count(1), data(std::forward<ArgsT>(args)...) {}
+			};
+
+			static constexpr bool relocatable = true;
+
+			template <typename... ArgsT>
+			static void construct(basic_var *val, ArgsT &&...args)
+			{
+				payload *ptr = get_allocator<payload>().allocate(1);
+				::new (ptr) payload(std::forward<ArgsT>(args)...);
+				val->m_store.ptr = ptr;
+			}
+
+			static void release(payload *ptr) noexcept
+			{
+				if (ptr->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					ptr->~payload();
+					get_allocator<payload>().deallocate(ptr, 1);
+				}
+			}
+
+			static inline T *get(const basic_var *val) noexcept
+			{
+				return &static_cast<payload *>(val->m_store.ptr)->data;
+			}
+
+			// Mutable access not kept by the caller, clone the payload if it is still shared
+			static inline T *get_mutable(basic_var *val)
+			{
+				payload *ptr = static_cast<payload *>(val->m_store.ptr);
+				if (ptr->ref_count.load(std::memory_order_acquire) != 1)
+				{
+					construct(val, ptr->data);
+					release(ptr);
+				}
+				return get(val);
+			}
+
+			// Mutable reference for the caller, it may be written through after later copies
+			static inline T *get_unique(basic_var *val)
+			{
+				T *data = get_mutable(val);
+				static_cast<payload *>(val->m_store.ptr)->shareable = false;
+				return data;
+			}
+
+			static void copy(const basic_var *lhs, basic_var *rhs)
+			{
+				payload *ptr = static_cast<payload *>(lhs->m_store.ptr);
+				if (ptr->shareable)
+				{
+					ptr->ref_count.fetch_add(1, std::memory_order_relaxed);
+					rhs->m_store.ptr = ptr;
+				}
+				else
+					construct(rhs, ptr->data);
+			}
+
+			static void move(basic_var *lhs, basic_var *rhs) noexcept
+			{
+				rhs->m_store.ptr = lhs->m_store.ptr;
+				lhs->m_store.ptr = nullptr;
+			}
+
+			static void destroy(basic_var *val) noexcept
+			{
+				release(static_cast<payload *>(val->m_store.ptr));
+			}
+		};
 
 		template <typename T>
-		using dispatcher_class = std::conditional_t<(sizeof(T) > sizeof(aligned_storage_t)),
-		                                            var_op_heap_dispatcher<T>, var_op_svo_dispatcher<T>>;
+		using storage_dispatcher_class = std::conditional_t<cs_impl::var_cow<T>::value, var_op_cow_dispatcher<T>,
+		                                                    std::conditional_t<(sizeof(T) > sizeof(aligned_storage_t)),
+		                                                                       var_op_heap_dispatcher<T>, var_op_svo_dispatcher<T>>>;
+
+		/*
+		 * Keeps the hash next to the payload, after the inline value or the heap pointer
+		 * Zero means not computed. Once val() has handed out a mutable reference the value may change
+		 * behind our back, so the variable stops caching until it is copied into a fresh one.
+		 */
+		template <typename T, typename base_t>
+		struct var_op_hash_cache_dispatcher : base_t
+		{
+			using cache_t = std::atomic<std::size_t>;
 
-		using operators_type = cs_impl::operators::type;
+			static constexpr std::size_t uncached = ~std::size_t(0);
+
+			static constexpr std::size_t cache_offset = ((std::is_same_v<base_t, var_op_svo_dispatcher<T>> ? sizeof(T) : sizeof(void *)) + alignof(cache_t) - 1) & ~(alignof(cache_t) - 1);
+
+			static inline cache_t *cache(const basic_var *val) noexcept
+			{
+				return reinterpret_cast<cache_t *>(reinterpret_cast<unsigned char *>(const_cast<aligned_storage_t *>(&val->m_store.buffer)) + cache_offset);
+			}
+
+			template <typename... ArgsT>
+			static void construct(basic_var *val, ArgsT &&...args)
+			{
+				base_t::construct(val, std::forward<ArgsT>(args)...);
+				::new (cache(val)) cache_t(0);
+			}
+
+			static inline T *get_unique(basic_var *val)
+			{
+				T *ptr = base_t::get_unique(val);
+				cache(val)->store(uncached, std::memory_order_relaxed);
+				return ptr;
+			}
+
+			static inline T *get_mutable(basic_var *val)
+			{
+				T *ptr = base_t::get_mutable(val);
+				std::size_t code = cache(val)->load(std::memory_order_relaxed);
+				if (code != uncached)
+					cache(val)->store(0, std::memory_order_relaxed);
+				return ptr;
+			}
+
+			static void copy(const basic_var *lhs, basic_var *rhs)
+			{
+				base_t::copy(lhs, rhs);
+				std::size_t code = cache(lhs)->load(std::memory_order_relaxed);
+				::new (cache(rhs)) cache_t(code == uncached ? 0 : code);
+			}
+
+			static void move(basic_var *lhs, basic_var *rhs) noexcept
+			{
+				base_t::move(lhs, rhs);
+				::new (cache(rhs)) cache_t(cache(lhs)->load(std::memory_order_relaxed));
+			}
+
+			static std::size_t hash(const basic_var *val)
+			{
+				std::size_t code = cache(val)->load(std::memory_order_relaxed);
+				if (code == 0)
+				{
+					code = cs_impl::hash<T>(*base_t::get(val));
+					cache(val)->store(code, std::memory_order_relaxed);
+				}
+				else if (code == uncached)
+					code = cs_impl::hash<T>(*base_t::get(val));
+				return code;
+			}
+		};
 
 		template <typename T>
-		static basic_var_borrower<align_size, allocator_t> call_operator(operators_type, bool, const basic_var *, void *);
+		static constexpr bool hash_cached = cs_impl::var_hash_cache<T>::value &&
+		                                    var_op_hash_cache_dispatcher<T, storage_dispatcher_class<T>>::cache_offset + sizeof(std::size_t) <= sizeof(aligned_storage_t);
 
-		using operator_t = basic_var_borrower<align_size, allocator_t> (*)(operators_type, bool, const basic_var *, void *);
+		template <typename T>
+		using dispatcher_class = std::conditional_t<hash_cached<T>, var_op_hash_cache_dispatcher<T, storage_dispatcher_class<T>>, storage_dispatcher_class<T>>;
+
+	   public:
+		using binary_operator_t = basic_var (*)(const basic_var &, const basic_var &);
+
+	   private:
+		/*
+		 * Kernels of binary operators between different types
+		 * Indexed by operator and compact type ids of both operands, so lookup is two bounds checks.
+		 * Builtin kernels are registered in xtra_impl.cpp, extensions should register theirs before running scripts.
+		 */
+		class operator_registry final
+		{
+			static constexpr std::size_t operator_count = static_cast<std::size_t>(operators_type::call) + 1;
+			std::vector<std::vector<binary_operator_t>> m_kernels[operator_count];
+
+		   public:
+			operator_registry();
+
+			void add(operators_type op, std::size_t lhs_id, std::size_t rhs_id, binary_operator_t kernel)
+			{
+				auto &kernels = m_kernels[static_cast<std::size_t>(op)];
+				if (kernels.size() <= lhs_id)
+					kernels.resize(lhs_id + 1);
+				if (kernels[lhs_id].size() <= rhs_id)
+					kernels[lhs_id].resize(rhs_id + 1, nullptr);
+				kernels[lhs_id][rhs_id] = kernel;
+			}
+
+			inline binary_operator_t get(operators_type op, std::size_t lhs_id, std::size_t rhs_id) const noexcept
+			{
+				const auto &kernels = m_kernels[static_cast<std::size_t>(op)];
+				if (lhs_id < kernels.size() && rhs_id < kernels[lhs_id].size())
+					return kernels[lhs_id][rhs_id];
+				else
+					return nullptr;
+			}
+		};
+
+		static operator_registry &get_operator_registry()
+		{
+			static operator_registry registry;
+			return registry;
+		}
+
+		static inline bool is_binary_operator(operators_type op) noexcept
+		{
+			switch (op)
+			{
+				case operators_type::add:
+				case operators_type::sub:
+				case operators_type::mul:
+				case operators_type::div:
+				case operators_type::mod:
+				case operators_type::pow:
+				case operators_type::compare:
+				case operators_type::abocmp:
+				case operators_type::undcmp:
+				case operators_type::aepcmp:
+				case operators_type::ueqcmp:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		// Type-related operations, defined in xtra_impl.cpp
+		template <typename T>
+		struct var_op_dispatcher
+		{
+			static void *get(const basic_var *) noexcept;
+			static void *get_unique(basic_var *);
+			static byte_string_view type_name();
+			static integer_t to_integer(const basic_var *);
+			static byte_string_borrower to_string(const basic_var *);
+			static void to_stream(const basic_var *, byte_string_t &);
+			static std::size_t hash(const basic_var *);
+			static void mark_reachable(const basic_var *);
+
+			static constexpr var_op_table table = {
+			    &typeid(T),
+			    &get,
+			    &get_unique,
+			    &dispatcher_class<T>::copy,
+			    &dispatcher_class<T>::move,
+			    &dispatcher_class<T>::destroy,
+			    &type_name,
+			    &to_integer,
+			    &to_string,
+			    &to_stream,
+			    &hash,
+			    &mark_reachable,
+			    &call_operator<T>,
+			    &cs_impl::get_type_id<T>,
+			    dispatcher_class<T>::relocatable};
+		};
+
+		template <typename T>
+		static constexpr const var_op_table *table_of() noexcept
+		{
+			return &var_op_dispatcher<T>::table;
+		}
 
-		dispatcher_t m_dispatcher = nullptr;
-		operator_t m_operator = nullptr;
+		const var_op_table *m_table = nullptr;
+		var_tag m_tag = var_tag::null;
 		union store_impl
 		{
 			aligned_storage_t buffer;
@@ -112,56 +501,149 @@ namespace cs
 		} m_store;
 
 		template <typename T>
-		inline T &unchecked_get() noexcept
+		inline T &unchecked_get()
 		{
-			return *static_cast<T *>(m_dispatcher(var_op::get, this, nullptr)._ptr);
+			return *dispatcher_class<T>::get_unique(this);
 		}
 
 		template <typename T>
 		inline const T &unchecked_get() const noexcept
 		{
-			return *static_cast<const T *>(m_dispatcher(var_op::get, this, nullptr)._ptr);
+			return *dispatcher_class<T>::get(this);
+		}
+
+		// For writes in place by operators, the reference is not kept
+		template <typename T>
+		inline T &unchecked_get_mutable()
+		{
+			return *dispatcher_class<T>::get_mutable(this);
+		}
+
+		// Construct into an empty variable, no previous value to destroy
+		template <typename T, typename... ArgsT>
+		inline void init_store(ArgsT &&...args)
+		{
+			dispatcher_class<T>::construct(this, std::forward<ArgsT>(args)...);
+			m_table = table_of<T>();
+			m_tag = cs_impl::var_tag_of<T>::value;
 		}
 
 		template <typename T, typename... ArgsT>
 		inline void construct_store(ArgsT &&...args)
 		{
 			destroy_store();
-			m_dispatcher = &dispatcher_class<T>::dispatcher;
-			m_operator = &call_operator<T>;
-			dispatcher_class<T>::construct(this, std::forward<ArgsT>(args)...);
+			init_store<T>(std::forward<ArgsT>(args)...);
 		}
 
 		inline void destroy_store()
 		{
-			if (m_dispatcher != nullptr)
+			if (m_table != nullptr)
 			{
-				m_dispatcher(var_op::destroy, this, nullptr);
-				m_dispatcher = nullptr;
+				m_table->destroy(this);
+				m_table = nullptr;
+				m_tag = var_tag::null;
 			}
 		}
 
 		inline void copy_store(const basic_var &other)
 		{
 			destroy_store();
-			if (other.m_dispatcher != nullptr)
+			if (other.m_table != nullptr)
 			{
-				other.m_dispatcher(var_op::copy, &other, this);
-				m_dispatcher = other.m_dispatcher;
-				m_operator = other.m_operator;
+				other.m_table->copy(&other, this);
+				m_table = other.m_table;
+				m_tag = other.m_tag;
 			}
 		}
 
 		inline void move_store(basic_var &&other)
 		{
 			destroy_store();
-			if (other.m_dispatcher != nullptr)
+			if (other.m_table != nullptr)
+			{
+				// The move operation also releases the source storage
+				if (other.m_table->relocatable)
+					m_store = other.m_store;
+				else
+					other.m_table->move(&other, this);
+				m_table = other.m_table;
+				m_tag = other.m_tag;
+				other.m_table = nullptr;
+				other.m_tag = var_tag::null;
+			}
+		}
+
+		basic_var_borrower<align_size, allocator_t> operate_impl(operators_type op, bool is_const, const basic_var *rhs) const
+		{
+			// Builtin fast path, no indirect calls involved
+			if (m_tag == var_tag::numeric && rhs != nullptr && rhs->m_tag == var_tag::numeric)
+			{
+				const numeric_t &lhs_num = unchecked_get<numeric_t>(), &rhs_num = rhs->unchecked_get<numeric_t>();
+				switch (op)
+				{
+					case operators_type::add:
+						return lhs_num + rhs_num;
+					case operators_type::sub:
+						return lhs_num - rhs_num;
+					case operators_type::mul:
+						return lhs_num * rhs_num;
+					case operators_type::div:
+						return lhs_num / rhs_num;
+					case operators_type::mod:
+						return lhs_num % rhs_num;
+					case operators_type::pow:
+						return lhs_num ^ rhs_num;
+					case operators_type::compare:
+						return lhs_num == rhs_num;
+					case operators_type::abocmp:
+						return lhs_num > rhs_num;
+					case operators_type::undcmp:
+						return lhs_num < rhs_num;
+					case operators_type::aepcmp:
+						return lhs_num >= rhs_num;
+					case operators_type::ueqcmp:
+						return lhs_num <= rhs_num;
+					default:
+						break;
+				}
+			}
+			// Mixed types, use registered kernel if there is one
+			if (rhs != nullptr && m_table != rhs->m_table && is_binary_operator(op))
 			{
-				other.m_dispatcher(var_op::move, &other, this);
-				m_dispatcher = other.m_dispatcher;
-				m_operator = other.m_operator;
-				other.m_dispatcher = nullptr;
+				binary_operator_t kernel = get_operator_registry().get(op, type_id(), rhs->type_id());
+				if (kernel != nullptr)
+					return kernel(*this, *rhs);
 			}
+			switch (op)
+			{
+				case operators_type::compare:
+					return compare(*rhs);
+				case operators_type::abocmp:
+				case operators_type::undcmp:
+				case operators_type::aepcmp:
+				case operators_type::ueqcmp:
+					// Operand types of comparisons must be checked here
+					if (m_table != rhs->m_table)
+						throw lang_error("Comparison between different types.");
+					break;
+				default:
+					break;
+			}
+			if (m_table == nullptr)
+				throw runtime_error("Instance null variable.");
+			return m_table->call_operator(op, is_const, this, const_cast<basic_var *>(rhs));
+		}
+
+		// Values of different types are equal only if a registered kernel says so
+		bool compare_mixed(const basic_var &obj) const
+		{
+			if (m_table == nullptr || obj.m_table == nullptr)
+				return false;
+			binary_operator_t kernel = get_operator_registry().get(operators_type::compare, type_id(), obj.type_id());
+			if (kernel != nullptr)
+				return kernel(*this, obj).template const_val<bool_t>();
+			else
+				return false;
 		}
 
 	   public:
@@ -174,25 +656,41 @@ namespace cs
 		static basic_var make(ArgsT &&...args)
 		{
 			basic_var data;
-			data.construct_store<T>(std::forward<ArgsT>(args)...);
+			data.init_store<T>(std::forward<ArgsT>(args)...);
 			return data;
 		}
 
 		void swap(basic_var &other) noexcept
 		{
-			std::swap(m_dispatcher, other.m_dispatcher);
-			std::swap(m_operator, other.m_operator);
-			std::swap(m_store, other.m_store);
+			if (relocatable() && other.relocatable())
+			{
+				std::swap(m_table, other.m_table);
+				std::swap(m_tag, other.m_tag);
+				std::swap(m_store, other.m_store);
+			}
+			else
+			{
+				// Values pointing into their own storage must be moved by their move constructor
+				basic_var tmp(std::move(other));
+				other.move_store(std::move(*this));
+				move_store(std::move(tmp));
+			}
 		}
 
 		inline bool usable() const noexcept
 		{
-			return m_dispatcher != nullptr;
+			return m_table != nullptr;
 		}
 
 		inline bool is_null() const noexcept
 		{
-			return m_dispatcher == nullptr;
+			return m_table == nullptr;
+		}
+
+		// Whether this variable can be moved to another address by memcpy
+		inline bool relocatable() const noexcept
+		{
+			return m_table == nullptr || m_table->relocatable;
 		}
 
 		basic_var() noexcept = default;
@@ -201,12 +699,17 @@ namespace cs
 		          typename = std::enable_if_t<!std::is_same_v<store_t, basic_var>>>
 		basic_var(T &&val)
 		{
-			construct_store<store_t>(std::forward<T>(val));
+			init_store<store_t>(std::forward<T>(val));
 		}
 
 		basic_var(const basic_var &v)
 		{
-			copy_store(v);
+			if (v.m_table != nullptr)
+			{
+				v.m_table->copy(&v, this);
+				m_table = v.m_table;
+				m_tag = v.m_tag;
+			}
 		}
 
 		basic_var(basic_var &&v) noexcept
@@ -222,21 +725,47 @@ namespace cs
 		const std::type_info &type() const
 		{
 			if (usable())
-				return *m_dispatcher(var_op::rtti_type, this, nullptr)._typeid;
+				return *m_table->rtti_type;
 			else
 				return typeid(null_t);
 		}
 
+		var_tag tag() const noexcept
+		{
+			return m_tag;
+		}
+
+		std::size_t type_id() const
+		{
+			if (m_tag != var_tag::other)
+				return static_cast<std::size_t>(m_tag);
+			else
+				return m_table->type_id();
+		}
+
+		// Register kernel of binary operator between LhsT and RhsT, replaces previous one
+		template <typename LhsT, typename RhsT>
+		static void register_operator(operators_type op, binary_operator_t kernel)
+		{
+			if (!is_binary_operator(op))
+				throw internal_error("Only binary operators can be registered.");
+			get_operator_registry().add(op, cs_impl::get_type_id<cs_impl::var_storage_t<LhsT>>(),
+			                            cs_impl::get_type_id<cs_impl::var_storage_t<RhsT>>(), kernel);
+		}
+
 		template <typename T, typename store_t = cs_impl::var_storage_t<T>>
 		bool is_type_of() const
 		{
-			return usable() ? (m_dispatcher == &dispatcher_class<store_t>::dispatcher || type() == typeid(T)) : std::is_same_v<store_t, null_t>;
+			if constexpr (cs_impl::var_tag_of<store_t>::value != var_tag::other)
+				return m_tag == cs_impl::var_tag_of<store_t>::value;
+			else
+				return usable() ? (m_table == table_of<store_t>() || type() == typeid(T)) : std::is_same_v<store_t, null_t>;
 		}
 
 		integer_t to_integer() const
 		{
 			if (usable())
-				return m_dispatcher(var_op::to_integer, this, nullptr)._int;
+				return m_table->to_integer(this);
 			else
 				return 0;
 		}
@@ -249,19 +778,31 @@ namespace cs
 		byte_string_borrower to_string() const
 		{
 			if (usable())
-			{
-				byte_string_borrower borrower;
-				m_dispatcher(var_op::to_string, this, &borrower);
-				return borrower;
-			}
+				return m_table->to_string(this);
 			else
 				return "null";
 		}
 
+		// Appends the text of to_string() to out, containers write their elements in place
+		void to_stream(byte_string_t &out) const
+		{
+			if (m_tag == var_tag::numeric)
+				var_op_dispatcher<numeric_t>::to_stream(this, out);
+			else if (m_tag == var_tag::string)
+				out.append(unchecked_get<byte_string_t>());
+			else if (usable())
+				m_table->to_stream(this, out);
+			else
+				out.append("null");
+		}
+
 		std::size_t hash() const
 		{
-			if (usable())
-				return m_dispatcher(var_op::hash, this, nullptr)._hash;
+			// Hashes of strings are the most frequent, used by every lookup of maps keyed by names
+			if (m_tag == var_tag::string)
+				return var_op_dispatcher<byte_string_t>::hash(this);
+			else if (usable())
+				return m_table->hash(this);
 			else
 				return 0;
 		}
@@ -269,17 +810,13 @@ namespace cs
 		void gc_mark_reachable() const
 		{
 			if (usable())
-				m_dispatcher(var_op::mark_reachable, this, nullptr);
+				m_table->mark_reachable(this);
 		}
 
 		byte_string_borrower type_name() const
 		{
 			if (usable())
-			{
-				byte_string_borrower borrower;
-				m_dispatcher(var_op::type_name, this, &borrower);
-				return borrower;
-			}
+				return m_table->type_name();
 			else
 				return cs_impl::get_name_of_type<null_t>();
 		}
@@ -294,25 +831,33 @@ namespace cs
 		basic_var &operator=(basic_var &&obj) noexcept
 		{
 			if (&obj != this)
-			{
-				destroy_store();
-				m_dispatcher = obj.m_dispatcher;
-				m_operator = obj.m_operator;
-				m_store = obj.m_store;
-				obj.m_dispatcher = nullptr;
-			}
+				move_store(std::move(obj));
 			return *this;
 		}
 
 		bool compare(const basic_var &obj) const
 		{
-			if (usable() && m_dispatcher == obj.m_dispatcher)
-				return m_operator(operators_type::compare,
-				                  true, this, (void *) &obj)
-				    .data()
-				    ->template unchecked_get<bool_t>();
-			else
-				return obj.is_null();
+			if (m_tag != obj.m_tag)
+				return compare_mixed(obj);
+			switch (m_tag)
+			{
+				case var_tag::null:
+					return true;
+				case var_tag::numeric:
+					return unchecked_get<numeric_t>() == obj.unchecked_get<numeric_t>();
+				case var_tag::boolean:
+					return unchecked_get<bool_t>() == obj.unchecked_get<bool_t>();
+				case var_tag::string:
+					return unchecked_get<byte_string_t>() == obj.unchecked_get<byte_string_t>();
+				default:
+					if (m_table == obj.m_table)
+						return m_table->call_operator(operators_type::compare,
+						                              true, this, (void *) &obj)
+						    .const_data()
+						    ->template unchecked_get<bool_t>();
+					else
+						return compare_mixed(obj);
+			}
 		}
 
 		bool operator==(const basic_var &obj) const
@@ -325,12 +870,33 @@ namespace cs
 			return !compare(obj);
 		}
 
+		// Apply operator with this variable as left-hand side, rhs is omitted for unary operators
+		basic_var_borrower<align_size, allocator_t> operate(operators_type op, const basic_var *rhs = nullptr) const
+		{
+			return operate_impl(op, true, rhs);
+		}
+
+		basic_var_borrower<align_size, allocator_t> operate(operators_type op, const basic_var *rhs = nullptr)
+		{
+			return operate_impl(op, false, rhs);
+		}
+
 		template <typename T, typename store_t = cs_impl::var_storage_t<T>>
 		inline store_t &val()
 		{
-			if (m_dispatcher == &dispatcher_class<store_t>::dispatcher || type() == typeid(T))
-				return *static_cast<store_t *>(m_dispatcher(var_op::get, this, nullptr)._ptr);
-			else if (m_dispatcher == nullptr)
+			if constexpr (cs_impl::var_tag_of<store_t>::value != var_tag::other)
+			{
+				if (m_tag == cs_impl::var_tag_of<store_t>::value)
+					return unchecked_get<store_t>();
+			}
+			else
+			{
+				if (m_table == table_of<store_t>())
+					return unchecked_get<store_t>();
+				else if (m_table != nullptr && type() == typeid(T))
+					return *static_cast<store_t *>(m_table->get_unique(this));
+			}
+			if (m_table == nullptr)
 				throw runtime_error("Instance null variable.");
 			else
 				throw runtime_error("Instance variable with wrong type. Provided " +
@@ -340,9 +906,19 @@ namespace cs
 		template <typename T, typename store_t = cs_impl::var_storage_t<T>>
 		inline const store_t &const_val() const
 		{
-			if (m_dispatcher == &dispatcher_class<store_t>::dispatcher || type() == typeid(T))
-				return *static_cast<const store_t *>(m_dispatcher(var_op::get, this, nullptr)._ptr);
-			else if (m_dispatcher == nullptr)
+			if constexpr (cs_impl::var_tag_of<store_t>::value != var_tag::other)
+			{
+				if (m_tag == cs_impl::var_tag_of<store_t>::value)
+					return unchecked_get<store_t>();
+			}
+			else
+			{
+				if (m_table == table_of<store_t>())
+					return unchecked_get<store_t>();
+				else if (m_table != nullptr && type() == typeid(T))
+					return *static_cast<const store_t *>(m_table->get(this));
+			}
+			if (m_table == nullptr)
 				throw runtime_error("Instance null variable.");
 			else
 				throw runtime_error("Instance variable with wrong type. Provided " +
@@ -367,25 +943,17 @@ namespace cs
 	class basic_var_borrower final
 	{
 		using var = basic_var<align_size, allocator_t>;
-		using allocator_type = allocator_t<var>;
-
-		static allocator_type &get_allocator()
-		{
-			static allocator_type allocator;
-			return allocator;
-		}
 
 		const var *m_data = nullptr;
 		bool m_const = false;
 		bool m_own = false;
+		// Owned results are stored inline, so returning a temporary never allocates
+		var m_value;
 
 		void destroy()
 		{
-			if (m_own && m_data)
-			{
-				m_data->~basic_var();
-				get_allocator().deallocate(const_cast<var *>(m_data), 1);
-			}
+			if (m_own)
+				m_value = var();
 			m_data = nullptr;
 			m_const = false;
 			m_own = false;
@@ -398,28 +966,29 @@ namespace cs
 
 		basic_var_borrower(const var &val) noexcept : m_data(&val), m_const(true), m_own(false) {}
 
-		basic_var_borrower(var &&val) : m_own(true), m_const(false)
-		{
-			var *p = get_allocator().allocate(1);
-			::new (p) var(std::move(val));
-			m_data = p;
-		}
+		basic_var_borrower(var &&val) noexcept : m_data(&m_value), m_const(false), m_own(true), m_value(std::move(val)) {}
 
-		basic_var_borrower(const basic_var_borrower &other) : m_own(other.m_own), m_const(other.m_const)
+		basic_var_borrower(const basic_var_borrower &other) : m_const(other.m_const), m_own(other.m_own)
 		{
 			if (other.m_own)
 			{
-				var *p = get_allocator().allocate(1);
-				::new (p) var(*other.m_data);
-				m_data = p;
+				m_value = other.m_value;
+				m_data = &m_value;
 			}
 			else
 				m_data = other.m_data;
 		}
 
 		basic_var_borrower(basic_var_borrower &&other) noexcept
-		    : m_data(other.m_data), m_const(other.m_const), m_own(other.m_own)
+		    : m_const(other.m_const), m_own(other.m_own)
 		{
+			if (other.m_own)
+			{
+				m_value = std::move(other.m_value);
+				m_data = &m_value;
+			}
+			else
+				m_data = other.m_data;
 			other.m_data = nullptr;
 			other.m_const = false;
 			other.m_own = false;
@@ -427,17 +996,9 @@ namespace cs
 
 		template <typename T, typename store_t = cs_impl::var_storage_t<T>,
 		          typename = std::enable_if_t<!std::is_same_v<store_t, var> && !std::is_same_v<store_t, basic_var_borrower>>>
-		basic_var_borrower(T &&val) : m_own(true), m_const(false)
-		{
-			var *p = get_allocator().allocate(1);
-			::new (p) var(std::forward<T>(val));
-			m_data = p;
-		}
+		basic_var_borrower(T &&val) : m_data(&m_value), m_const(false), m_own(true), m_value(std::forward<T>(val)) {}
 
-		~basic_var_borrower()
-		{
-			destroy();
-		}
+		~basic_var_borrower() = default;
 
 		basic_var_borrower &operator=(const basic_var_borrower &other)
 		{
@@ -448,9 +1009,8 @@ namespace cs
 				m_const = other.m_const;
 				if (other.m_own)
 				{
-					var *p = get_allocator().allocate(1);
-					::new (p) var(*other.m_data);
-					m_data = p;
+					m_value = other.m_value;
+					m_data = &m_value;
 				}
 				else
 					m_data = other.m_data;
@@ -463,9 +1023,15 @@ namespace cs
 			if (this != &other)
 			{
 				destroy();
-				m_data = other.m_data;
 				m_const = other.m_const;
 				m_own = other.m_own;
+				if (other.m_own)
+				{
+					m_value = std::move(other.m_value);
+					m_data = &m_value;
+				}
+				else
+					m_data = other.m_data;
 				other.m_data = nullptr;
 				other.m_const = false;
 				other.m_own = false;
@@ -511,6 +1077,27 @@ namespace cs
 		}
 	};
 
+	// Variables are relocated with a single memmove unless one of them stores a non-relocatable value
+	template <std::size_t align_size, template <typename> class allocator_t>
+	struct relocator<basic_var<align_size, allocator_t>>
+	{
+		using var = basic_var<align_size, allocator_t>;
+
+		static void relocate(var *src, var *dst, std::size_t n) noexcept
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				if (!src[i].relocatable())
+				{
+					relocate_by_move(src, dst, n);
+					return;
+				}
+			}
+			if (n > 0)
+				std::memmove(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(var));
+		}
+	};
+
 	using var = basic_var<COVSCRIPT_SVO_ALIGN_SIZE, default_allocator>;
 	using var_borrower = basic_var_borrower<COVSCRIPT_SVO_ALIGN_SIZE, default_allocator>;
 } // namespace cs
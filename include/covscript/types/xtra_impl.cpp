@@ -2,6 +2,29 @@
 #pragma once
 #include <covscript/types/types.hpp>
 
+// std::ostream &operator<<(std::ostream &, const cs::var &);
+
+namespace std
+{
+	template <>
+	struct hash<cs::var>
+	{
+		std::size_t operator()(const cs::var &val) const
+		{
+			return val.hash();
+		}
+	};
+
+	template <>
+	struct hash<cs::compact_var>
+	{
+		std::size_t operator()(const cs::compact_var &val) const
+		{
+			return val.hash();
+		}
+	};
+} // namespace std
+
 namespace cs_impl
 {
 	template <>
@@ -22,6 +45,24 @@ namespace cs_impl
 		return cs::byte_string_view(str);
 	}
 
+	template <>
+	cs::byte_string_borrower to_string<cs::byte_rope_t>(const cs::byte_rope_t &str)
+	{
+		return str.borrow();
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::utf8_string_t>(const cs::utf8_string_t &str)
+	{
+		return cs::byte_string_view(str.str());
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::symbol_t>(const cs::symbol_t &sym)
+	{
+		return cs::byte_string_view(sym.data(), sym.view().size());
+	}
+
 	template <>
 	cs::byte_string_borrower to_string<cs::unicode_string_t>(const cs::unicode_string_t &str)
 	{
@@ -37,6 +78,63 @@ namespace cs_impl
 			return "false";
 	}
 
+	template <>
+	void to_stream<cs::numeric_t>(cs::byte_string_t &out, const cs::numeric_t &val)
+	{
+		char buff[cs::numeric_t::max_chars];
+		std::to_chars_result res = val.to_chars(buff, buff + sizeof(buff));
+		if (res.ec == std::errc())
+			out.append(buff, res.ptr);
+		else
+			out.append(val.to_string());
+	}
+
+	template <>
+	void to_stream<bool>(cs::byte_string_t &out, const bool &v)
+	{
+		out.append(v ? "true" : "false");
+	}
+
+	template <>
+	std::size_t hash<cs::byte_string_t>(const cs::byte_string_t &str)
+	{
+		return hash_bytes(str.data(), str.size());
+	}
+
+	// Same as the hash of string with equal content
+	template <>
+	std::size_t hash<cs::byte_rope_t>(const cs::byte_rope_t &str)
+	{
+		cs::byte_string_view view = str.view();
+		return hash_bytes(view.data(), view.size());
+	}
+
+	template <>
+	std::size_t hash<cs::utf8_string_t>(const cs::utf8_string_t &str)
+	{
+		return hash_bytes(str.data(), str.size());
+	}
+
+	template <>
+	struct var_hash_cache<cs::byte_string_t>
+	{
+		static constexpr bool value = true;
+	};
+
+	// Bigint payload of numeric is shared by pointer, not referring back to the numeric
+	template <typename float_type>
+	struct var_relocatable<cs::basic_numeric<float_type>>
+	{
+		static constexpr bool value = true;
+	};
+
+	// Ropes only refer to the shared node
+	template <typename CharT>
+	struct var_relocatable<cs::basic_rope<CharT>>
+	{
+		static constexpr bool value = true;
+	};
+
 	template <int N>
 	struct var_storage<char[N]>
 	{
@@ -49,6 +147,51 @@ namespace cs_impl
 		using type = std::type_index;
 	};
 
+#ifdef COVSCRIPT_COW_CONTAINERS
+	// Copies of containers and strings share payload until written
+	template <>
+	struct var_cow<cs::byte_string_t>
+	{
+		static constexpr bool value = true;
+	};
+
+	template <>
+	struct var_cow<cs::list>
+	{
+		static constexpr bool value = true;
+	};
+
+	template <>
+	struct var_cow<cs::fwd_list>
+	{
+		static constexpr bool value = true;
+	};
+
+	template <>
+	struct var_cow<cs::array>
+	{
+		static constexpr bool value = true;
+	};
+
+	template <>
+	struct var_cow<cs::fwd_array>
+	{
+		static constexpr bool value = true;
+	};
+
+	template <>
+	struct var_cow<cs::hash_map>
+	{
+		static constexpr bool value = true;
+	};
+
+	template <>
+	struct var_cow<cs::hash_set>
+	{
+		static constexpr bool value = true;
+	};
+#endif
+
 	template <>
 	void mark_reachable<cs::list>(const cs::list &data)
 	{
@@ -94,27 +237,221 @@ namespace cs_impl
 			it.gc_mark_reachable();
 	}
 
+	template <>
+	void mark_reachable<cs::compact_array>(const cs::compact_array &data)
+	{
+		for (auto &it : data)
+			it.gc_mark_reachable();
+	}
+
 	template <>
 	void mark_reachable<cs::pair>(const cs::pair &data)
 	{
 		data.first.gc_mark_reachable();
 		data.second.gc_mark_reachable();
 	}
-} // namespace cs_impl
 
-// std::ostream &operator<<(std::ostream &, const cs::var &);
+	/*
+	 * Containers are written in the literal syntax of CovScript, {a, b} for sequences, k:v for pairs.
+	 * Nested strings are quoted, everything goes into one buffer through basic_var::to_stream.
+	 */
+	static void stream_quoted(cs::byte_string_t &out, cs::byte_string_view str)
+	{
+		out.push_back('"');
+		for (char ch : str)
+		{
+			switch (ch)
+			{
+				case '"':
+					out.append("\\\"");
+					break;
+				case '\\':
+					out.append("\\\\");
+					break;
+				case '\n':
+					out.append("\\n");
+					break;
+				case '\t':
+					out.append("\\t");
+					break;
+				case '\r':
+					out.append("\\r");
+					break;
+				case '\0':
+					out.append("\\0");
+					break;
+				case '\a':
+					out.append("\\a");
+					break;
+				case '\b':
+					out.append("\\b");
+					break;
+				case '\f':
+					out.append("\\f");
+					break;
+				case '\v':
+					out.append("\\v");
+					break;
+				default:
+					// Other control bytes as two hex digits, bytes of UTF-8 sequences are kept
+					if (static_cast<unsigned char>(ch) < 0x20 || ch == 0x7f)
+					{
+						static constexpr char digits[] = "0123456789abcdef";
+						out.append("\\x");
+						out.push_back(digits[static_cast<unsigned char>(ch) >> 4]);
+						out.push_back(digits[static_cast<unsigned char>(ch) & 0xf]);
+					}
+					else
+						out.push_back(ch);
+			}
+		}
+		out.push_back('"');
+	}
 
-namespace std
-{
-	template <>
-	struct hash<cs::var>
+	static void stream_element(cs::byte_string_t &out, const cs::var &val)
 	{
-		std::size_t operator()(const cs::var &val) const
+		if (val.tag() == cs::var_tag::string)
+			stream_quoted(out, val.const_val<cs::string>());
+		else
+			val.to_stream(out);
+	}
+
+	static void stream_element(cs::byte_string_t &out, const cs::compact_var &val)
+	{
+		if (const cs::var *boxed = val.boxed())
+			stream_element(out, *boxed);
+		else
+			val.to_var().to_stream(out);
+	}
+
+	// Pairs, and entries of hash_map
+	template <typename key_t>
+	static void stream_element(cs::byte_string_t &out, const std::pair<key_t, cs::var> &val)
+	{
+		stream_element(out, val.first);
+		out.push_back(':');
+		stream_element(out, val.second);
+	}
+
+	template <typename T>
+	static void stream_sequence(cs::byte_string_t &out, const T &data)
+	{
+		out.push_back('{');
+		bool first = true;
+		for (auto &it : data)
 		{
-			return val.hash();
+			if (!first)
+				out.append(", ");
+			first = false;
+			stream_element(out, it);
 		}
-	};
-} // namespace std
+		out.push_back('}');
+	}
+
+	template <typename T>
+	static cs::byte_string_borrower stream_to_string(const T &data)
+	{
+		cs::byte_string_t out;
+		to_stream(out, data);
+		return out;
+	}
+
+	template <>
+	void to_stream<cs::list>(cs::byte_string_t &out, const cs::list &data)
+	{
+		stream_sequence(out, data);
+	}
+
+	template <>
+	void to_stream<cs::fwd_list>(cs::byte_string_t &out, const cs::fwd_list &data)
+	{
+		stream_sequence(out, data);
+	}
+
+	template <>
+	void to_stream<cs::array>(cs::byte_string_t &out, const cs::array &data)
+	{
+		stream_sequence(out, data);
+	}
+
+	template <>
+	void to_stream<cs::fwd_array>(cs::byte_string_t &out, const cs::fwd_array &data)
+	{
+		stream_sequence(out, data);
+	}
+
+	template <>
+	void to_stream<cs::hash_map>(cs::byte_string_t &out, const cs::hash_map &data)
+	{
+		stream_sequence(out, data);
+	}
+
+	template <>
+	void to_stream<cs::hash_set>(cs::byte_string_t &out, const cs::hash_set &data)
+	{
+		stream_sequence(out, data);
+	}
+
+	template <>
+	void to_stream<cs::compact_array>(cs::byte_string_t &out, const cs::compact_array &data)
+	{
+		stream_sequence(out, data);
+	}
+
+	template <>
+	void to_stream<cs::pair>(cs::byte_string_t &out, const cs::pair &data)
+	{
+		stream_element(out, data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::list>(const cs::list &data)
+	{
+		return stream_to_string(data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::fwd_list>(const cs::fwd_list &data)
+	{
+		return stream_to_string(data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::array>(const cs::array &data)
+	{
+		return stream_to_string(data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::fwd_array>(const cs::fwd_array &data)
+	{
+		return stream_to_string(data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::hash_map>(const cs::hash_map &data)
+	{
+		return stream_to_string(data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::hash_set>(const cs::hash_set &data)
+	{
+		return stream_to_string(data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::compact_array>(const cs::compact_array &data)
+	{
+		return stream_to_string(data);
+	}
+
+	template <>
+	cs::byte_string_borrower to_string<cs::pair>(const cs::pair &data)
+	{
+		return stream_to_string(data);
+	}
+} // namespace cs_impl
 
 namespace cs_impl::operators
 {
@@ -250,106 +587,294 @@ namespace cs_impl::operators
 		throw cs::lang_error(cs::byte_string_t("Type ") + get_name_of_type<T>().data() + " does not support data->member operator.");
 	}
 
+	// Member access by interned symbol, falls back to access by name
+	template <typename var_borrower, typename T>
+	static var_borrower access(T &data, const cs::symbol_t &member)
+	{
+		return access<var_borrower>(data, member.view());
+	}
+
+	template <typename var_borrower, typename T>
+	static var_borrower access(const T &data, const cs::symbol_t &member)
+	{
+		return access<var_borrower>(data, member.view());
+	}
+
+	template <typename var_borrower, typename T>
+	static var_borrower arrow(T &data, const cs::symbol_t &member)
+	{
+		return arrow<var_borrower>(data, member.view());
+	}
+
+	template <typename var_borrower, typename T>
+	static var_borrower arrow(const T &data, const cs::symbol_t &member)
+	{
+		return arrow<var_borrower>(data, member.view());
+	}
+
 	template <typename var_borrower, typename T>
 	static var_borrower call(const T &func, cs::fwd_array &args)
 	{
 		throw cs::lang_error(cs::byte_string_t("Type ") + get_name_of_type<T>().data() + " does not support func(...) operator.");
 	}
+
+	// Builtin types, keep consistent with the fast path in basic_var::operate
+	template <typename var>
+	static var add(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs + rhs;
+	}
+
+	template <typename var>
+	static var sub(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs - rhs;
+	}
+
+	template <typename var>
+	static var mul(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs * rhs;
+	}
+
+	template <typename var>
+	static var div(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs / rhs;
+	}
+
+	template <typename var>
+	static var mod(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs % rhs;
+	}
+
+	template <typename var>
+	static var pow(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs ^ rhs;
+	}
+
+	template <typename var>
+	static var minus(const cs::numeric_t &val)
+	{
+		return -val;
+	}
+
+	static void selfinc(cs::numeric_t &val)
+	{
+		++val;
+	}
+
+	static void selfdec(cs::numeric_t &val)
+	{
+		--val;
+	}
+
+	static cs::bool_t abocmp(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs > rhs;
+	}
+
+	static cs::bool_t undcmp(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs < rhs;
+	}
+
+	static cs::bool_t aepcmp(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs >= rhs;
+	}
+
+	static cs::bool_t ueqcmp(const cs::numeric_t &lhs, const cs::numeric_t &rhs)
+	{
+		return lhs <= rhs;
+	}
+
+	template <typename var>
+	static var add(const cs::byte_string_t &lhs, const cs::byte_string_t &rhs)
+	{
+		return lhs + rhs;
+	}
+
+	static cs::bool_t abocmp(const cs::byte_string_t &lhs, const cs::byte_string_t &rhs)
+	{
+		return lhs > rhs;
+	}
+
+	static cs::bool_t undcmp(const cs::byte_string_t &lhs, const cs::byte_string_t &rhs)
+	{
+		return lhs < rhs;
+	}
+
+	static cs::bool_t aepcmp(const cs::byte_string_t &lhs, const cs::byte_string_t &rhs)
+	{
+		return lhs >= rhs;
+	}
+
+	static cs::bool_t ueqcmp(const cs::byte_string_t &lhs, const cs::byte_string_t &rhs)
+	{
+		return lhs <= rhs;
+	}
+
+	template <typename var>
+	static var add(const cs::byte_rope_t &lhs, const cs::byte_rope_t &rhs)
+	{
+		return lhs + rhs;
+	}
+
+	static cs::bool_t abocmp(const cs::byte_rope_t &lhs, const cs::byte_rope_t &rhs)
+	{
+		return lhs > rhs;
+	}
+
+	static cs::bool_t undcmp(const cs::byte_rope_t &lhs, const cs::byte_rope_t &rhs)
+	{
+		return lhs < rhs;
+	}
+
+	static cs::bool_t aepcmp(const cs::byte_rope_t &lhs, const cs::byte_rope_t &rhs)
+	{
+		return lhs >= rhs;
+	}
+
+	static cs::bool_t ueqcmp(const cs::byte_rope_t &lhs, const cs::byte_rope_t &rhs)
+	{
+		return lhs <= rhs;
+	}
+
+	template <typename var>
+	static var add(const cs::utf8_string_t &lhs, const cs::utf8_string_t &rhs)
+	{
+		return lhs + rhs;
+	}
+
+	static cs::bool_t abocmp(const cs::utf8_string_t &lhs, const cs::utf8_string_t &rhs)
+	{
+		return lhs > rhs;
+	}
+
+	static cs::bool_t undcmp(const cs::utf8_string_t &lhs, const cs::utf8_string_t &rhs)
+	{
+		return lhs < rhs;
+	}
+
+	static cs::bool_t aepcmp(const cs::utf8_string_t &lhs, const cs::utf8_string_t &rhs)
+	{
+		return lhs >= rhs;
+	}
+
+	static cs::bool_t ueqcmp(const cs::utf8_string_t &lhs, const cs::utf8_string_t &rhs)
+	{
+		return lhs <= rhs;
+	}
 } // namespace cs_impl::operators
 
+template <std::size_t align_size, template <typename> class allocator_t>
+cs::basic_var<align_size, allocator_t>::operator_registry::operator_registry()
+{
+	// String concatenation with builtin values
+	add(operators_type::add, cs_impl::get_type_id<byte_string_t>(), cs_impl::get_type_id<numeric_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<byte_string_t>() + rhs.template const_val<numeric_t>().to_string();
+	    });
+	add(operators_type::add, cs_impl::get_type_id<byte_string_t>(), cs_impl::get_type_id<bool_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<byte_string_t>() + (rhs.template const_val<bool_t>() ? "true" : "false");
+	    });
+	// Concatenation with ropes stays a rope, strings are copied into a leaf once
+	add(operators_type::add, cs_impl::get_type_id<byte_rope_t>(), cs_impl::get_type_id<byte_string_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<byte_rope_t>() + byte_rope_t(rhs.template const_val<byte_string_t>());
+	    });
+	add(operators_type::add, cs_impl::get_type_id<byte_string_t>(), cs_impl::get_type_id<byte_rope_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return byte_rope_t(lhs.template const_val<byte_string_t>()) + rhs.template const_val<byte_rope_t>();
+	    });
+	add(operators_type::add, cs_impl::get_type_id<byte_rope_t>(), cs_impl::get_type_id<numeric_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<byte_rope_t>() + byte_rope_t(rhs.template const_val<numeric_t>().to_string());
+	    });
+	add(operators_type::compare, cs_impl::get_type_id<byte_rope_t>(), cs_impl::get_type_id<byte_string_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<byte_rope_t>().view() == rhs.template const_val<byte_string_t>();
+	    });
+	add(operators_type::compare, cs_impl::get_type_id<byte_string_t>(), cs_impl::get_type_id<byte_rope_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<byte_string_t>() == rhs.template const_val<byte_rope_t>().view();
+	    });
+	// Strings joining a UTF-8 string are validated once
+	add(operators_type::add, cs_impl::get_type_id<utf8_string_t>(), cs_impl::get_type_id<byte_string_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<utf8_string_t>() + utf8_string_t(rhs.template const_val<byte_string_t>());
+	    });
+	add(operators_type::compare, cs_impl::get_type_id<utf8_string_t>(), cs_impl::get_type_id<byte_string_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<utf8_string_t>().str() == rhs.template const_val<byte_string_t>();
+	    });
+	add(operators_type::compare, cs_impl::get_type_id<byte_string_t>(), cs_impl::get_type_id<utf8_string_t>(),
+	    [](const basic_var &lhs, const basic_var &rhs) -> basic_var {
+		    return lhs.template const_val<byte_string_t>() == rhs.template const_val<utf8_string_t>().str();
+	    });
+}
+
 template <std::size_t align_size, template <typename> class allocator_t>
 template <typename T>
-typename cs::basic_var<align_size, allocator_t>::var_op_result cs::basic_var<align_size, allocator_t>::var_op_svo_dispatcher<T>::dispatcher(
-    cs::basic_var<align_size, allocator_t>::var_op op, const cs::basic_var<align_size, allocator_t> *lhs, void *rhs)
+void *cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::get(const cs::basic_var<align_size, allocator_t> *val) noexcept
 {
-	const T *ptr = reinterpret_cast<const T *>(&lhs->m_store.buffer);
-	var_op_result result;
-	switch (op)
-	{
-		case var_op::get:
-			result._ptr = const_cast<T *>(ptr);
-			break;
-		case var_op::copy:
-			::new (&static_cast<basic_var *>(rhs)->m_store.buffer) T(*ptr);
-			break;
-		case var_op::move:
-			::new (&static_cast<basic_var *>(rhs)->m_store.buffer) T(std::move(*ptr));
-			break;
-		case var_op::destroy:
-			ptr->~T();
-			break;
-		case var_op::rtti_type:
-			result._typeid = &typeid(T);
-			break;
-		case var_op::type_name:
-			*static_cast<byte_string_borrower *>(rhs) = cs_impl::get_name_of_type<T>();
-			break;
-		case var_op::to_integer:
-			result._int = cs_impl::to_integer(*ptr);
-			break;
-		case var_op::to_string:
-			*static_cast<byte_string_borrower *>(rhs) = cs_impl::to_string(*ptr);
-			break;
-		case var_op::hash:
-			result._hash = cs_impl::hash<T>(*ptr);
-			break;
-		case var_op::mark_reachable:
-			cs_impl::mark_reachable<T>(*ptr);
-			break;
-	}
-	return result;
+	return dispatcher_class<T>::get(val);
 }
 
 template <std::size_t align_size, template <typename> class allocator_t>
 template <typename T>
-typename cs::basic_var<align_size, allocator_t>::var_op_result cs::basic_var<align_size, allocator_t>::var_op_heap_dispatcher<T>::dispatcher(
-    cs::basic_var<align_size, allocator_t>::var_op op, const cs::basic_var<align_size, allocator_t> *lhs, void *rhs)
+void *cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::get_unique(cs::basic_var<align_size, allocator_t> *val)
 {
-	const T *ptr = static_cast<const T *>(lhs->m_store.ptr);
-	var_op_result result;
-	switch (op)
-	{
-		case var_op::get:
-			result._ptr = const_cast<T *>(ptr);
-			break;
-		case var_op::copy:
-		{
-			T *nptr = get_allocator<T>().allocate(1);
-			::new (nptr) T(*ptr);
-			static_cast<basic_var *>(rhs)->m_store.ptr = nptr;
-			break;
-		}
-		case var_op::move:
-		{
-			T *nptr = get_allocator<T>().allocate(1);
-			::new (nptr) T(std::move(*ptr));
-			static_cast<basic_var *>(rhs)->m_store.ptr = nptr;
-			break;
-		}
-		case var_op::destroy:
-			ptr->~T();
-			get_allocator<T>().deallocate(const_cast<T *>(ptr), 1);
-			break;
-		case var_op::rtti_type:
-			result._typeid = &typeid(T);
-			break;
-		case var_op::type_name:
-			*static_cast<byte_string_borrower *>(rhs) = cs_impl::get_name_of_type<T>();
-			break;
-		case var_op::to_integer:
-			result._int = cs_impl::to_integer(*ptr);
-			break;
-		case var_op::to_string:
-			*static_cast<byte_string_borrower *>(rhs) = cs_impl::to_string(*ptr);
-			break;
-		case var_op::hash:
-			result._hash = cs_impl::hash<T>(*ptr);
-			break;
-		case var_op::mark_reachable:
-			cs_impl::mark_reachable<T>(*ptr);
-			break;
-	}
-	return result;
+	return dispatcher_class<T>::get_unique(val);
+}
+
+template <std::size_t align_size, template <typename> class allocator_t>
+template <typename T>
+cs::byte_string_view cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::type_name()
+{
+	return cs_impl::get_name_of_type<T>();
+}
+
+template <std::size_t align_size, template <typename> class allocator_t>
+template <typename T>
+cs::integer_t cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::to_integer(const cs::basic_var<align_size, allocator_t> *val)
+{
+	return cs_impl::to_integer(val->template unchecked_get<T>());
+}
+
+template <std::size_t align_size, template <typename> class allocator_t>
+template <typename T>
+cs::byte_string_borrower cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::to_string(const cs::basic_var<align_size, allocator_t> *val)
+{
+	return cs_impl::to_string(val->template unchecked_get<T>());
+}
+
+template <std::size_t align_size, template <typename> class allocator_t>
+template <typename T>
+void cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::to_stream(const cs::basic_var<align_size, allocator_t> *val, cs::byte_string_t &out)
+{
+	cs_impl::to_stream(out, val->template unchecked_get<T>());
+}
+
+template <std::size_t align_size, template <typename> class allocator_t>
+template <typename T>
+std::size_t cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::hash(const cs::basic_var<align_size, allocator_t> *val)
+{
+	if constexpr (hash_cached<T>)
+		return dispatcher_class<T>::hash(val);
+	else
+		return cs_impl::hash<T>(val->template unchecked_get<T>());
+}
+
+template <std::size_t align_size, template <typename> class allocator_t>
+template <typename T>
+void cs::basic_var<align_size, allocator_t>::var_op_dispatcher<T>::mark_reachable(const cs::basic_var<align_size, allocator_t> *val)
+{
+	cs_impl::mark_reachable<T>(val->template unchecked_get<T>());
 }
 
 template <std::size_t align_size, template <typename> class allocator_t>
@@ -378,13 +903,13 @@ cs::basic_var_borrower<align_size, allocator_t> cs::basic_var<align_size, alloca
 			return cs_impl::operators::escape<borrower_t>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>());
 		case operators_type::selfinc:
 			if (!is_const)
-				cs_impl::operators::selfinc(const_cast<basic_var *>(lhs)->template unchecked_get<T>());
+				cs_impl::operators::selfinc(const_cast<basic_var *>(lhs)->template unchecked_get_mutable<T>());
 			else
 				throw lang_error("Operator ++ requires non-const access to variable.");
 			break;
 		case operators_type::selfdec:
 			if (!is_const)
-				cs_impl::operators::selfdec(const_cast<basic_var *>(lhs)->template unchecked_get<T>());
+				cs_impl::operators::selfdec(const_cast<basic_var *>(lhs)->template unchecked_get_mutable<T>());
 			else
 				throw lang_error("Operator -- requires non-const access to variable.");
 			break;
@@ -403,11 +928,20 @@ cs::basic_var_borrower<align_size, allocator_t> cs::basic_var<align_size, alloca
 			return cs_impl::operators::index<borrower_t, basic_var>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>(),
 			                                                        *static_cast<const basic_var *>(rhs));
 		case operators_type::access:
-			return cs_impl::operators::access<borrower_t>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>(),
-			                                              static_cast<const basic_var *>(rhs)->const_val<byte_string_t>());
+			// Interned member names are preferred, plain strings are kept for compatibility
+			if (static_cast<const basic_var *>(rhs)->template is_type_of<symbol_t>())
+				return cs_impl::operators::access<borrower_t>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>(),
+				                                              static_cast<const basic_var *>(rhs)->template unchecked_get<symbol_t>());
+			else
+				return cs_impl::operators::access<borrower_t>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>(),
+				                                              static_cast<const basic_var *>(rhs)->const_val<byte_string_t>());
 		case operators_type::arrow:
-			return cs_impl::operators::arrow<borrower_t>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>(),
-			                                             static_cast<const basic_var *>(rhs)->const_val<byte_string_t>());
+			if (static_cast<const basic_var *>(rhs)->template is_type_of<symbol_t>())
+				return cs_impl::operators::arrow<borrower_t>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>(),
+				                                             static_cast<const basic_var *>(rhs)->template unchecked_get<symbol_t>());
+			else
+				return cs_impl::operators::arrow<borrower_t>((is_const ? lhs : const_cast<basic_var *>(lhs))->template unchecked_get<T>(),
+				                                             static_cast<const basic_var *>(rhs)->const_val<byte_string_t>());
 		case operators_type::call:
 			return cs_impl::operators::call<borrower_t>((lhs)->template unchecked_get<T>(), *static_cast<fwd_array *>(rhs));
 	}
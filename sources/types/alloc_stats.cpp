@@ -0,0 +1,104 @@
+#include <covscript/types/alloc_stats.hpp>
+#ifdef COVSCRIPT_ALLOC_STATS
+#include <covscript/types/support.hpp>
+#include <algorithm>
+#include <cstdio>
+
+namespace cs::alloc_stats
+{
+	namespace
+	{
+		// Records are pushed once and never removed, so readers walk the list without locking
+		std::atomic<type_counters *> &get_registry()
+		{
+			static std::atomic<type_counters *> head{nullptr};
+			return head;
+		}
+
+		void append_escaped(std::string &out, const std::string &str)
+		{
+			for (char ch : str)
+			{
+				if (ch == '"' || ch == '\\')
+					out += '\\';
+				if (static_cast<unsigned char>(ch) < 0x20)
+				{
+					char buff[8];
+					std::snprintf(buff, sizeof(buff), "\\u%04x", ch);
+					out += buff;
+				}
+				else
+					out += ch;
+			}
+		}
+	} // namespace
+
+	type_counters::type_counters(const std::type_info &info, std::size_t size) : type(info), object_size(size)
+	{
+		std::atomic<type_counters *> &head = get_registry();
+		next = head.load(std::memory_order_relaxed);
+		while (!head.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	type_stats collect(const type_counters &counters)
+	{
+		type_stats stats;
+		stats.type_name = cs_impl::cxx_demangle(counters.type.name());
+		stats.object_size = counters.object_size;
+		stats.pool_hits = counters.pool_hits.load(std::memory_order_relaxed);
+		stats.pool_misses = counters.pool_misses.load(std::memory_order_relaxed);
+		stats.allocations = stats.pool_hits + stats.pool_misses;
+		stats.frees = counters.frees.load(std::memory_order_relaxed);
+		stats.live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+		stats.live_objects = counters.object_size == 0 ? 0 : stats.live_bytes / counters.object_size;
+		return stats;
+	}
+
+	std::vector<type_stats> snapshot()
+	{
+		std::vector<type_stats> result;
+		for (type_counters *it = get_registry().load(std::memory_order_acquire); it != nullptr; it = it->next)
+			result.push_back(collect(*it));
+		std::stable_sort(result.begin(), result.end(), [](const type_stats &lhs, const type_stats &rhs) {
+			return lhs.live_bytes > rhs.live_bytes;
+		});
+		return result;
+	}
+
+	std::string to_json()
+	{
+		std::string out = "{\"types\": [";
+		bool first = true;
+		for (auto &stats : snapshot())
+		{
+			if (!first)
+				out += ", ";
+			first = false;
+			out += "{\"type\": \"";
+			append_escaped(out, stats.type_name);
+			char buff[64];
+			std::snprintf(buff, sizeof(buff), "%.4f", stats.hit_rate());
+			out += "\", \"size\": " + std::to_string(stats.object_size) +
+			       ", \"allocations\": " + std::to_string(stats.allocations) +
+			       ", \"frees\": " + std::to_string(stats.frees) +
+			       ", \"pool_hits\": " + std::to_string(stats.pool_hits) +
+			       ", \"pool_misses\": " + std::to_string(stats.pool_misses) +
+			       ", \"hit_rate\": " + buff +
+			       ", \"live_objects\": " + std::to_string(stats.live_objects) +
+			       ", \"live_bytes\": " + std::to_string(stats.live_bytes) + "}";
+		}
+		return out + "]}";
+	}
+
+	void reset() noexcept
+	{
+		for (type_counters *it = get_registry().load(std::memory_order_acquire); it != nullptr; it = it->next)
+		{
+			it->pool_hits.store(0, std::memory_order_relaxed);
+			it->pool_misses.store(0, std::memory_order_relaxed);
+			it->frees.store(0, std::memory_order_relaxed);
+		}
+	}
+} // namespace cs::alloc_stats
+#endif
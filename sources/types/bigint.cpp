@@ -0,0 +1,336 @@
+#include <covscript/types/bigint.hpp>
+#include <covscript/types/exception.hpp>
+#include <algorithm>
+
+namespace cs
+{
+	namespace
+	{
+		constexpr std::uint64_t limb_base = std::uint64_t(1) << 32;
+
+		int count_leading_zeros(std::uint32_t val) noexcept
+		{
+			int count = 0;
+			while (!(val & 0x80000000u))
+			{
+				val <<= 1;
+				++count;
+			}
+			return count;
+		}
+
+		// Divide magnitude by a single limb in place, returns the remainder
+		std::uint32_t div_limb(std::vector<std::uint32_t> &limbs, std::uint32_t div) noexcept
+		{
+			std::uint64_t rem = 0;
+			for (std::size_t i = limbs.size(); i-- > 0;)
+			{
+				std::uint64_t cur = rem << 32 | limbs[i];
+				limbs[i] = static_cast<std::uint32_t>(cur / div);
+				rem = cur % div;
+			}
+			while (!limbs.empty() && limbs.back() == 0)
+				limbs.pop_back();
+			return static_cast<std::uint32_t>(rem);
+		}
+
+		// Multiply magnitude by a single limb and add a carry in place
+		void mul_add_limb(std::vector<std::uint32_t> &limbs, std::uint32_t mul, std::uint32_t add)
+		{
+			std::uint64_t carry = add;
+			for (auto &limb : limbs)
+			{
+				std::uint64_t cur = std::uint64_t(limb) * mul + carry;
+				limb = static_cast<std::uint32_t>(cur);
+				carry = cur >> 32;
+			}
+			if (carry != 0)
+				limbs.push_back(static_cast<std::uint32_t>(carry));
+		}
+	} // namespace
+
+	void bigint::trim() noexcept
+	{
+		while (!m_limbs.empty() && m_limbs.back() == 0)
+			m_limbs.pop_back();
+		if (m_limbs.empty())
+			m_negative = false;
+	}
+
+	bigint::bigint(integer_t val) : m_negative(val < 0)
+	{
+		std::uint64_t mag = val < 0 ? std::uint64_t(0) - static_cast<std::uint64_t>(val) : static_cast<std::uint64_t>(val);
+		while (mag != 0)
+		{
+			m_limbs.push_back(static_cast<std::uint32_t>(mag));
+			mag >>= 32;
+		}
+	}
+
+	bigint bigint::parse(byte_string_view str)
+	{
+		bigint val;
+		bool negative = false;
+		if (!str.empty() && (str.front() == '-' || str.front() == '+'))
+		{
+			negative = str.front() == '-';
+			str.remove_prefix(1);
+		}
+		if (str.empty())
+			throw lang_error("Invalid integer literal.");
+		for (char_t ch : str)
+		{
+			if (ch < '0' || ch > '9')
+				throw lang_error("Invalid integer literal.");
+			mul_add_limb(val.m_limbs, 10, ch - '0');
+		}
+		val.m_negative = negative;
+		val.trim();
+		return val;
+	}
+
+	bool bigint::fits_integer() const noexcept
+	{
+		if (m_limbs.size() > 2)
+			return false;
+		std::uint64_t mag = 0;
+		for (std::size_t i = m_limbs.size(); i-- > 0;)
+			mag = mag << 32 | m_limbs[i];
+		return mag <= std::uint64_t(INT64_MAX) || (m_negative && mag == std::uint64_t(INT64_MAX) + 1);
+	}
+
+	integer_t bigint::to_integer() const noexcept
+	{
+		if (!fits_integer())
+			return m_negative ? INT64_MIN : INT64_MAX;
+		std::uint64_t mag = 0;
+		for (std::size_t i = m_limbs.size(); i-- > 0;)
+			mag = mag << 32 | m_limbs[i];
+		return m_negative ? static_cast<integer_t>(std::uint64_t(0) - mag) : static_cast<integer_t>(mag);
+	}
+
+	int bigint::compare_magnitude(const std::vector<std::uint32_t> &lhs, const std::vector<std::uint32_t> &rhs) noexcept
+	{
+		if (lhs.size() != rhs.size())
+			return lhs.size() < rhs.size() ? -1 : 1;
+		for (std::size_t i = lhs.size(); i-- > 0;)
+		{
+			if (lhs[i] != rhs[i])
+				return lhs[i] < rhs[i] ? -1 : 1;
+		}
+		return 0;
+	}
+
+	std::vector<std::uint32_t> bigint::add_magnitude(const std::vector<std::uint32_t> &lhs, const std::vector<std::uint32_t> &rhs)
+	{
+		const std::vector<std::uint32_t> &longer = lhs.size() >= rhs.size() ? lhs : rhs;
+		const std::vector<std::uint32_t> &shorter = lhs.size() >= rhs.size() ? rhs : lhs;
+		std::vector<std::uint32_t> res(longer.size() + 1);
+		std::uint64_t carry = 0;
+		for (std::size_t i = 0; i < longer.size(); ++i)
+		{
+			std::uint64_t cur = std::uint64_t(longer[i]) + (i < shorter.size() ? shorter[i] : 0) + carry;
+			res[i] = static_cast<std::uint32_t>(cur);
+			carry = cur >> 32;
+		}
+		res[longer.size()] = static_cast<std::uint32_t>(carry);
+		return res;
+	}
+
+	std::vector<std::uint32_t> bigint::sub_magnitude(const std::vector<std::uint32_t> &lhs, const std::vector<std::uint32_t> &rhs)
+	{
+		std::vector<std::uint32_t> res(lhs.size());
+		std::int64_t borrow = 0;
+		for (std::size_t i = 0; i < lhs.size(); ++i)
+		{
+			std::int64_t cur = std::int64_t(lhs[i]) - (i < rhs.size() ? rhs[i] : 0) - borrow;
+			borrow = cur < 0;
+			res[i] = static_cast<std::uint32_t>(cur + (borrow ? std::int64_t(limb_base) : 0));
+		}
+		return res;
+	}
+
+	int bigint::compare(const bigint &rhs) const noexcept
+	{
+		if (m_negative != rhs.m_negative)
+			return m_negative ? -1 : 1;
+		int res = compare_magnitude(m_limbs, rhs.m_limbs);
+		return m_negative ? -res : res;
+	}
+
+	bigint bigint::operator+(const bigint &rhs) const
+	{
+		bigint res;
+		if (m_negative == rhs.m_negative)
+		{
+			res.m_limbs = add_magnitude(m_limbs, rhs.m_limbs);
+			res.m_negative = m_negative;
+		}
+		else if (compare_magnitude(m_limbs, rhs.m_limbs) >= 0)
+		{
+			res.m_limbs = sub_magnitude(m_limbs, rhs.m_limbs);
+			res.m_negative = m_negative;
+		}
+		else
+		{
+			res.m_limbs = sub_magnitude(rhs.m_limbs, m_limbs);
+			res.m_negative = rhs.m_negative;
+		}
+		res.trim();
+		return res;
+	}
+
+	bigint bigint::operator-(const bigint &rhs) const
+	{
+		return *this + -rhs;
+	}
+
+	bigint bigint::operator*(const bigint &rhs) const
+	{
+		bigint res;
+		if (is_zero() || rhs.is_zero())
+			return res;
+		res.m_limbs.assign(m_limbs.size() + rhs.m_limbs.size(), 0);
+		for (std::size_t i = 0; i < m_limbs.size(); ++i)
+		{
+			std::uint64_t carry = 0;
+			for (std::size_t j = 0; j < rhs.m_limbs.size(); ++j)
+			{
+				std::uint64_t cur = std::uint64_t(m_limbs[i]) * rhs.m_limbs[j] + res.m_limbs[i + j] + carry;
+				res.m_limbs[i + j] = static_cast<std::uint32_t>(cur);
+				carry = cur >> 32;
+			}
+			res.m_limbs[i + rhs.m_limbs.size()] = static_cast<std::uint32_t>(carry);
+		}
+		res.m_negative = m_negative != rhs.m_negative;
+		res.trim();
+		return res;
+	}
+
+	bigint bigint::operator-() const
+	{
+		bigint res(*this);
+		if (!res.is_zero())
+			res.m_negative = !res.m_negative;
+		return res;
+	}
+
+	void bigint::divmod(const bigint &lhs, const bigint &rhs, bigint &quot, bigint &rem)
+	{
+		if (rhs.is_zero())
+			throw lang_error("Divided by zero.");
+		if (compare_magnitude(lhs.m_limbs, rhs.m_limbs) < 0)
+		{
+			rem = lhs;
+			quot = bigint();
+			return;
+		}
+		const std::vector<std::uint32_t> &u = lhs.m_limbs, &v = rhs.m_limbs;
+		std::vector<std::uint32_t> q, r;
+		if (v.size() == 1)
+		{
+			q = u;
+			r.push_back(div_limb(q, v[0]));
+		}
+		else
+		{
+			// Knuth's algorithm D, normalized so the top limb of divisor has its high bit set
+			const std::size_t m = u.size(), n = v.size();
+			const int s = count_leading_zeros(v[n - 1]);
+			std::vector<std::uint32_t> vn(n), un(m + 1);
+			for (std::size_t i = n - 1; i > 0; --i)
+				vn[i] = static_cast<std::uint32_t>(std::uint64_t(v[i]) << s | std::uint64_t(v[i - 1]) >> (32 - s));
+			vn[0] = v[0] << s;
+			un[m] = static_cast<std::uint32_t>(std::uint64_t(u[m - 1]) >> (32 - s));
+			for (std::size_t i = m - 1; i > 0; --i)
+				un[i] = static_cast<std::uint32_t>(std::uint64_t(u[i]) << s | std::uint64_t(u[i - 1]) >> (32 - s));
+			un[0] = u[0] << s;
+			q.assign(m - n + 1, 0);
+			for (std::size_t j = m - n + 1; j-- > 0;)
+			{
+				std::uint64_t num = std::uint64_t(un[j + n]) << 32 | un[j + n - 1];
+				std::uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+				while (qhat >= limb_base || qhat * vn[n - 2] > (rhat << 32 | un[j + n - 2]))
+				{
+					--qhat;
+					rhat += vn[n - 1];
+					if (rhat >= limb_base)
+						break;
+				}
+				std::int64_t borrow = 0, cur = 0;
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					std::uint64_t prod = qhat * vn[i];
+					cur = std::int64_t(un[i + j]) - borrow - std::int64_t(prod & 0xFFFFFFFFu);
+					un[i + j] = static_cast<std::uint32_t>(cur);
+					borrow = std::int64_t(prod >> 32) - (cur >> 32);
+				}
+				cur = std::int64_t(un[j + n]) - borrow;
+				un[j + n] = static_cast<std::uint32_t>(cur);
+				q[j] = static_cast<std::uint32_t>(qhat);
+				// Estimated one too large, add back
+				if (cur < 0)
+				{
+					--q[j];
+					std::uint64_t carry = 0;
+					for (std::size_t i = 0; i < n; ++i)
+					{
+						std::uint64_t sum = std::uint64_t(un[i + j]) + vn[i] + carry;
+						un[i + j] = static_cast<std::uint32_t>(sum);
+						carry = sum >> 32;
+					}
+					un[j + n] = static_cast<std::uint32_t>(un[j + n] + carry);
+				}
+			}
+			r.resize(n);
+			for (std::size_t i = 0; i < n; ++i)
+				r[i] = static_cast<std::uint32_t>(std::uint64_t(un[i]) >> s | std::uint64_t(un[i + 1]) << (32 - s));
+		}
+		bool quot_negative = lhs.m_negative != rhs.m_negative, rem_negative = lhs.m_negative;
+		quot.m_limbs = std::move(q);
+		quot.m_negative = quot_negative;
+		quot.trim();
+		rem.m_limbs = std::move(r);
+		rem.m_negative = rem_negative;
+		rem.trim();
+	}
+
+	std::to_chars_result bigint::to_chars(char *first, char *last) const
+	{
+		if (is_zero())
+			return std::to_chars(first, last, 0);
+		std::vector<std::uint32_t> mag = m_limbs;
+		std::vector<std::uint32_t> chunks;
+		while (!mag.empty())
+			chunks.push_back(div_limb(mag, 1000000000u));
+		if (m_negative)
+		{
+			if (first == last)
+				return {last, std::errc::value_too_large};
+			*first++ = '-';
+		}
+		std::to_chars_result res = std::to_chars(first, last, chunks.back());
+		for (std::size_t i = chunks.size() - 1; i-- > 0 && res.ec == std::errc();)
+		{
+			// Lower chunks are zero padded to nine digits
+			if (last - res.ptr < 9)
+				return {last, std::errc::value_too_large};
+			char *chunk = res.ptr;
+			std::fill(chunk, chunk + 9, '0');
+			char digits[9];
+			std::to_chars_result tmp = std::to_chars(digits, digits + 9, chunks[i]);
+			std::copy(digits, tmp.ptr, chunk + 9 - (tmp.ptr - digits));
+			res.ptr = chunk + 9;
+		}
+		return res;
+	}
+
+	byte_string_t bigint::to_string() const
+	{
+		// Each limb holds less than ten decimal digits
+		byte_string_t str(m_limbs.size() * 10 + 2, '\0');
+		std::to_chars_result res = to_chars(&str[0], &str[0] + str.size());
+		str.resize(res.ptr - str.data());
+		return str;
+	}
+} // namespace cs
@@ -0,0 +1,507 @@
+#include <covscript/types/numeric.hpp>
+#include <covscript/types/exception.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <cmath>
+#include <vector>
+
+namespace cs
+{
+	namespace
+	{
+		// Largest power of ten exactly representable, 5^k must fit in the mantissa
+		template <typename T>
+		constexpr int max_exact_pow10() noexcept
+		{
+			int k = 0;
+			for (unsigned long long pow5 = 1; pow5 <= (~0ull >> (64 - std::numeric_limits<T>::digits)) / 5; pow5 *= 5)
+				++k;
+			return k;
+		}
+
+#if defined(__SIZEOF_INT128__)
+		// 5^q is in [hi:lo, hi:lo + 1) * 2^exp
+		struct pow5_128
+		{
+			std::uint64_t hi, lo;
+			int exp;
+		};
+
+		constexpr int pow5_min = -342, pow5_max = 308;
+
+		// Top 128 bits of 5^q, built once from a multiword integer multiplied or divided by five
+		const pow5_128 *pow5_table()
+		{
+			static const std::vector<pow5_128> table = [] {
+				std::vector<pow5_128> res(pow5_max - pow5_min + 1);
+				// Little endian words of 32 bits
+				std::vector<std::uint32_t> num;
+				auto bits = [&num](int pos) {
+					std::uint64_t val = 0;
+					for (int i = pos + 63; i >= pos; --i)
+						val = val << 1 | (i >= 0 && static_cast<std::size_t>(i / 32) < num.size() ? num[i / 32] >> (i % 32) & 1 : 0);
+					return val;
+				};
+				auto top128 = [&num, &bits](int exp_offset) {
+					std::size_t top = num.size() - 1;
+					while (num[top] == 0)
+						--top;
+					int len = static_cast<int>(top) * 32;
+					for (std::uint32_t word = num[top]; word != 0; word >>= 1)
+						++len;
+					return pow5_128{bits(len - 64), bits(len - 128), len - 128 - exp_offset};
+				};
+				num.assign(1, 1);
+				for (int q = 0; q <= pow5_max; ++q)
+				{
+					res[q - pow5_min] = top128(0);
+					std::uint64_t carry = 0;
+					for (std::uint32_t &word : num)
+					{
+						carry += std::uint64_t(word) * 5;
+						word = static_cast<std::uint32_t>(carry);
+						carry >>= 32;
+					}
+					if (carry != 0)
+						num.push_back(static_cast<std::uint32_t>(carry));
+				}
+				// floor(2^K / 5^n) keeps more than 128 bits down to pow5_min, and flooring at every step is exact
+				constexpr int K = 928;
+				num.assign(K / 32 + 1, 0);
+				num.back() = 1;
+				for (int q = -1; q >= pow5_min; --q)
+				{
+					std::uint64_t rem = 0;
+					for (std::size_t i = num.size(); i-- > 0;)
+					{
+						rem = rem << 32 | num[i];
+						num[i] = static_cast<std::uint32_t>(rem / 5);
+						rem %= 5;
+					}
+					res[q - pow5_min] = top128(K);
+				}
+				return res;
+			}();
+			return table.data();
+		}
+
+		/*
+		 * Eisel-Lemire for 64 bits mantissas: w * 10^q is rounded to mantissa * 2^exp from the product
+		 * of w and the truncated power of five, false if the truncation leaves the rounding undecided.
+		 */
+		bool eisel_lemire64(__uint128_t w, int q, std::uint64_t &mantissa, int &exp) noexcept
+		{
+			if (w == 0 || q < pow5_min || q > pow5_max)
+				return false;
+			const pow5_128 &pow = pow5_table()[q - pow5_min];
+			std::uint64_t w_hi = static_cast<std::uint64_t>(w >> 64);
+			int lz = w_hi != 0 ? __builtin_clzll(w_hi) : 64 + __builtin_clzll(static_cast<std::uint64_t>(w));
+			w <<= lz;
+			std::uint64_t a1 = static_cast<std::uint64_t>(w >> 64), a0 = static_cast<std::uint64_t>(w);
+			__uint128_t a1b0 = static_cast<__uint128_t>(a1) * pow.lo, a0b1 = static_cast<__uint128_t>(a0) * pow.hi;
+			__uint128_t mid = ((static_cast<__uint128_t>(a0) * pow.lo) >> 64) + static_cast<std::uint64_t>(a1b0) + static_cast<std::uint64_t>(a0b1);
+			__uint128_t upper = static_cast<__uint128_t>(a1) * pow.hi + (a1b0 >> 64) + (a0b1 >> 64) + (mid >> 64);
+			// The exact product over 2^128 is in [upper, upper + 2)
+			int shift = static_cast<std::uint64_t>(upper >> 127) != 0 ? 64 : 63;
+			std::uint64_t rest = static_cast<std::uint64_t>(upper) << (64 - shift);
+			std::uint64_t error = shift == 64 ? 2 : 4;
+			constexpr std::uint64_t half = std::uint64_t(1) << 63;
+			if (rest <= half && rest + error > half)
+				return false;
+			mantissa = static_cast<std::uint64_t>(upper >> shift);
+			exp = shift + 128 + pow.exp + q - lz;
+			if (rest > half && ++mantissa == 0)
+			{
+				mantissa = half;
+				++exp;
+			}
+			return true;
+		}
+#endif
+
+		/*
+		 * Clinger's fast path: if the decimal mantissa and the power of ten are both exact,
+		 * a single multiplication or division rounds correctly. Long doubles of 64 bits mantissas
+		 * go on with Eisel-Lemire, which also takes mantissas truncated to 38 digits when both
+		 * bounds round alike. Everything else goes to std::from_chars.
+		 */
+		template <typename T>
+		bool float_fast_path(const char *first, const char *last, T &val, const char *&end) noexcept
+		{
+			// Digits past 19 are kept apart for Eisel-Lemire, past 38 they are dropped
+			constexpr int max_digits = 19;
+			constexpr int max_pow = max_exact_pow10<T>();
+			const char *it = first;
+			bool negative = it != last && *it == '-';
+			if (negative)
+				++it;
+			unsigned long long mantissa = 0, tail = 0;
+			int digits = 0, exponent = 0;
+			bool any_digit = false, truncated = false;
+			auto push_digit = [&](int digit) {
+				if (digits < max_digits)
+					mantissa = mantissa * 10 + digit;
+				else if (digits < 2 * max_digits)
+					tail = tail * 10 + digit;
+				else
+				{
+					truncated |= digit != 0;
+					return false;
+				}
+				++digits;
+				return true;
+			};
+			for (; it != last && *it >= '0' && *it <= '9'; ++it, any_digit = true)
+			{
+				if (mantissa == 0 && *it == '0')
+					continue;
+				if (!push_digit(*it - '0'))
+					++exponent;
+			}
+			if (it != last && *it == '.')
+			{
+				for (++it; it != last && *it >= '0' && *it <= '9'; ++it, any_digit = true)
+				{
+					if (mantissa == 0 && *it == '0')
+						--exponent;
+					else if (push_digit(*it - '0'))
+						--exponent;
+				}
+			}
+			if (!any_digit)
+				return false;
+			if (it != last && (*it == 'e' || *it == 'E'))
+			{
+				const char *exp_it = it + 1;
+				bool exp_negative = false;
+				if (exp_it != last && (*exp_it == '-' || *exp_it == '+'))
+					exp_negative = *exp_it++ == '-';
+				if (exp_it != last && *exp_it >= '0' && *exp_it <= '9')
+				{
+					int exp_val = 0;
+					for (; exp_it != last && *exp_it >= '0' && *exp_it <= '9'; ++exp_it)
+					{
+						if (exp_val > 10000)
+							return false;
+						exp_val = exp_val * 10 + (*exp_it - '0');
+					}
+					exponent += exp_negative ? -exp_val : exp_val;
+					it = exp_it;
+				}
+			}
+			if (mantissa == 0)
+				exponent = 0;
+			if (digits <= max_digits && mantissa <= (~0ull >> (64 - std::numeric_limits<T>::digits)) && exponent >= -max_pow && exponent <= max_pow)
+			{
+				T pow10 = 1;
+				for (int i = exponent < 0 ? -exponent : exponent; i > 0; --i)
+					pow10 *= 10;
+				val = exponent < 0 ? static_cast<T>(mantissa) / pow10 : static_cast<T>(mantissa) * pow10;
+			}
+			else
+			{
+#if defined(__SIZEOF_INT128__)
+				if constexpr (std::numeric_limits<T>::digits == 64)
+				{
+					__uint128_t wide = mantissa;
+					for (int i = max_digits; i < digits; ++i)
+						wide *= 10;
+					wide += tail;
+					std::uint64_t bits = 0, upper_bits = 0;
+					int exp = 0, upper_exp = 0;
+					if (!eisel_lemire64(wide, exponent, bits, exp))
+						return false;
+					if (truncated && (!eisel_lemire64(wide + 1, exponent, upper_bits, upper_exp) || bits != upper_bits || exp != upper_exp))
+						return false;
+					val = std::ldexp(static_cast<T>(bits), exp);
+				}
+				else
+					return false;
+#else
+				return false;
+#endif
+			}
+			if (negative)
+				val = -val;
+			end = it;
+			return true;
+		}
+
+		template <typename T>
+		std::to_chars_result float_to_chars(char *first, char *last, T val)
+		{
+#ifdef __cpp_lib_to_chars
+			// Long doubles holding a double take its shortest text when it reads back the same
+			if constexpr (std::numeric_limits<T>::digits > std::numeric_limits<double>::digits)
+			{
+				double dval = static_cast<double>(val);
+				if (std::isfinite(dval) && static_cast<T>(dval) == val)
+				{
+					std::to_chars_result res = std::to_chars(first, last, dval);
+					T check = 0;
+					const char *end = nullptr;
+					if (res.ec == std::errc() && float_fast_path(first, res.ptr, check, end) && end == res.ptr && check == val)
+						return res;
+				}
+			}
+			return std::to_chars(first, last, val);
+#else
+			// %g drops trailing zeros, so the first precision that round-trips gives the shortest text
+			char buff[64];
+			int len = 0;
+			for (int precision = std::numeric_limits<T>::digits10;; ++precision)
+			{
+				len = std::snprintf(buff, sizeof(buff), "%.*Lg", precision, static_cast<long double>(val));
+				if (precision >= std::numeric_limits<T>::max_digits10 || static_cast<T>(std::strtold(buff, nullptr)) == val)
+					break;
+			}
+			if (len > last - first)
+				return {last, std::errc::value_too_large};
+			std::memcpy(first, buff, len);
+			return {first + len, std::errc()};
+#endif
+		}
+
+		template <typename T>
+		std::from_chars_result float_from_chars(const char *first, const char *last, T &val)
+		{
+			const char *end = nullptr;
+			if (float_fast_path(first, last, val, end))
+				return {end, std::errc()};
+#ifdef __cpp_lib_to_chars
+			return std::from_chars(first, last, val);
+#else
+			byte_string_t str(first, last);
+			char *str_end = nullptr;
+			long double res = std::strtold(str.c_str(), &str_end);
+			if (str_end == str.c_str())
+				return {first, std::errc::invalid_argument};
+			val = static_cast<T>(res);
+			return {first + (str_end - str.c_str()), std::errc()};
+#endif
+		}
+	} // namespace
+
+	integer_divisor::integer_divisor(integer_t divisor) : m_divisor(divisor)
+	{
+		if (divisor == 0)
+			throw lang_error("Divided by zero.");
+		std::uint64_t abs_divisor = divisor < 0 ? 0 - static_cast<std::uint64_t>(divisor) : divisor;
+		std::uint8_t log2_divisor = 63;
+		while (!(abs_divisor >> log2_divisor))
+			--log2_divisor;
+		if ((abs_divisor & (abs_divisor - 1)) == 0)
+			m_more = log2_divisor;
+		else
+		{
+			// 2^(63 + log2_divisor) / abs_divisor, fits in 63 bits because abs_divisor > 2^log2_divisor
+			std::uint64_t magic = 0, rem = 0;
+#if defined(__SIZEOF_INT128__)
+			__uint128_t numer = static_cast<__uint128_t>(1) << (63 + log2_divisor);
+			magic = static_cast<std::uint64_t>(numer / abs_divisor);
+			rem = static_cast<std::uint64_t>(numer % abs_divisor);
+#else
+			for (int bit = 63 + log2_divisor; bit >= 0; --bit)
+			{
+				// rem < abs_divisor <= 2^63, so doubling never overflows
+				rem = rem << 1 | (bit == 63 + log2_divisor);
+				magic <<= 1;
+				if (rem >= abs_divisor)
+				{
+					rem -= abs_divisor;
+					magic |= 1;
+				}
+			}
+#endif
+			if (abs_divisor - rem < (std::uint64_t(1) << log2_divisor))
+				m_more = log2_divisor - 1;
+			else
+			{
+				// One more bit of precision, compensated by adding the numerator back
+				magic += magic;
+				std::uint64_t twice_rem = rem + rem;
+				if (twice_rem >= abs_divisor || twice_rem < rem)
+					magic += 1;
+				m_more = log2_divisor | add_marker;
+			}
+			++magic;
+			m_magic = static_cast<integer_t>(divisor < 0 ? 0 - magic : magic);
+		}
+		if (divisor < 0)
+			m_more |= negative_divisor;
+	}
+
+	template <typename float_type>
+	basic_numeric<float_type> basic_numeric<float_type>::arith_slow(arith_op op, basic_numeric lhs, basic_numeric rhs)
+	{
+		// Bigints mixed with floats follow the same rule as integers
+		if (lhs.is_float() || rhs.is_float())
+		{
+			float_type a = lhs.as_float(), b = rhs.as_float();
+			switch (op)
+			{
+				case arith_op::add:
+					return a + b;
+				case arith_op::sub:
+					return a - b;
+				case arith_op::mul:
+					return a * b;
+				case arith_op::mod:
+					return std::fmod(a, b);
+				case arith_op::pow:
+					return std::pow(a, b);
+				default:
+					return a / b;
+			}
+		}
+		if (op == arith_op::pow)
+			return pow_slow(lhs, rhs);
+		bigint a = lhs.to_bigint(), b = rhs.to_bigint();
+		switch (op)
+		{
+			case arith_op::add:
+				return basic_numeric(a + b);
+			case arith_op::sub:
+				return basic_numeric(a - b);
+			case arith_op::mul:
+				return basic_numeric(a * b);
+			case arith_op::mod:
+			{
+				if (b.is_zero())
+					return std::fmod(lhs.as_float(), rhs.as_float());
+				bigint quot, rem;
+				bigint::divmod(a, b, quot, rem);
+				return basic_numeric(std::move(rem));
+			}
+			default:
+			{
+				if (b.is_zero())
+					return lhs.as_float() / rhs.as_float();
+				bigint quot, rem;
+				bigint::divmod(a, b, quot, rem);
+				if (rem.is_zero())
+					return basic_numeric(std::move(quot));
+				else
+					return lhs.as_float() / rhs.as_float();
+			}
+		}
+	}
+
+	template <typename float_type>
+	basic_numeric<float_type> basic_numeric<float_type>::pow_slow(const basic_numeric &base, const basic_numeric &exp)
+	{
+		// Negative or huge exponents, and results too large to be worth computing exactly, are left to floats
+		if (exp.is_big() || exp.data._int < 0 || std::log2(std::fabs(static_cast<double>(base.as_float()))) * exp.data._int > max_pow_bits)
+			return std::pow(base.as_float(), exp.as_float());
+		bigint res(1), sqr = base.to_bigint();
+		for (integer_t n = exp.data._int;;)
+		{
+			if (n & 1)
+				res = res * sqr;
+			n >>= 1;
+			if (n == 0)
+				break;
+			sqr = sqr * sqr;
+		}
+		return basic_numeric(std::move(res));
+	}
+
+	template <typename float_type>
+	int basic_numeric<float_type>::compare_slow(basic_numeric lhs, basic_numeric rhs) noexcept
+	{
+		if (lhs.is_float() || rhs.is_float())
+		{
+			float_type a = lhs.as_float(), b = rhs.as_float();
+			if (a < b)
+				return -1;
+			else if (a > b)
+				return 1;
+			else if (a == b)
+				return 0;
+			else
+				return 2;
+		}
+		if (lhs.is_big() && rhs.is_big())
+			return lhs.data._big->value.compare(rhs.data._big->value);
+		// Bigints are out of range of integer_t, so the sign decides
+		else if (lhs.is_big())
+			return lhs.data._big->value.is_negative() ? -1 : 1;
+		else
+			return rhs.data._big->value.is_negative() ? 1 : -1;
+	}
+
+	template <typename float_type>
+	std::to_chars_result basic_numeric<float_type>::to_chars(char *first, char *last) const
+	{
+		switch (type)
+		{
+			case kind_integer:
+				return std::to_chars(first, last, data._int);
+			case kind_float:
+				return float_to_chars(first, last, data._num);
+			default:
+				return data._big->value.to_chars(first, last);
+		}
+	}
+
+	template <typename float_type>
+	std::from_chars_result basic_numeric<float_type>::from_chars(const char *first, const char *last, basic_numeric &value)
+	{
+		// std::from_chars takes no plus sign
+		const char *begin = first;
+		if (begin != last && *begin == '+' && (begin + 1 == last || begin[1] != '-'))
+			++begin;
+		const char *digits_end = begin != last && *begin == '-' ? begin + 1 : begin;
+		digits_end = std::find_if(digits_end, last, [](char ch) { return ch < '0' || ch > '9'; });
+		bool is_float = digits_end != last && (*digits_end == '.' || *digits_end == 'e' || *digits_end == 'E');
+		if (!is_float)
+		{
+			integer_t ival = 0;
+			std::from_chars_result res = std::from_chars(begin, digits_end, ival);
+			if (res.ec == std::errc())
+				value = ival;
+			else if (res.ec == std::errc::result_out_of_range)
+			{
+				value = basic_numeric(bigint::parse(byte_string_view(begin, digits_end - begin)));
+				res = {digits_end, std::errc()};
+			}
+			// Not a number at all, try inf and nan
+			else
+				is_float = true;
+			if (!is_float)
+				return res.ec == std::errc() ? res : std::from_chars_result{first, res.ec};
+		}
+		float_type fval = 0;
+		std::from_chars_result res = float_from_chars(begin, last, fval);
+		if (res.ec == std::errc())
+			value = fval;
+		else
+			res.ptr = first;
+		return res;
+	}
+
+	template <typename float_type>
+	basic_numeric<float_type> basic_numeric<float_type>::parse(byte_string_view str)
+	{
+		basic_numeric value;
+		std::from_chars_result res = from_chars(str.data(), str.data() + str.size(), value);
+		if (res.ec != std::errc() || res.ptr != str.data() + str.size())
+			throw lang_error("Invalid numeric literal.");
+		return value;
+	}
+
+	template <typename float_type>
+	byte_string_t basic_numeric<float_type>::to_string() const
+	{
+		if (type == kind_big)
+			return data._big->value.to_string();
+		char buff[max_chars];
+		std::to_chars_result res = to_chars(buff, buff + max_chars);
+		return byte_string_t(buff, res.ptr);
+	}
+
+	template class basic_numeric<double>;
+	template class basic_numeric<long double>;
+} // namespace cs
@@ -0,0 +1,1218 @@
+#include <covscript/common/platform.hpp>
+#include <covscript/types/numeric.hpp>
+#include <covscript/types/simd.hpp>
+#include <algorithm>
+#include <cstring>
+
+#if !defined(COVSCRIPT_DISABLE_SIMD) && (defined(COVSCRIPT_ARCH_AMD64) || defined(COVSCRIPT_ARCH_I386))
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COVSCRIPT_SIMD_SSE2
+#include <immintrin.h>
+#endif
+#endif
+
+#ifdef COVSCRIPT_SIMD_SSE2
+#if defined(COVSCRIPT_COMPILER_GNUC) || defined(COVSCRIPT_COMPILER_CLANG)
+// Compiled for AVX2 regardless of the target flags, selected at runtime
+#define COVSCRIPT_SIMD_AVX2
+#define COVSCRIPT_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define COVSCRIPT_SIMD_AVX2
+#define COVSCRIPT_TARGET_AVX2
+#endif
+#endif
+
+namespace cs::simd::scalar
+{
+	template <typename T>
+	static T reduce_add(const T *data, std::size_t n) noexcept
+	{
+		T sum = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			sum += data[i];
+		return sum;
+	}
+
+	// Integer kernels wrap around, overflows of any step are collected in the sign bit of flags
+	constexpr std::uint64_t sign_bit = std::uint64_t(1) << 63;
+
+	static inline std::uint64_t add_wrap(std::uint64_t a, std::uint64_t b, std::uint64_t &flags) noexcept
+	{
+		std::uint64_t r = a + b;
+		flags |= (a ^ r) & (b ^ r);
+		return r;
+	}
+
+	static inline std::uint64_t sub_wrap(std::uint64_t a, std::uint64_t b, std::uint64_t &flags) noexcept
+	{
+		std::uint64_t r = a - b;
+		flags |= (a ^ b) & (a ^ r);
+		return r;
+	}
+
+	static inline std::uint64_t mul_wrap(integer_t a, integer_t b, std::uint64_t &flags) noexcept
+	{
+		integer_t r;
+		if (numeric_detail::mul_overflow(a, b, &r))
+			flags |= sign_bit;
+		return static_cast<std::uint64_t>(a) * static_cast<std::uint64_t>(b);
+	}
+
+	// Adds to sum
+	static bool reduce_add(const integer_t *data, std::size_t n, integer_t &sum) noexcept
+	{
+		std::uint64_t acc = static_cast<std::uint64_t>(sum), flags = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			acc = add_wrap(acc, static_cast<std::uint64_t>(data[i]), flags);
+		sum = static_cast<integer_t>(acc);
+		return (flags & sign_bit) == 0;
+	}
+
+	static std::size_t count_nonzero(const std::uint8_t *data, std::size_t n) noexcept
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			count += data[i] != 0;
+		return count;
+	}
+
+	static bool dot(const integer_t *lhs, const integer_t *rhs, std::size_t n, integer_t &sum) noexcept
+	{
+		std::uint64_t acc = static_cast<std::uint64_t>(sum), flags = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			acc = add_wrap(acc, mul_wrap(lhs[i], rhs[i], flags), flags);
+		sum = static_cast<integer_t>(acc);
+		return (flags & sign_bit) == 0;
+	}
+
+	static double dot(const double *lhs, const double *rhs, std::size_t n) noexcept
+	{
+		double sum = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			sum += lhs[i] * rhs[i];
+		return sum;
+	}
+
+	static bool elementwise(arith_op op, const integer_t *lhs, const integer_t *rhs, integer_t *out, std::size_t n) noexcept
+	{
+		const std::uint64_t *a = reinterpret_cast<const std::uint64_t *>(lhs), *b = reinterpret_cast<const std::uint64_t *>(rhs);
+		std::uint64_t *c = reinterpret_cast<std::uint64_t *>(out);
+		std::uint64_t flags = 0;
+		switch (op)
+		{
+			case arith_op::add:
+				for (std::size_t i = 0; i < n; ++i)
+					c[i] = add_wrap(a[i], b[i], flags);
+				break;
+			case arith_op::sub:
+				for (std::size_t i = 0; i < n; ++i)
+					c[i] = sub_wrap(a[i], b[i], flags);
+				break;
+			case arith_op::mul:
+				for (std::size_t i = 0; i < n; ++i)
+					c[i] = mul_wrap(lhs[i], rhs[i], flags);
+				break;
+			default:
+				break;
+		}
+		return (flags & sign_bit) == 0;
+	}
+
+	static void elementwise(arith_op op, const double *lhs, const double *rhs, double *out, std::size_t n) noexcept
+	{
+		switch (op)
+		{
+			case arith_op::add:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] + rhs[i];
+				break;
+			case arith_op::sub:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] - rhs[i];
+				break;
+			case arith_op::mul:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] * rhs[i];
+				break;
+			case arith_op::div:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] / rhs[i];
+				break;
+		}
+	}
+
+	template <typename T>
+	static void compare(compare_op op, const T *lhs, T rhs, std::uint8_t *out, std::size_t n) noexcept
+	{
+		switch (op)
+		{
+			case compare_op::eq:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] == rhs;
+				break;
+			case compare_op::ne:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] != rhs;
+				break;
+			case compare_op::lt:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] < rhs;
+				break;
+			case compare_op::le:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] <= rhs;
+				break;
+			case compare_op::gt:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] > rhs;
+				break;
+			case compare_op::ge:
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = lhs[i] >= rhs;
+				break;
+		}
+	}
+
+	template <typename T>
+	static std::size_t find(const T *data, std::size_t n, T val) noexcept
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			if (data[i] == val)
+				return i;
+		}
+		return n;
+	}
+
+	// Length of the well-formed UTF-8 sequence at p, 0 if ill-formed or truncated
+	static inline std::size_t utf8_sequence(const unsigned char *p, std::size_t n) noexcept
+	{
+		unsigned char c = p[0];
+		if (c < 0x80)
+			return 1;
+		else if (c < 0xC2)
+			return 0;
+		else if (c < 0xE0)
+			return n >= 2 && (p[1] & 0xC0) == 0x80 ? 2 : 0;
+		else if (c < 0xF0)
+		{
+			if (n < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80)
+				return 0;
+			// Overlong or surrogate
+			if ((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] > 0x9F))
+				return 0;
+			return 3;
+		}
+		else if (c < 0xF5)
+		{
+			if (n < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80)
+				return 0;
+			// Overlong or above U+10FFFF
+			if ((c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] > 0x8F))
+				return 0;
+			return 4;
+		}
+		else
+			return 0;
+	}
+
+	// Input must be well-formed
+	static inline char32_t utf8_decode(const unsigned char *&p) noexcept
+	{
+		char32_t c = *p++;
+		if (c < 0x80)
+			return c;
+		else if (c < 0xE0)
+			return (c & 0x1F) << 6 | (*p++ & 0x3F);
+		else if (c < 0xF0)
+		{
+			c = (c & 0x0F) << 12 | (p[0] & 0x3F) << 6 | (p[1] & 0x3F);
+			p += 2;
+			return c;
+		}
+		c = (c & 0x07) << 18 | (p[0] & 0x3F) << 12 | (p[1] & 0x3F) << 6 | (p[2] & 0x3F);
+		p += 3;
+		return c;
+	}
+
+	// Surrogates and values above U+10FFFF are encoded as U+FFFD
+	static inline std::size_t utf8_encoded_length(char32_t cp) noexcept
+	{
+		return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 || cp > 0x10FFFF ? 3 : 4;
+	}
+
+	static inline char *utf8_encode(char32_t cp, char *out) noexcept
+	{
+		if (cp < 0x80)
+			*out++ = static_cast<char>(cp);
+		else if (cp < 0x800)
+		{
+			*out++ = static_cast<char>(0xC0 | cp >> 6);
+			*out++ = static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000 || cp > 0x10FFFF)
+		{
+			if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+				cp = 0xFFFD;
+			*out++ = static_cast<char>(0xE0 | cp >> 12);
+			*out++ = static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+			*out++ = static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else
+		{
+			*out++ = static_cast<char>(0xF0 | cp >> 18);
+			*out++ = static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+			*out++ = static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+			*out++ = static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		return out;
+	}
+
+	// Replaced by the SSE2 versions where available
+#ifndef COVSCRIPT_SIMD_SSE2
+	// Eight bytes at a time while they are ASCII
+	static inline bool ascii_word(const unsigned char *p) noexcept
+	{
+		std::uint64_t word;
+		std::memcpy(&word, p, sizeof(word));
+		return (word & 0x8080808080808080ull) == 0;
+	}
+
+	static bool utf8_validate(const char *data, std::size_t n) noexcept
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+		std::size_t i = 0;
+		while (i < n)
+		{
+			if (i + 8 <= n && ascii_word(p + i))
+			{
+				i += 8;
+				continue;
+			}
+			std::size_t len = utf8_sequence(p + i, n - i);
+			if (len == 0)
+				return false;
+			i += len;
+		}
+		return true;
+	}
+#endif
+
+	static std::size_t utf8_length(const char *data, std::size_t n) noexcept
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			count += (static_cast<unsigned char>(data[i]) & 0xC0) != 0x80;
+		return count;
+	}
+
+#ifndef COVSCRIPT_SIMD_SSE2
+	static char32_t *utf8_to_utf32(const char *data, std::size_t n, char32_t *out) noexcept
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(data), *end = p + n;
+		while (p < end)
+		{
+			if (end - p >= 8 && ascii_word(p))
+			{
+				for (int k = 0; k < 8; ++k)
+					*out++ = *p++;
+				continue;
+			}
+			*out++ = utf8_decode(p);
+		}
+		return out;
+	}
+#endif
+
+	static std::size_t utf32_to_utf8_length(const char32_t *data, std::size_t n) noexcept
+	{
+		std::size_t len = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			len += utf8_encoded_length(data[i]);
+		return len;
+	}
+
+	static char *utf32_to_utf8(const char32_t *data, std::size_t n, char *out) noexcept
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			out = utf8_encode(data[i], out);
+		return out;
+	}
+} // namespace cs::simd::scalar
+
+#ifdef COVSCRIPT_SIMD_SSE2
+namespace cs::simd::sse2
+{
+	// Scatter low bits of a movemask into the byte mask
+	static inline void store_mask(unsigned int mask, std::uint8_t *out, std::size_t lanes) noexcept
+	{
+		for (std::size_t i = 0; i < lanes; ++i)
+			out[i] = (mask >> i) & 1;
+	}
+
+	// Lane-wise 64 bits equality, SSE2 only compares 32 bits lanes
+	static inline __m128i cmpeq_epi64(__m128i a, __m128i b) noexcept
+	{
+		__m128i eq = _mm_cmpeq_epi32(a, b);
+		return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+	}
+
+	// Same as scalar::add_wrap in every lane
+	static inline __m128i add_wrap(__m128i a, __m128i b, __m128i &flags) noexcept
+	{
+		__m128i r = _mm_add_epi64(a, b);
+		flags = _mm_or_si128(flags, _mm_and_si128(_mm_xor_si128(a, r), _mm_xor_si128(b, r)));
+		return r;
+	}
+
+	static inline __m128i sub_wrap(__m128i a, __m128i b, __m128i &flags) noexcept
+	{
+		__m128i r = _mm_sub_epi64(a, b);
+		flags = _mm_or_si128(flags, _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, r)));
+		return r;
+	}
+
+	static inline bool no_overflow(__m128i flags) noexcept
+	{
+		return _mm_movemask_pd(_mm_castsi128_pd(flags)) == 0;
+	}
+
+	// Partial sums of lanes may overflow where the sequential sum does not, reported as well
+	static bool reduce_add(const integer_t *data, std::size_t n, integer_t &sum) noexcept
+	{
+		__m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128(), flags = _mm_setzero_si128();
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			acc0 = add_wrap(acc0, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), flags);
+			acc1 = add_wrap(acc1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 2)), flags);
+		}
+		alignas(16) integer_t lanes[2];
+		_mm_store_si128(reinterpret_cast<__m128i *>(lanes), add_wrap(acc0, acc1, flags));
+		bool exact = no_overflow(flags);
+		exact = scalar::reduce_add(lanes, 2, sum) && exact;
+		return scalar::reduce_add(data + i, n - i, sum) && exact;
+	}
+
+	static double reduce_add(const double *data, std::size_t n) noexcept
+	{
+		__m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + i));
+			acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i + 2));
+		}
+		alignas(16) double lanes[2];
+		_mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+		return lanes[0] + lanes[1] + scalar::reduce_add(data + i, n - i);
+	}
+
+	static std::size_t count_nonzero(const std::uint8_t *data, std::size_t n) noexcept
+	{
+		const __m128i zero = _mm_setzero_si128();
+		std::size_t zeros = 0, i = 0;
+		for (; i + 16 <= n; i += 16)
+		{
+			unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), zero));
+			for (; mask != 0; mask &= mask - 1)
+				++zeros;
+		}
+		return i - zeros + scalar::count_nonzero(data + i, n - i);
+	}
+
+	static double dot(const double *lhs, const double *rhs, std::size_t n) noexcept
+	{
+		__m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+			acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(lhs + i + 2), _mm_loadu_pd(rhs + i + 2)));
+		}
+		alignas(16) double lanes[2];
+		_mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+		return lanes[0] + lanes[1] + scalar::dot(lhs + i, rhs + i, n - i);
+	}
+
+	static bool elementwise(arith_op op, const integer_t *lhs, const integer_t *rhs, integer_t *out, std::size_t n) noexcept
+	{
+		__m128i flags = _mm_setzero_si128();
+		std::size_t i = 0;
+		switch (op)
+		{
+			case arith_op::add:
+				for (; i + 2 <= n; i += 2)
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+					                 add_wrap(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i)),
+					                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i)), flags));
+				break;
+			case arith_op::sub:
+				for (; i + 2 <= n; i += 2)
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+					                 sub_wrap(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i)),
+					                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i)), flags));
+				break;
+			default:
+				// No 64 bits multiplication before AVX-512
+				break;
+		}
+		return scalar::elementwise(op, lhs + i, rhs + i, out + i, n - i) && no_overflow(flags);
+	}
+
+	static void elementwise(arith_op op, const double *lhs, const double *rhs, double *out, std::size_t n) noexcept
+	{
+		std::size_t i = 0;
+		switch (op)
+		{
+			case arith_op::add:
+				for (; i + 2 <= n; i += 2)
+					_mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+				break;
+			case arith_op::sub:
+				for (; i + 2 <= n; i += 2)
+					_mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+				break;
+			case arith_op::mul:
+				for (; i + 2 <= n; i += 2)
+					_mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+				break;
+			case arith_op::div:
+				for (; i + 2 <= n; i += 2)
+					_mm_storeu_pd(out + i, _mm_div_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+				break;
+		}
+		scalar::elementwise(op, lhs + i, rhs + i, out + i, n - i);
+	}
+
+	static void compare(compare_op op, const integer_t *lhs, integer_t rhs, std::uint8_t *out, std::size_t n) noexcept
+	{
+		std::size_t i = 0;
+		if (op == compare_op::eq || op == compare_op::ne)
+		{
+			// Ordering of 64 bits integers needs SSE4.2
+			const __m128i val = _mm_set1_epi64x(rhs);
+			const unsigned int flip = op == compare_op::ne ? 0b11 : 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128i eq = cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i)), val);
+				store_mask(_mm_movemask_pd(_mm_castsi128_pd(eq)) ^ flip, out + i, 2);
+			}
+		}
+		scalar::compare(op, lhs + i, rhs, out + i, n - i);
+	}
+
+	static void compare(compare_op op, const double *lhs, double rhs, std::uint8_t *out, std::size_t n) noexcept
+	{
+		const __m128d val = _mm_set1_pd(rhs);
+		std::size_t i = 0;
+		for (; i + 2 <= n; i += 2)
+		{
+			__m128d data = _mm_loadu_pd(lhs + i), mask;
+			switch (op)
+			{
+				default:
+				case compare_op::eq:
+					mask = _mm_cmpeq_pd(data, val);
+					break;
+				case compare_op::ne:
+					mask = _mm_cmpneq_pd(data, val);
+					break;
+				case compare_op::lt:
+					mask = _mm_cmplt_pd(data, val);
+					break;
+				case compare_op::le:
+					mask = _mm_cmple_pd(data, val);
+					break;
+				case compare_op::gt:
+					mask = _mm_cmpgt_pd(data, val);
+					break;
+				case compare_op::ge:
+					mask = _mm_cmpge_pd(data, val);
+					break;
+			}
+			store_mask(_mm_movemask_pd(mask), out + i, 2);
+		}
+		scalar::compare(op, lhs + i, rhs, out + i, n - i);
+	}
+
+	static std::size_t find(const integer_t *data, std::size_t n, integer_t val) noexcept
+	{
+		const __m128i key = _mm_set1_epi64x(val);
+		std::size_t i = 0;
+		for (; i + 2 <= n; i += 2)
+		{
+			if (_mm_movemask_pd(_mm_castsi128_pd(cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), key))) != 0)
+				return i + scalar::find(data + i, 2, val);
+		}
+		return i + scalar::find(data + i, n - i, val);
+	}
+
+	static std::size_t find(const double *data, std::size_t n, double val) noexcept
+	{
+		const __m128d key = _mm_set1_pd(val);
+		std::size_t i = 0;
+		for (; i + 2 <= n; i += 2)
+		{
+			if (_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(data + i), key)) != 0)
+				return i + scalar::find(data + i, 2, val);
+		}
+		return i + scalar::find(data + i, n - i, val);
+	}
+
+	static std::size_t find(const std::uint8_t *data, std::size_t n, std::uint8_t val) noexcept
+	{
+		const __m128i key = _mm_set1_epi8(static_cast<char>(val));
+		std::size_t i = 0;
+		for (; i + 16 <= n; i += 16)
+		{
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), key)) != 0)
+				return i + scalar::find(data + i, 16, val);
+		}
+		return i + scalar::find(data + i, n - i, val);
+	}
+
+	static inline int popcount(unsigned int mask) noexcept
+	{
+#if defined(COVSCRIPT_COMPILER_GNUC) || defined(COVSCRIPT_COMPILER_CLANG)
+		return __builtin_popcount(mask);
+#else
+		int count = 0;
+		for (; mask != 0; mask &= mask - 1)
+			++count;
+		return count;
+#endif
+	}
+
+	// No byte shuffle before SSSE3, so only runs of ASCII are vectorised
+	static bool utf8_validate(const char *data, std::size_t n) noexcept
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+		std::size_t i = 0;
+		while (i < n)
+		{
+			if (i + 16 <= n && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i))) == 0)
+			{
+				i += 16;
+				continue;
+			}
+			// Up to the next block boundary in scalar
+			for (std::size_t end = std::min(i + 16, n); i < end;)
+			{
+				std::size_t len = scalar::utf8_sequence(p + i, n - i);
+				if (len == 0)
+					return false;
+				i += len;
+			}
+		}
+		return true;
+	}
+
+	// Count of bytes other than continuations, 0x80 to 0xBF are below -64 as signed bytes
+	static std::size_t utf8_length(const char *data, std::size_t n) noexcept
+	{
+		const __m128i threshold = _mm_set1_epi8(-65);
+		std::size_t count = 0, i = 0;
+		for (; i + 16 <= n; i += 16)
+			count += popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), threshold)));
+		return count + scalar::utf8_length(data + i, n - i);
+	}
+
+	static char32_t *utf8_to_utf32(const char *data, std::size_t n, char32_t *out) noexcept
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(data), *end = p + n;
+		const __m128i zero = _mm_setzero_si128();
+		while (p < end)
+		{
+			if (end - p >= 16)
+			{
+				__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+				if (_mm_movemask_epi8(bytes) == 0)
+				{
+					__m128i lo = _mm_unpacklo_epi8(bytes, zero), hi = _mm_unpackhi_epi8(bytes, zero);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(lo, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4), _mm_unpackhi_epi16(lo, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpacklo_epi16(hi, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm_unpackhi_epi16(hi, zero));
+					p += 16;
+					out += 16;
+					continue;
+				}
+			}
+			for (const unsigned char *block_end = std::min(p + 16, end); p < block_end;)
+				*out++ = scalar::utf8_decode(p);
+		}
+		return out;
+	}
+
+	static std::size_t utf32_to_utf8_length(const char32_t *data, std::size_t n) noexcept
+	{
+		// Lanes count 1 to 3 extra bytes per code point, flushed before 32 bits lanes could overflow
+		constexpr std::size_t flush_interval = std::size_t(1) << 28;
+		std::size_t len = n, i = 0;
+		while (i + 4 <= n)
+		{
+			__m128i acc = _mm_setzero_si128();
+			for (std::size_t end = std::min(i + flush_interval, n); i + 4 <= end; i += 4)
+			{
+				__m128i cp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+				acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7F)));
+				acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7FF)));
+				acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(cp, _mm_set1_epi32(0xFFFF)));
+				// Invalid code points take three bytes of U+FFFD, negative ones are above 0x7FFFFFFF
+				acc = _mm_add_epi32(acc, _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x10FFFF)));
+				acc = _mm_sub_epi32(acc, _mm_add_epi32(_mm_cmplt_epi32(cp, _mm_setzero_si128()), _mm_cmplt_epi32(cp, _mm_setzero_si128())));
+			}
+			alignas(16) std::uint32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+			len += std::size_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+		}
+		return len + scalar::utf32_to_utf8_length(data + i, n - i) - (n - i);
+	}
+
+	static char *utf32_to_utf8(const char32_t *data, std::size_t n, char *out) noexcept
+	{
+		const __m128i ascii_max = _mm_set1_epi32(0x7F), zero = _mm_setzero_si128();
+		std::size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 4));
+			__m128i non_ascii = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(a, ascii_max), _mm_cmplt_epi32(a, zero)),
+			                                 _mm_or_si128(_mm_cmpgt_epi32(b, ascii_max), _mm_cmplt_epi32(b, zero)));
+			if (_mm_movemask_epi8(non_ascii) == 0)
+			{
+				__m128i words = _mm_packs_epi32(a, b);
+				_mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(words, words));
+				out += 8;
+			}
+			else
+				out = scalar::utf32_to_utf8(data + i, 8, out);
+		}
+		return scalar::utf32_to_utf8(data + i, n - i, out);
+	}
+} // namespace cs::simd::sse2
+#endif
+
+#ifdef COVSCRIPT_SIMD_AVX2
+namespace cs::simd::avx2
+{
+	COVSCRIPT_TARGET_AVX2 static inline integer_t horizontal_add(__m256i vec) noexcept
+	{
+		alignas(32) std::uint64_t lanes[4];
+		_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), vec);
+		return static_cast<integer_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static inline double horizontal_add(__m256d vec) noexcept
+	{
+		alignas(32) double lanes[4];
+		_mm256_store_pd(lanes, vec);
+		return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static inline __m256i add_wrap(__m256i a, __m256i b, __m256i &flags) noexcept
+	{
+		__m256i r = _mm256_add_epi64(a, b);
+		flags = _mm256_or_si256(flags, _mm256_and_si256(_mm256_xor_si256(a, r), _mm256_xor_si256(b, r)));
+		return r;
+	}
+
+	COVSCRIPT_TARGET_AVX2 static inline __m256i sub_wrap(__m256i a, __m256i b, __m256i &flags) noexcept
+	{
+		__m256i r = _mm256_sub_epi64(a, b);
+		flags = _mm256_or_si256(flags, _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, r)));
+		return r;
+	}
+
+	COVSCRIPT_TARGET_AVX2 static inline bool no_overflow(__m256i flags) noexcept
+	{
+		return _mm256_movemask_pd(_mm256_castsi256_pd(flags)) == 0;
+	}
+
+	COVSCRIPT_TARGET_AVX2 static bool reduce_add(const integer_t *data, std::size_t n, integer_t &sum) noexcept
+	{
+		__m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256(), flags = _mm256_setzero_si256();
+		std::size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			acc0 = add_wrap(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), flags);
+			acc1 = add_wrap(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 4)), flags);
+		}
+		alignas(32) integer_t lanes[4];
+		_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), add_wrap(acc0, acc1, flags));
+		bool exact = no_overflow(flags);
+		exact = scalar::reduce_add(lanes, 4, sum) && exact;
+		return scalar::reduce_add(data + i, n - i, sum) && exact;
+	}
+
+	COVSCRIPT_TARGET_AVX2 static double reduce_add(const double *data, std::size_t n) noexcept
+	{
+		__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+		std::size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+			acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+		}
+		return horizontal_add(_mm256_add_pd(acc0, acc1)) + scalar::reduce_add(data + i, n - i);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static std::size_t count_nonzero(const std::uint8_t *data, std::size_t n) noexcept
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		std::size_t zeros = 0, i = 0;
+		for (; i + 32 <= n; i += 32)
+		{
+			unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), zero)));
+			for (; mask != 0; mask &= mask - 1)
+				++zeros;
+		}
+		return i - zeros + scalar::count_nonzero(data + i, n - i);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static double dot(const double *lhs, const double *rhs, std::size_t n) noexcept
+	{
+		__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+		std::size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+			acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(lhs + i + 4), _mm256_loadu_pd(rhs + i + 4)));
+		}
+		return horizontal_add(_mm256_add_pd(acc0, acc1)) + scalar::dot(lhs + i, rhs + i, n - i);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static bool elementwise(arith_op op, const integer_t *lhs, const integer_t *rhs, integer_t *out, std::size_t n) noexcept
+	{
+		__m256i flags = _mm256_setzero_si256();
+		std::size_t i = 0;
+		switch (op)
+		{
+			case arith_op::add:
+				for (; i + 4 <= n; i += 4)
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+					                    add_wrap(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i)),
+					                             _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i)), flags));
+				break;
+			case arith_op::sub:
+				for (; i + 4 <= n; i += 4)
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+					                    sub_wrap(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i)),
+					                             _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i)), flags));
+				break;
+			default:
+				break;
+		}
+		return scalar::elementwise(op, lhs + i, rhs + i, out + i, n - i) && no_overflow(flags);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static void elementwise(arith_op op, const double *lhs, const double *rhs, double *out, std::size_t n) noexcept
+	{
+		std::size_t i = 0;
+		switch (op)
+		{
+			case arith_op::add:
+				for (; i + 4 <= n; i += 4)
+					_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+				break;
+			case arith_op::sub:
+				for (; i + 4 <= n; i += 4)
+					_mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+				break;
+			case arith_op::mul:
+				for (; i + 4 <= n; i += 4)
+					_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+				break;
+			case arith_op::div:
+				for (; i + 4 <= n; i += 4)
+					_mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+				break;
+		}
+		scalar::elementwise(op, lhs + i, rhs + i, out + i, n - i);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static inline void store_mask(unsigned int mask, std::uint8_t *out) noexcept
+	{
+		out[0] = mask & 1;
+		out[1] = (mask >> 1) & 1;
+		out[2] = (mask >> 2) & 1;
+		out[3] = (mask >> 3) & 1;
+	}
+
+	COVSCRIPT_TARGET_AVX2 static void compare(compare_op op, const integer_t *lhs, integer_t rhs, std::uint8_t *out, std::size_t n) noexcept
+	{
+		const __m256i val = _mm256_set1_epi64x(rhs);
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i));
+			unsigned int mask;
+			// Only equal and greater than are native, others are derived by swapping or negation
+			switch (op)
+			{
+				default:
+				case compare_op::eq:
+					mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(data, val)));
+					break;
+				case compare_op::ne:
+					mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(data, val))) ^ 0xF;
+					break;
+				case compare_op::lt:
+					mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(val, data)));
+					break;
+				case compare_op::le:
+					mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(data, val))) ^ 0xF;
+					break;
+				case compare_op::gt:
+					mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(data, val)));
+					break;
+				case compare_op::ge:
+					mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(val, data))) ^ 0xF;
+					break;
+			}
+			store_mask(mask, out + i);
+		}
+		scalar::compare(op, lhs + i, rhs, out + i, n - i);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static void compare(compare_op op, const double *lhs, double rhs, std::uint8_t *out, std::size_t n) noexcept
+	{
+		const __m256d val = _mm256_set1_pd(rhs);
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m256d data = _mm256_loadu_pd(lhs + i), mask;
+			// Ordered predicates except not equal, same as the C++ operators on NaN
+			switch (op)
+			{
+				default:
+				case compare_op::eq:
+					mask = _mm256_cmp_pd(data, val, _CMP_EQ_OQ);
+					break;
+				case compare_op::ne:
+					mask = _mm256_cmp_pd(data, val, _CMP_NEQ_UQ);
+					break;
+				case compare_op::lt:
+					mask = _mm256_cmp_pd(data, val, _CMP_LT_OQ);
+					break;
+				case compare_op::le:
+					mask = _mm256_cmp_pd(data, val, _CMP_LE_OQ);
+					break;
+				case compare_op::gt:
+					mask = _mm256_cmp_pd(data, val, _CMP_GT_OQ);
+					break;
+				case compare_op::ge:
+					mask = _mm256_cmp_pd(data, val, _CMP_GE_OQ);
+					break;
+			}
+			store_mask(_mm256_movemask_pd(mask), out + i);
+		}
+		scalar::compare(op, lhs + i, rhs, out + i, n - i);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static std::size_t find(const integer_t *data, std::size_t n, integer_t val) noexcept
+	{
+		const __m256i key = _mm256_set1_epi64x(val);
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			if (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), key))) != 0)
+				return i + scalar::find(data + i, 4, val);
+		}
+		return i + scalar::find(data + i, n - i, val);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static std::size_t find(const double *data, std::size_t n, double val) noexcept
+	{
+		const __m256d key = _mm256_set1_pd(val);
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + i), key, _CMP_EQ_OQ)) != 0)
+				return i + scalar::find(data + i, 4, val);
+		}
+		return i + scalar::find(data + i, n - i, val);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static std::size_t find(const std::uint8_t *data, std::size_t n, std::uint8_t val) noexcept
+	{
+		const __m256i key = _mm256_set1_epi8(static_cast<char>(val));
+		std::size_t i = 0;
+		for (; i + 32 <= n; i += 32)
+		{
+			if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), key)) != 0)
+				return i + scalar::find(data + i, 32, val);
+		}
+		return i + scalar::find(data + i, n - i, val);
+	}
+
+	/*
+	 * UTF-8 validation of Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"
+	 * Three nibble lookups classify every pair of adjacent bytes into error bits, two and three bytes
+	 * back are checked separately for the continuations of three and four bytes sequences.
+	 */
+	namespace utf8_detail
+	{
+		constexpr std::uint8_t too_short = 1 << 0, too_long = 1 << 1, overlong_3 = 1 << 2, too_large = 1 << 3,
+		                       surrogate = 1 << 4, overlong_2 = 1 << 5, too_large_1000 = 1 << 6, overlong_4 = 1 << 6,
+		                       two_conts = 1 << 7, carry = too_short | too_long | two_conts;
+
+		// Same table in both 128 bits lanes, as vpshufb looks up within lanes
+		COVSCRIPT_TARGET_AVX2 static inline __m256i table(std::uint8_t v0, std::uint8_t v1, std::uint8_t v2, std::uint8_t v3,
+		                                                  std::uint8_t v4, std::uint8_t v5, std::uint8_t v6, std::uint8_t v7,
+		                                                  std::uint8_t v8, std::uint8_t v9, std::uint8_t v10, std::uint8_t v11,
+		                                                  std::uint8_t v12, std::uint8_t v13, std::uint8_t v14, std::uint8_t v15) noexcept
+		{
+			return _mm256_setr_epi8(v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15,
+			                        v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15);
+		}
+
+		// Bytes of input shifted by N, the gap filled with the tail of prev
+		template <int N>
+		COVSCRIPT_TARGET_AVX2 static inline __m256i prev_bytes(__m256i input, __m256i prev) noexcept
+		{
+			return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+		}
+
+		COVSCRIPT_TARGET_AVX2 static inline __m256i check_block(__m256i input, __m256i prev) noexcept
+		{
+			const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+			__m256i prev1 = prev_bytes<1>(input, prev);
+			__m256i byte_1_high = _mm256_shuffle_epi8(
+			    table(too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+			          two_conts, two_conts, two_conts, two_conts,
+			          too_short | overlong_2, too_short, too_short | overlong_3 | surrogate,
+			          too_short | too_large | too_large_1000 | overlong_4),
+			    _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+			__m256i byte_1_low = _mm256_shuffle_epi8(
+			    table(carry | overlong_3 | overlong_2 | overlong_4, carry | overlong_2, carry, carry,
+			          carry | too_large, carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+			          carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+			          carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+			          carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+			          carry | too_large | too_large_1000 | surrogate, carry | too_large | too_large_1000,
+			          carry | too_large | too_large_1000),
+			    _mm256_and_si256(prev1, low_nibble));
+			__m256i byte_2_high = _mm256_shuffle_epi8(
+			    table(too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+			          too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+			          too_long | overlong_2 | two_conts | overlong_3 | too_large,
+			          too_long | overlong_2 | two_conts | surrogate | too_large,
+			          too_long | overlong_2 | two_conts | surrogate | too_large,
+			          too_short, too_short, too_short, too_short),
+			    _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+			__m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+			// Only 111xxxxx two bytes back and 1111xxxx three bytes back reach 0x80
+			__m256i third = _mm256_subs_epu8(prev_bytes<2>(input, prev), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+			__m256i fourth = _mm256_subs_epu8(prev_bytes<3>(input, prev), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+			__m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+			return _mm256_xor_si256(must_be_continuation, special);
+		}
+
+		// Non-zero if the block ends inside a sequence
+		COVSCRIPT_TARGET_AVX2 static inline __m256i incomplete(__m256i input) noexcept
+		{
+			const __m256i max_value = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			                                           -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			                                           static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+			return _mm256_subs_epu8(input, max_value);
+		}
+
+		COVSCRIPT_TARGET_AVX2 static inline void check_next(__m256i input, __m256i &error, __m256i &prev, __m256i &prev_incomplete) noexcept
+		{
+			if (_mm256_movemask_epi8(input) == 0)
+			{
+				error = _mm256_or_si256(error, prev_incomplete);
+				prev_incomplete = _mm256_setzero_si256();
+			}
+			else
+			{
+				error = _mm256_or_si256(error, check_block(input, prev));
+				prev_incomplete = incomplete(input);
+			}
+			prev = input;
+		}
+	} // namespace utf8_detail
+
+	COVSCRIPT_TARGET_AVX2 static bool utf8_validate(const char *data, std::size_t n) noexcept
+	{
+		using namespace utf8_detail;
+		__m256i error = _mm256_setzero_si256(), prev = _mm256_setzero_si256(), prev_incomplete = _mm256_setzero_si256();
+		std::size_t i = 0;
+		for (; i + 32 <= n; i += 32)
+			check_next(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), error, prev, prev_incomplete);
+		if (i < n)
+		{
+			// Padding of ASCII zeros, so sequences truncated by the end are too short
+			alignas(32) char tail[32] = {};
+			std::memcpy(tail, data + i, n - i);
+			check_next(_mm256_load_si256(reinterpret_cast<const __m256i *>(tail)), error, prev, prev_incomplete);
+		}
+		error = _mm256_or_si256(error, prev_incomplete);
+		return _mm256_testz_si256(error, error) != 0;
+	}
+
+	COVSCRIPT_TARGET_AVX2 static std::size_t utf8_length(const char *data, std::size_t n) noexcept
+	{
+		const __m256i threshold = _mm256_set1_epi8(-65);
+		std::size_t count = 0, i = 0;
+		for (; i + 32 <= n; i += 32)
+			count += sse2::popcount(static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), threshold))));
+		return count + scalar::utf8_length(data + i, n - i);
+	}
+
+	COVSCRIPT_TARGET_AVX2 static char32_t *utf8_to_utf32(const char *data, std::size_t n, char32_t *out) noexcept
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(data), *end = p + n;
+		while (p < end)
+		{
+			if (end - p >= 32 && _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))) == 0)
+			{
+				for (int k = 0; k < 32; k += 8)
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k), _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + k))));
+				p += 32;
+				out += 32;
+				continue;
+			}
+			for (const unsigned char *block_end = std::min(p + 32, end); p < block_end;)
+				*out++ = scalar::utf8_decode(p);
+		}
+		return out;
+	}
+} // namespace cs::simd::avx2
+#endif
+
+namespace cs::simd
+{
+#ifdef COVSCRIPT_SIMD_AVX2
+	static bool has_avx2() noexcept
+	{
+#if defined(COVSCRIPT_COMPILER_GNUC) || defined(COVSCRIPT_COMPILER_CLANG)
+		static const bool value = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+		return value;
+#else
+		return true;
+#endif
+	}
+#endif
+
+// Forward to the best kernel available
+#if defined(COVSCRIPT_SIMD_AVX2)
+#define COVSCRIPT_SIMD_DISPATCH(...) return has_avx2() ? avx2::__VA_ARGS__ : sse2::__VA_ARGS__
+#elif defined(COVSCRIPT_SIMD_SSE2)
+#define COVSCRIPT_SIMD_DISPATCH(...) return sse2::__VA_ARGS__
+#else
+#define COVSCRIPT_SIMD_DISPATCH(...) return scalar::__VA_ARGS__
+#endif
+
+	const char *active_isa() noexcept
+	{
+#if defined(COVSCRIPT_SIMD_AVX2)
+		return has_avx2() ? "avx2" : "sse2";
+#elif defined(COVSCRIPT_SIMD_SSE2)
+		return "sse2";
+#else
+		return "scalar";
+#endif
+	}
+
+	bool reduce_add(const integer_t *data, std::size_t n, integer_t &sum) noexcept
+	{
+		sum = 0;
+		COVSCRIPT_SIMD_DISPATCH(reduce_add(data, n, sum));
+	}
+
+	double reduce_add(const double *data, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(reduce_add(data, n));
+	}
+
+	std::size_t count_nonzero(const std::uint8_t *data, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(count_nonzero(data, n));
+	}
+
+	bool dot(const integer_t *lhs, const integer_t *rhs, std::size_t n, integer_t &sum) noexcept
+	{
+		// No 64 bits multiplication before AVX-512
+		sum = 0;
+		return scalar::dot(lhs, rhs, n, sum);
+	}
+
+	double dot(const double *lhs, const double *rhs, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(dot(lhs, rhs, n));
+	}
+
+	bool elementwise(arith_op op, const integer_t *lhs, const integer_t *rhs, integer_t *out, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(elementwise(op, lhs, rhs, out, n));
+	}
+
+	void elementwise(arith_op op, const double *lhs, const double *rhs, double *out, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(elementwise(op, lhs, rhs, out, n));
+	}
+
+	void compare(compare_op op, const integer_t *lhs, integer_t rhs, std::uint8_t *out, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(compare(op, lhs, rhs, out, n));
+	}
+
+	void compare(compare_op op, const double *lhs, double rhs, std::uint8_t *out, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(compare(op, lhs, rhs, out, n));
+	}
+
+	std::size_t find(const integer_t *data, std::size_t n, integer_t val) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(find(data, n, val));
+	}
+
+	std::size_t find(const double *data, std::size_t n, double val) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(find(data, n, val));
+	}
+
+	std::size_t find(const std::uint8_t *data, std::size_t n, std::uint8_t val) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(find(data, n, val));
+	}
+
+	bool utf8_validate(const char *data, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(utf8_validate(data, n));
+	}
+
+	std::size_t utf8_length(const char *data, std::size_t n) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(utf8_length(data, n));
+	}
+
+	char32_t *utf8_to_utf32(const char *data, std::size_t n, char32_t *out) noexcept
+	{
+		COVSCRIPT_SIMD_DISPATCH(utf8_to_utf32(data, n, out));
+	}
+
+	// Bound by the scalar path of non-ASCII code points, AVX2 would not help
+	std::size_t utf32_to_utf8_length(const char32_t *data, std::size_t n) noexcept
+	{
+#ifdef COVSCRIPT_SIMD_SSE2
+		return sse2::utf32_to_utf8_length(data, n);
+#else
+		return scalar::utf32_to_utf8_length(data, n);
+#endif
+	}
+
+	char *utf32_to_utf8(const char32_t *data, std::size_t n, char *out) noexcept
+	{
+#ifdef COVSCRIPT_SIMD_SSE2
+		return sse2::utf32_to_utf8(data, n, out);
+#else
+		return scalar::utf32_to_utf8(data, n, out);
+#endif
+	}
+
+#undef COVSCRIPT_SIMD_DISPATCH
+} // namespace cs::simd
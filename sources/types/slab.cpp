@@ -0,0 +1,475 @@
+#include <covscript/common/platform.hpp>
+#include <covscript/types/slab.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
+namespace cs::slab_detail
+{
+	namespace
+	{
+		// Blocks linked into the local free list at once when a slab is carved
+		constexpr std::size_t carve_batch = 64;
+
+		constexpr std::size_t header_size = (sizeof(slab) + granularity - 1) / granularity * granularity;
+
+		struct abandoned_slabs
+		{
+			std::mutex lock;
+			slab *lists[class_count] = {};
+		};
+
+		abandoned_slabs &get_abandoned()
+		{
+			// Never destroyed, blocks may be freed during static destruction
+			static abandoned_slabs *slabs = new abandoned_slabs;
+			return *slabs;
+		}
+
+		// Serves threads whose heap is already destroyed, always under the lock
+		struct global_heap
+		{
+			std::mutex lock;
+			heap data;
+		};
+
+		global_heap &get_global()
+		{
+			static global_heap *global = new global_heap;
+			return *global;
+		}
+
+		thread_local bool heap_destroyed = false;
+
+		void *alloc_slab_memory()
+		{
+#ifdef COVSCRIPT_PLATFORM_WIN32
+			void *ptr = _aligned_malloc(slab_size, slab_size);
+#else
+			void *ptr = std::aligned_alloc(slab_size, slab_size);
+#endif
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+
+		void free_slab_memory(slab *s) noexcept
+		{
+			s->~slab();
+#ifdef COVSCRIPT_PLATFORM_WIN32
+			_aligned_free(s);
+#else
+			std::free(s);
+#endif
+		}
+
+		slab *new_slab(heap *h, std::size_t cls)
+		{
+			slab *s = ::new (alloc_slab_memory()) slab;
+			s->owner.store(h, std::memory_order_relaxed);
+			s->remote_free.store(nullptr, std::memory_order_relaxed);
+			s->local_free = nullptr;
+			s->bump = reinterpret_cast<char *>(s) + header_size;
+			s->block_size = (cls + 1) * granularity;
+			s->end = reinterpret_cast<char *>(s) + header_size + (slab_size - header_size) / s->block_size * s->block_size;
+			s->size_class = cls;
+			s->used = 0;
+			s->full = false;
+			s->prev = s->next = nullptr;
+			return s;
+		}
+
+		void unlink(slab *&head, slab *s) noexcept
+		{
+			if (s->prev != nullptr)
+				s->prev->next = s->next;
+			else
+				head = s->next;
+			if (s->next != nullptr)
+				s->next->prev = s->prev;
+			s->prev = s->next = nullptr;
+		}
+
+		void push_front(slab *&head, slab *s) noexcept
+		{
+			s->prev = nullptr;
+			s->next = head;
+			if (head != nullptr)
+				head->prev = s;
+			head = s;
+		}
+
+		// Takes blocks freed by other threads
+		bool collect_remote(slab *s) noexcept
+		{
+			void *list = s->remote_free.exchange(nullptr, std::memory_order_acquire);
+			if (list == nullptr)
+				return false;
+			void *tail = list;
+			std::size_t count = 1;
+			for (; *static_cast<void **>(tail) != nullptr; ++count)
+				tail = *static_cast<void **>(tail);
+			*static_cast<void **>(tail) = s->local_free;
+			s->local_free = list;
+			s->used -= count;
+			return true;
+		}
+
+		bool refill(slab *s) noexcept
+		{
+			if (s->local_free != nullptr || collect_remote(s))
+				return true;
+			if (s->bump == s->end)
+				return false;
+			// Linked in address order, so fresh slabs are used sequentially
+			std::size_t count = std::min<std::size_t>(carve_batch, (s->end - s->bump) / s->block_size);
+			char *first = s->bump;
+			for (std::size_t i = 0; i + 1 < count; ++i)
+				*reinterpret_cast<void **>(first + i * s->block_size) = first + (i + 1) * s->block_size;
+			*reinterpret_cast<void **>(first + (count - 1) * s->block_size) = nullptr;
+			s->local_free = first;
+			s->bump += count * s->block_size;
+			return true;
+		}
+
+		void *pop(slab *s) noexcept
+		{
+			void *ptr = s->local_free;
+			s->local_free = *static_cast<void **>(ptr);
+			++s->used;
+			return ptr;
+		}
+
+		slab *adopt(heap *h, std::size_t cls) noexcept
+		{
+			abandoned_slabs &abandoned = get_abandoned();
+			std::lock_guard<std::mutex> guard(abandoned.lock);
+			slab *s = abandoned.lists[cls];
+			if (s != nullptr)
+			{
+				unlink(abandoned.lists[cls], s);
+				s->owner.store(h, std::memory_order_relaxed);
+			}
+			return s;
+		}
+
+		void *allocate_from(heap *h, std::size_t cls)
+		{
+			for (slab *s = h->available[cls]; s != nullptr;)
+			{
+				slab *next = s->next;
+				if (refill(s))
+				{
+					if (s != h->available[cls])
+					{
+						unlink(h->available[cls], s);
+						push_front(h->available[cls], s);
+					}
+					return pop(s);
+				}
+				unlink(h->available[cls], s);
+				push_front(h->full[cls], s);
+				s->full = true;
+				s = next;
+			}
+			slab *s = h->full[cls];
+			while (s != nullptr && s->remote_free.load(std::memory_order_relaxed) == nullptr)
+				s = s->next;
+			if (s != nullptr)
+			{
+				unlink(h->full[cls], s);
+				s->full = false;
+			}
+			else
+			{
+				s = adopt(h, cls);
+				if (s == nullptr)
+					s = new_slab(h, cls);
+				// Adopted slabs may still be full, so refill is checked again below
+				s->full = false;
+			}
+			push_front(h->available[cls], s);
+			if (!refill(s))
+				return allocate_from(h, cls);
+			return pop(s);
+		}
+
+		void release(heap *h, slab *s) noexcept
+		{
+			unlink(s->full ? h->full[s->size_class] : h->available[s->size_class], s);
+			free_slab_memory(s);
+		}
+
+		// Gives up every slab of a heap, empty ones are released, others are left for adoption
+		void abandon(heap *h) noexcept
+		{
+			abandoned_slabs &abandoned = get_abandoned();
+			for (std::size_t cls = 0; cls < class_count; ++cls)
+			{
+				for (slab **list : {&h->available[cls], &h->full[cls]})
+				{
+					while (slab *s = *list)
+					{
+						unlink(*list, s);
+						collect_remote(s);
+						if (s->used == 0)
+						{
+							free_slab_memory(s);
+							continue;
+						}
+						s->full = false;
+						std::lock_guard<std::mutex> guard(abandoned.lock);
+						s->owner.store(nullptr, std::memory_order_release);
+						push_front(abandoned.lists[cls], s);
+					}
+				}
+			}
+		}
+
+		struct heap_guard
+		{
+			heap *data = nullptr;
+
+			~heap_guard()
+			{
+				current_heap = nullptr;
+				heap_destroyed = true;
+				if (data != nullptr)
+				{
+					abandon(data);
+					delete data;
+				}
+			}
+		};
+
+		heap *thread_heap()
+		{
+			if (current_heap == nullptr && !heap_destroyed)
+			{
+				static thread_local heap_guard guard;
+				guard.data = new heap;
+				current_heap = guard.data;
+			}
+			return current_heap;
+		}
+
+		constexpr std::size_t frame_size = (sizeof(arena_frame) + granularity - 1) / granularity * granularity;
+
+		constexpr std::size_t frame_budget = 16 * slab_size;
+
+		constexpr std::size_t min_backoff = 16, max_backoff = std::size_t(1) << 16;
+
+		slab *new_arena_chunk()
+		{
+			slab *c = ::new (alloc_slab_memory()) slab;
+			c->owner.store(nullptr, std::memory_order_relaxed);
+			c->remote_free.store(nullptr, std::memory_order_relaxed);
+			c->local_free = nullptr;
+			c->bump = reinterpret_cast<char *>(c) + header_size;
+			c->end = reinterpret_cast<char *>(c) + slab_size;
+			c->block_size = 0;
+			c->size_class = arena_class;
+			c->used = 0;
+			// Never taken by the fast path of deallocate
+			c->full = true;
+			c->prev = c->next = nullptr;
+			return c;
+		}
+
+		void free_chunks(slab *c) noexcept
+		{
+			while (c != nullptr)
+			{
+				slab *next = c->next;
+				free_slab_memory(c);
+				c = next;
+			}
+		}
+
+		// Moves to the next spare chunk, or a new one
+		void advance(arena *a)
+		{
+			slab *next = a->current != nullptr ? a->current->next : a->first;
+			if (next == nullptr)
+			{
+				next = new_arena_chunk();
+				if (a->current != nullptr)
+					a->current->next = next;
+				else
+					a->first = next;
+			}
+			else
+				next->bump = reinterpret_cast<char *>(next) + header_size;
+			a->current = next;
+		}
+
+		void release_frame(arena_frame *f) noexcept;
+
+		// A block or a retired child of the frame is gone
+		void release_ref(arena_frame *f) noexcept
+		{
+			heap *h = current_heap;
+			if (h != nullptr && h == f->owner && !f->retired)
+				--f->local_live;
+			else if (f->remote.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				release_frame(f);
+		}
+
+		// The last survivor of a retired frame is gone
+		void release_frame(arena_frame *f) noexcept
+		{
+			if (f->parent != nullptr)
+				release_ref(f->parent);
+			else
+				free_chunks(f->chunks);
+		}
+	} // namespace
+
+	void *arena_allocate_slow(arena *a, std::size_t size)
+	{
+		advance(a);
+		return arena_allocate(a, size);
+	}
+
+	void enter_frame(arena *a)
+	{
+		heap *h = thread_heap();
+		if (a->top == nullptr)
+		{
+			// Nothing is alive in the chunks left, the outermost frame starts over
+			a->current = nullptr;
+		}
+		if (a->current == nullptr || std::size_t(a->current->end - a->current->bump) < frame_size)
+			advance(a);
+		slab *c = a->current;
+		escape_backoff &siblings = a->top != nullptr ? a->top->children : a->outermost;
+		arena_frame *f = ::new (c->bump) arena_frame;
+		f->owner = h;
+		f->home = a;
+		f->parent = a->top;
+		f->open_prev = nullptr;
+		f->open_next = nullptr;
+		f->budget = frame_budget;
+		if (siblings.skip > 0)
+		{
+			--siblings.skip;
+			f->budget = 0;
+		}
+		f->chunk = c;
+		f->mark = c->bump;
+		f->local_live = 0;
+		f->remote.store(0, std::memory_order_relaxed);
+		f->retired = false;
+		f->chunks = nullptr;
+		c->bump += frame_size;
+		a->top = f;
+		if (h != nullptr)
+		{
+			f->open_next = h->open_frames;
+			if (h->open_frames != nullptr)
+				h->open_frames->open_prev = f;
+			h->open_frames = f;
+			h->active_arena = a;
+		}
+	}
+
+	void leave_frame(arena *a) noexcept
+	{
+		arena_frame *f = a->top;
+		a->top = f->parent;
+		// Managers on one thread may leave their frames interleaved, the latest frame still open decides
+		if (heap *h = f->owner; h != nullptr)
+		{
+			if (f->open_prev != nullptr)
+				f->open_prev->open_next = f->open_next;
+			else
+				h->open_frames = f->open_next;
+			if (f->open_next != nullptr)
+				f->open_next->open_prev = f->open_prev;
+			h->active_arena = h->open_frames != nullptr ? h->open_frames->home : nullptr;
+		}
+		std::ptrdiff_t live = std::ptrdiff_t(f->local_live);
+		if (live + f->remote.load(std::memory_order_acquire) == 0)
+		{
+			a->current = f->chunk;
+			a->current->bump = f->mark;
+			return;
+		}
+		// Some blocks escaped, the region stays until they are freed
+		escape_backoff &siblings = f->parent != nullptr ? f->parent->children : a->outermost;
+		siblings.span = std::min(std::max(siblings.span * 2, min_backoff), max_backoff);
+		siblings.skip = siblings.span;
+		if (f->parent != nullptr)
+			++f->parent->local_live;
+		else
+		{
+			f->chunks = a->first;
+			a->first = a->current->next;
+			a->current->next = nullptr;
+			a->current = nullptr;
+		}
+		f->retired = true;
+		if (f->remote.fetch_add(live, std::memory_order_acq_rel) + live == 0)
+			release_frame(f);
+	}
+
+	void destroy_arena(arena *a) noexcept
+	{
+		while (a->top != nullptr)
+			leave_frame(a);
+		free_chunks(a->first);
+		a->first = a->current = nullptr;
+	}
+
+	std::size_t arena_used(const arena *a) noexcept
+	{
+		std::size_t size = 0;
+		for (slab *c = a->first; c != nullptr; c = c->next)
+		{
+			size += c->bump - (reinterpret_cast<char *>(c) + header_size);
+			if (c == a->current)
+				break;
+		}
+		return a->current == nullptr ? 0 : size;
+	}
+
+	void *allocate_slow(std::size_t size)
+	{
+		std::size_t cls = class_of(size);
+		heap *h = thread_heap();
+		if (h != nullptr)
+			return allocate_from(h, cls);
+		global_heap &global = get_global();
+		std::lock_guard<std::mutex> guard(global.lock);
+		return allocate_from(&global.data, cls);
+	}
+
+	void deallocate_slow(slab *s, void *ptr) noexcept
+	{
+		if (s->size_class == arena_class)
+		{
+			release_ref(*reinterpret_cast<arena_frame **>(static_cast<char *>(ptr) - arena_prefix));
+			return;
+		}
+		heap *h = current_heap;
+		if (h != nullptr && s->owner.load(std::memory_order_relaxed) == h)
+		{
+			*static_cast<void **>(ptr) = s->local_free;
+			s->local_free = ptr;
+			if (s->full)
+			{
+				unlink(h->full[s->size_class], s);
+				push_front(h->available[s->size_class], s);
+				s->full = false;
+			}
+			// Empty slabs are kept only while serving the fast path
+			if (--s->used == 0 && s != h->available[s->size_class])
+				release(h, s);
+			return;
+		}
+		void *head = s->remote_free.load(std::memory_order_relaxed);
+		do
+			*static_cast<void **>(ptr) = head;
+		while (!s->remote_free.compare_exchange_weak(head, ptr, std::memory_order_release, std::memory_order_relaxed));
+	}
+} // namespace cs::slab_detail
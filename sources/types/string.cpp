@@ -1,13 +1,13 @@
 #include <covscript/types/string.hpp>
-#include <covscript/types/numeric.hpp>
 #include <covscript/types/exception.hpp>
+#include <covscript/types/simd.hpp>
 #include <utfcpp/utf8.h>
 
 namespace cs::unicode
 {
 	bool is_valid(byte_string_view str) noexcept
 	{
-		return utf8::is_valid(str);
+		return simd::utf8_validate(str.data(), str.size());
 	}
 
 	uchar_t next(byte_string_t::const_iterator &it)
@@ -22,35 +22,20 @@ namespace cs::unicode
 		}
 	}
 
+	// Validated in one pass, then decoded into the exactly sized output
 	unicode_string_t byte_to_unicode(byte_string_view str)
 	{
-		try
-		{
-			unicode_string_t ustr;
-			utf8::utf8to32(str.begin(), str.end(), std::back_inserter(ustr));
-			return ustr;
-		}
-		catch (const utf8::exception &utfcpp_ex)
-		{
-			throw lang_error(utfcpp_ex.what());
-		}
+		if (!simd::utf8_validate(str.data(), str.size()))
+			throw lang_error("Invalid UTF-8");
+		unicode_string_t ustr(simd::utf8_length(str.data(), str.size()), U'\0');
+		simd::utf8_to_utf32(str.data(), str.size(), &ustr[0]);
+		return ustr;
 	}
 
 	byte_string_t unicode_to_byte(unicode_string_view ustr) noexcept
 	{
-		byte_string_t str;
-		utf8::unchecked::utf32to8(ustr.begin(), ustr.end(), std::back_inserter(str));
+		byte_string_t str(simd::utf32_to_utf8_length(ustr.data(), ustr.size()), '\0');
+		simd::utf32_to_utf8(ustr.data(), ustr.size(), &str[0]);
 		return str;
 	}
-} // namespace cs::unicode
-
-namespace cs
-{
-	byte_string_t numeric_t::to_string() const
-	{
-		if (type)
-			return cs::to_string(data._int);
-		else
-			return cs::to_string(data._num);
-	}
-} // namespace cs
\ No newline at end of file
+} // namespace cs::unicode
\ No newline at end of file
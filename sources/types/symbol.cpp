@@ -0,0 +1,44 @@
+#include <covscript/types/symbol.hpp>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+
+namespace cs
+{
+	namespace
+	{
+		struct symbol_table
+		{
+			std::mutex lock;
+			// Entries never move, so keys are views of their own strings
+			std::deque<symbol_t::entry> entries;
+			std::unordered_map<byte_string_view, const symbol_t::entry *> index;
+		};
+
+		symbol_table &get_symbol_table()
+		{
+			static symbol_table table;
+			return table;
+		}
+	} // namespace
+
+	const symbol_t::entry *symbol_t::intern(byte_string_view str)
+	{
+		symbol_table &table = get_symbol_table();
+		std::size_t hash = std::hash<byte_string_view>{}(str);
+		std::lock_guard<std::mutex> guard(table.lock);
+		auto it = table.index.find(str);
+		if (it != table.index.end())
+			return it->second;
+		const entry &ent = table.entries.emplace_back(entry{byte_string_t(str), table.entries.size() + 1, hash});
+		table.index.emplace(byte_string_view(ent.str), &ent);
+		return &ent;
+	}
+
+	std::size_t symbol_t::table_size() noexcept
+	{
+		symbol_table &table = get_symbol_table();
+		std::lock_guard<std::mutex> guard(table.lock);
+		return table.entries.size();
+	}
+} // namespace cs
@@ -0,0 +1,133 @@
+#include <covscript/types/utf8_string.hpp>
+#include <covscript/types/exception.hpp>
+#include <covscript/types/simd.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+namespace cs
+{
+	namespace
+	{
+		constexpr std::uint64_t ones = 0x0101010101010101ull, highs = 0x8080808080808080ull;
+
+		// Bytes in memory order from the lowest
+		inline std::uint64_t load_word(const char *data) noexcept
+		{
+			std::uint64_t word;
+			std::memcpy(&word, data, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			word = __builtin_bswap64(word);
+#endif
+			return word;
+		}
+
+		/*
+		 * Byte offset after skipping count code points from offset, eight bytes at a time.
+		 * A byte starts a code point unless its top bits are 10. Multiplying the lead flags
+		 * by ones gives the running count of leads in every byte, the target is the first
+		 * byte where it exceeds count.
+		 */
+		std::size_t skip_code_points(const char *data, std::size_t size, std::size_t offset, std::size_t count) noexcept
+		{
+			for (; offset + 8 <= size; offset += 8)
+			{
+				std::uint64_t word = load_word(data + offset);
+				std::uint64_t prefix = ((~word | word << 1) & highs) >> 7;
+				prefix *= ones;
+				std::size_t leads = static_cast<std::size_t>(prefix >> 56);
+				if (leads > count)
+				{
+					std::uint64_t before = ((count * ones | highs) - prefix) & highs;
+					return offset + static_cast<std::size_t>((before >> 7) * ones >> 56);
+				}
+				count -= leads;
+			}
+			for (; offset < size; ++offset)
+			{
+				if ((static_cast<unsigned char>(data[offset]) & 0xC0) == 0x80)
+					continue;
+				if (count == 0)
+					break;
+				--count;
+			}
+			return offset;
+		}
+	} // namespace
+
+	utf8_string_t::utf8_string_t(byte_string_t str) : m_str(std::move(str))
+	{
+		if (!simd::utf8_validate(m_str.data(), m_str.size()))
+			throw lang_error("Invalid UTF-8");
+		m_length = simd::utf8_length(m_str.data(), m_str.size());
+	}
+
+	// Every code point is encoded, invalid ones as one U+FFFD
+	utf8_string_t::utf8_string_t(unicode_string_view str) : m_str(unicode::unicode_to_byte(str)), m_length(str.size()) {}
+
+	utf8_string_t::utf8_string_t(const utf8_string_t &other) : m_str(other.m_str), m_length(other.m_length)
+	{
+		const offset_index *idx = other.m_index.load(std::memory_order_acquire);
+		if (idx != nullptr)
+			m_index.store(new offset_index(*idx), std::memory_order_release);
+	}
+
+	// Racing builders build their own copies, only the first one is published
+	const utf8_string_t::offset_index &utf8_string_t::get_index() const
+	{
+		const offset_index *idx = m_index.load(std::memory_order_acquire);
+		if (idx != nullptr)
+			return *idx;
+		offset_index *built = new offset_index;
+		built->offsets.reserve(m_length / index_stride + 1);
+		built->offsets.push_back(0);
+		for (std::size_t pos = index_stride, offset = 0; pos < m_length; pos += index_stride)
+		{
+			offset = skip_code_points(m_str.data(), m_str.size(), offset, index_stride);
+			built->offsets.push_back(offset);
+		}
+		if (m_index.compare_exchange_strong(idx, built, std::memory_order_acq_rel, std::memory_order_acquire))
+			return *built;
+		delete built;
+		return *idx;
+	}
+
+	std::size_t utf8_string_t::offset_slow(std::size_t pos) const
+	{
+		if (pos >= m_length)
+		{
+			if (pos == m_length)
+				return m_str.size();
+			throw std::out_of_range("cs::utf8_string_t::offset_of");
+		}
+		// The first stride is reached without index, short strings never build one
+		std::size_t block = pos / index_stride;
+		std::size_t offset = block == 0 ? 0 : get_index().offsets[block];
+		return skip_code_points(m_str.data(), m_str.size(), offset, pos % index_stride);
+	}
+
+	byte_string_view utf8_string_t::view(std::size_t pos, std::size_t len) const
+	{
+		if (pos > m_length)
+			throw std::out_of_range("cs::utf8_string_t::view");
+		len = std::min(len, m_length - pos);
+		std::size_t begin = offset_of(pos);
+		std::size_t end = len > index_stride ? offset_of(pos + len) : skip_code_points(m_str.data(), m_str.size(), begin, len);
+		return byte_string_view(m_str.data() + begin, end - begin);
+	}
+
+	utf8_string_t utf8_string_t::substr(std::size_t pos, std::size_t len) const
+	{
+		if (pos > m_length)
+			throw std::out_of_range("cs::utf8_string_t::substr");
+		len = std::min(len, m_length - pos);
+		return utf8_string_t(trusted_tag(), byte_string_t(view(pos, len)), len);
+	}
+
+	unicode_string_t utf8_string_t::to_unicode() const
+	{
+		unicode_string_t ustr(m_length, U'\0');
+		simd::utf8_to_utf32(m_str.data(), m_str.size(), &ustr[0]);
+		return ustr;
+	}
+} // namespace cs
@@ -1,4 +1,14 @@
 #include <covscript/types/variable.hpp>
+#include <atomic>
+
+namespace cs_impl
+{
+	std::size_t alloc_type_id() noexcept
+	{
+		static std::atomic<std::size_t> next_id(static_cast<std::size_t>(cs::var_tag::other));
+		return next_id++;
+	}
+} // namespace cs_impl
 
 #ifdef COVSCRIPT_PLATFORM_WIN32
 
@@ -0,0 +1,230 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <covscript/types/types.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 1'000'000;
+constexpr size_t R = 10;
+constexpr size_t T = 4;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+// Too large for the small buffer, so stored on the heap
+struct payload
+{
+	cs::integer_t data[12];
+};
+
+// Same size, copies share the payload
+struct shared_payload
+{
+	cs::integer_t data[12];
+};
+
+namespace cs_impl
+{
+	template <>
+	struct var_cow<shared_payload>
+	{
+		static constexpr bool value = true;
+	};
+} // namespace cs_impl
+
+template <typename T>
+using pool_allocator = cs::allocator_type<T>;
+
+template <template <typename> class allocator_t>
+using var_with = cs::basic_var<COVSCRIPT_SVO_ALIGN_SIZE, allocator_t>;
+
+// Create, copy and destroy in bursts larger than the cache of allocator_type
+template <template <typename> class allocator_t>
+size_t heap_burst()
+{
+	using var = var_with<allocator_t>;
+	size_t sum = 0;
+	std::vector<var> vars;
+	vars.reserve(1000);
+	for (size_t r = 0; r < R; ++r)
+	{
+		for (size_t i = 0; i < N; i += 1000)
+		{
+			for (size_t j = 0; j < 1000; ++j)
+				vars.emplace_back(var::template make<payload>(payload{{cs::integer_t(i + j)}}));
+			for (size_t j = 0; j < 1000; j += 2)
+				vars.push_back(vars[j]);
+			for (auto &val : vars)
+				sum += val.template const_val<payload>().data[0];
+			vars.clear();
+		}
+	}
+	return sum;
+}
+
+// Shared payloads, copies only touch the reference count
+template <template <typename> class allocator_t>
+size_t cow_burst()
+{
+	using var = var_with<allocator_t>;
+	size_t sum = 0;
+	std::vector<var> vars;
+	vars.reserve(1000);
+	for (size_t r = 0; r < R; ++r)
+	{
+		for (size_t i = 0; i < N; i += 1000)
+		{
+			for (size_t j = 0; j < 1000; ++j)
+				vars.emplace_back(var::template make<shared_payload>(shared_payload{{cs::integer_t(i + j)}}));
+			for (size_t j = 0; j < 1000; j += 2)
+				vars.push_back(vars[j]);
+			for (auto &val : vars)
+				sum += val.template const_val<shared_payload>().data[0];
+			vars.clear();
+		}
+	}
+	return sum;
+}
+
+template <size_t words>
+struct sized_payload
+{
+	cs::integer_t data[words];
+};
+
+void scope_burst(std::vector<cs::var> &temps)
+{
+	for (size_t i = 0; i < 5000; ++i)
+	{
+		switch (i % 5)
+		{
+		case 0:
+			temps.emplace_back(cs::var::make<sized_payload<8>>());
+			break;
+		case 1:
+			temps.emplace_back(cs::var::make<sized_payload<20>>());
+			break;
+		case 2:
+			temps.emplace_back(cs::var::make<sized_payload<40>>());
+			break;
+		case 3:
+			temps.emplace_back(cs::var::make<sized_payload<12>>());
+			break;
+		default:
+			temps.emplace_back(cs::var::make<sized_payload<60>>());
+			break;
+		}
+	}
+}
+
+// Every thread runs the burst on its own
+template <typename F>
+size_t in_threads(F func)
+{
+	std::vector<std::thread> threads;
+	std::vector<size_t> sums(T);
+	for (size_t t = 0; t < T; ++t)
+		threads.emplace_back([&, t]() { sums[t] = func(); });
+	for (auto &th : threads)
+		th.join();
+	size_t sum = 0;
+	for (size_t val : sums)
+		sum += val;
+	return sum;
+}
+
+int main()
+{
+	std::cout << "=== Performance of variable allocation ===\n";
+
+	TIME_BLOCK("heap payload std::allocator", {
+		volatile size_t dummy = heap_burst<std::allocator>();
+	});
+	TIME_BLOCK("heap payload allocator_type", {
+		volatile size_t dummy = heap_burst<pool_allocator>();
+	});
+	TIME_BLOCK("heap payload slab_allocator", {
+		volatile size_t dummy = heap_burst<cs::slab_allocator>();
+	});
+
+	TIME_BLOCK("cow payload std::allocator", {
+		volatile size_t dummy = cow_burst<std::allocator>();
+	});
+	TIME_BLOCK("cow payload allocator_type", {
+		volatile size_t dummy = cow_burst<pool_allocator>();
+	});
+	TIME_BLOCK("cow payload slab_allocator", {
+		volatile size_t dummy = cow_burst<cs::slab_allocator>();
+	});
+
+	// Temporaries of mixed sizes in a scope, destroyed in both orders when it is left
+	for (bool lifo : {true, false})
+	{
+		const char *order = lifo ? " reverse order" : " allocation order";
+		std::vector<cs::var> temps;
+		temps.reserve(5000);
+		auto leave = [&]() {
+			if (lifo)
+			{
+				while (!temps.empty())
+					temps.pop_back();
+			}
+			else
+				temps.clear();
+		};
+		TIME_BLOCK(std::string("scope temporaries slab_allocator") + order, {
+			for (size_t i = 0; i < N * R / 5000; ++i)
+			{
+				scope_burst(temps);
+				leave();
+			}
+		});
+		TIME_BLOCK(std::string("scope temporaries domain_arena") + order, {
+			cs::domain_arena arena;
+			for (size_t i = 0; i < N * R / 5000; ++i)
+			{
+				arena.enter();
+				scope_burst(temps);
+				leave();
+				arena.leave();
+			}
+		});
+	}
+
+	// allocator_type shares one cache between threads without locking, so it is left out
+	std::cout << "--- " << T << " threads ---\n";
+	TIME_BLOCK("heap payload std::allocator", {
+		volatile size_t dummy = in_threads(heap_burst<std::allocator>);
+	});
+	TIME_BLOCK("heap payload slab_allocator", {
+		volatile size_t dummy = in_threads(heap_burst<cs::slab_allocator>);
+	});
+	TIME_BLOCK("cow payload std::allocator", {
+		volatile size_t dummy = in_threads(cow_burst<std::allocator>);
+	});
+	TIME_BLOCK("cow payload slab_allocator", {
+		volatile size_t dummy = in_threads(cow_burst<cs::slab_allocator>);
+	});
+
+	// Produced on one thread, destroyed on another
+	TIME_BLOCK("cross-thread free slab_allocator", {
+		using var = var_with<cs::slab_allocator>;
+		for (size_t r = 0; r < R; ++r)
+		{
+			std::vector<var> vars;
+			vars.reserve(N / 10);
+			for (size_t i = 0; i < N / 10; ++i)
+				vars.emplace_back(var::make<payload>());
+			std::thread([&]() { vars.clear(); }).join();
+		}
+	});
+
+	return 0;
+}
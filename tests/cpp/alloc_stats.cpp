@@ -0,0 +1,88 @@
+#include <covscript/types/types.hpp>
+#include <catch2/catch_all.hpp>
+#include <thread>
+
+using namespace cs;
+
+#ifdef COVSCRIPT_ALLOC_STATS
+// Too large for the small buffer of variables
+struct stats_payload
+{
+	integer_t data[12];
+};
+
+TEST_CASE("alloc_stats counts variable payloads", "[alloc_stats]")
+{
+	alloc_stats::reset();
+	REQUIRE(alloc_stats::stats_of<stats_payload>().allocations == 0);
+	{
+		std::vector<var> vars;
+		for (int i = 0; i < 1000; ++i)
+			vars.emplace_back(var::make<stats_payload>());
+		auto stats = alloc_stats::stats_of<stats_payload>();
+		REQUIRE(stats.allocations == 1000);
+		REQUIRE(stats.frees == 0);
+		REQUIRE(stats.live_objects == 1000);
+		REQUIRE(stats.live_bytes == 1000 * sizeof(stats_payload));
+		REQUIRE(stats.object_size == sizeof(stats_payload));
+		REQUIRE(stats.pool_hits + stats.pool_misses == 1000);
+		// Most blocks come from slabs already carved
+		REQUIRE(stats.hit_rate() > 0.5);
+	}
+	auto stats = alloc_stats::stats_of<stats_payload>();
+	REQUIRE(stats.frees == 1000);
+	REQUIRE(stats.live_objects == 0);
+	REQUIRE(stats.live_bytes == 0);
+
+	// Frees on other threads are counted as well
+	std::vector<var> vars(100, var::make<stats_payload>());
+	std::thread([&]() { vars.clear(); }).join();
+	REQUIRE(alloc_stats::stats_of<stats_payload>().live_objects == 0);
+	REQUIRE(alloc_stats::stats_of<stats_payload>().frees == 1101);
+
+	alloc_stats::reset();
+	stats = alloc_stats::stats_of<stats_payload>();
+	REQUIRE((stats.allocations == 0 && stats.frees == 0 && stats.pool_hits == 0 && stats.pool_misses == 0));
+}
+
+TEST_CASE("alloc_stats of allocator_type", "[alloc_stats]")
+{
+	struct pooled
+	{
+		integer_t data[4];
+	};
+	allocator_type<pooled, 4> alloc;
+	std::vector<pooled *> blocks;
+	// Two preallocated blocks are hits, the rest are misses
+	for (int i = 0; i < 5; ++i)
+		blocks.push_back(alloc.allocate(1));
+	auto stats = alloc_stats::stats_of<pooled>();
+	REQUIRE(stats.pool_hits == 2);
+	REQUIRE(stats.pool_misses == 3);
+	REQUIRE(stats.live_objects == 5);
+	for (auto ptr : blocks)
+		alloc.deallocate(ptr, 1);
+	REQUIRE(alloc_stats::stats_of<pooled>().live_objects == 0);
+}
+
+TEST_CASE("alloc_stats as JSON", "[alloc_stats]")
+{
+	var keep = var::make<stats_payload>();
+	auto all = alloc_stats::snapshot();
+	REQUIRE(!all.empty());
+	for (std::size_t i = 1; i < all.size(); ++i)
+		REQUIRE(all[i - 1].live_bytes >= all[i].live_bytes);
+	std::string json = alloc_stats::to_json();
+	REQUIRE(json.rfind("{\"types\": [{", 0) == 0);
+	REQUIRE(json.substr(json.size() - 2) == "]}");
+	REQUIRE(json.find("stats_payload\"") != std::string::npos);
+	REQUIRE(json.find("\"live_bytes\": ") != std::string::npos);
+	REQUIRE(json.find("\"hit_rate\": ") != std::string::npos);
+}
+#else
+TEST_CASE("alloc_stats compiled out", "[alloc_stats]")
+{
+	// Allocators carry no counters without COVSCRIPT_ALLOC_STATS
+	REQUIRE(std::is_empty_v<slab_allocator<var>>);
+}
+#endif
@@ -0,0 +1,69 @@
+#include <covscript/types/bigint.hpp>
+#include <covscript/types/exception.hpp>
+#include <catch2/catch_all.hpp>
+#include <limits>
+
+using namespace cs;
+
+TEST_CASE("bigint conversions", "[bigint]")
+{
+	const integer_t max = std::numeric_limits<integer_t>::max(), min = std::numeric_limits<integer_t>::min();
+	REQUIRE(bigint().is_zero());
+	REQUIRE(bigint(0).to_string() == "0");
+	REQUIRE(bigint(-42).to_string() == "-42");
+	REQUIRE(bigint(max).to_string() == "9223372036854775807");
+	REQUIRE(bigint(min).to_string() == "-9223372036854775808");
+	REQUIRE(bigint(min).fits_integer());
+	REQUIRE(bigint(min).to_integer() == min);
+	REQUIRE_FALSE((bigint(max) + bigint(1)).fits_integer());
+	REQUIRE((bigint(max) + bigint(1)).to_integer() == max);
+	REQUIRE((bigint(min) - bigint(1)).to_integer() == min);
+
+	bigint big = bigint::parse("-123456789012345678901234567890");
+	REQUIRE(big.is_negative());
+	REQUIRE(big.to_string() == "-123456789012345678901234567890");
+	REQUIRE(bigint::parse("+0001000000000").to_string() == "1000000000");
+	REQUIRE(bigint::parse("-0").to_string() == "0");
+	REQUIRE(big.to_float<double>() == Catch::Approx(-1.2345678901234568e29));
+	REQUIRE_THROWS_AS(bigint::parse(""), lang_error);
+	REQUIRE_THROWS_AS(bigint::parse("12a"), lang_error);
+}
+
+TEST_CASE("bigint arithmetic", "[bigint]")
+{
+	bigint a = bigint::parse("340282366920938463463374607431768211457"), b = bigint::parse("18446744073709551617");
+	REQUIRE((a + b).to_string() == "340282366920938463481821351505477763074");
+	REQUIRE((b - a).to_string() == "-340282366920938463444927863358058659840");
+	REQUIRE((a - a).is_zero());
+	REQUIRE_FALSE((a - a).is_negative());
+	REQUIRE((a * b).to_string() == "6277101735386680764176071790128604879584176795969512275969");
+	REQUIRE((-a * b) == -(a * b));
+	REQUIRE(b < a);
+	REQUIRE(-a < -b);
+	REQUIRE(bigint(-1) < bigint(0));
+
+	bigint quot, rem;
+	bigint::divmod(a * b + bigint(12345), b, quot, rem);
+	REQUIRE(quot == a);
+	REQUIRE(rem == bigint(12345));
+	bigint::divmod(-a, bigint(10), quot, rem);
+	REQUIRE(quot.to_string() == "-34028236692093846346337460743176821145");
+	REQUIRE(rem == bigint(-7));
+	bigint::divmod(b, a, quot, rem);
+	REQUIRE(quot.is_zero());
+	REQUIRE(rem == b);
+	REQUIRE_THROWS_AS(bigint::divmod(a, bigint(), quot, rem), lang_error);
+
+	// Factorial round trip exercises multi-limb divisors
+	bigint fact(1);
+	for (integer_t i = 2; i <= 60; ++i)
+		fact = fact * bigint(i);
+	REQUIRE(fact.to_string() == "8320987112741390144276341183223364380754172606361245952449277696409600000000000000");
+	for (integer_t i = 60; i >= 2; i -= 2)
+	{
+		bigint::divmod(fact, bigint(i) * bigint(i - 1), quot, rem);
+		REQUIRE(rem.is_zero());
+		fact = quot;
+	}
+	REQUIRE(fact == bigint(1));
+}
@@ -0,0 +1,85 @@
+#include <covscript/types/types.hpp>
+#include <catch2/catch_all.hpp>
+#include <limits>
+
+using namespace cs;
+
+TEST_CASE("compact_var: size and null", "[compact_var]")
+{
+	STATIC_REQUIRE(sizeof(compact_var) == 8);
+	compact_var v;
+	REQUIRE(v.is_null());
+	REQUIRE(!v.is_boxed());
+	REQUIRE(v.tag() == var_tag::null);
+	REQUIRE(v.to_var().is_null());
+	REQUIRE_THROWS_AS(v.as_numeric(), runtime_error);
+}
+
+TEST_CASE("compact_var: immediate numeric values", "[compact_var]")
+{
+	compact_var i = numeric_t(-42LL), f = numeric_t(2.5L), big = numeric_t(integer_t(1) << 50), precise = numeric_t(0.1L);
+	REQUIRE(!i.is_boxed());
+	REQUIRE(i.tag() == var_tag::numeric);
+	REQUIRE(i.as_numeric().is_integer());
+	REQUIRE(i.as_numeric() == -42);
+	REQUIRE(!f.is_boxed());
+	REQUIRE(f.as_numeric().is_float());
+	REQUIRE(f.as_numeric() == 2.5L);
+	// Values that do not fit are boxed without losing precision
+	REQUIRE(big.is_boxed());
+	REQUIRE(big.as_numeric().as_integer() == integer_t(1) << 50);
+	REQUIRE(precise.as_numeric() == numeric_t(0.1L));
+	REQUIRE(compact_var(numeric_t(3LL)) == compact_var(numeric_t(3.0L)));
+
+	compact_var huge = numeric_t(std::numeric_limits<integer_t>::max()) + numeric_t(1LL);
+	REQUIRE(huge.is_boxed());
+	REQUIRE(huge.as_numeric().is_big());
+}
+
+TEST_CASE("compact_var: booleans and NaN", "[compact_var]")
+{
+	compact_var t = true, f = false;
+	REQUIRE(t.tag() == var_tag::boolean);
+	REQUIRE(t.as_bool());
+	REQUIRE(!f.as_bool());
+	REQUIRE(t != f);
+	REQUIRE_THROWS_AS(t.as_numeric(), runtime_error);
+
+	compact_var nan = numeric_t(-std::numeric_limits<cs::float_t>::quiet_NaN());
+	REQUIRE(nan.tag() == var_tag::numeric);
+	REQUIRE(nan != nan);
+}
+
+TEST_CASE("compact_var: boxed values and var interoperation", "[compact_var]")
+{
+	compact_var s = var::make<byte_string_t>("boxed");
+	REQUIRE(s.is_boxed());
+	REQUIRE(s.tag() == var_tag::string);
+	REQUIRE(s.boxed()->const_val<byte_string_t>() == "boxed");
+
+	compact_var copy = s;
+	REQUIRE(copy == s);
+	REQUIRE(copy.boxed() != s.boxed());
+	compact_var moved = std::move(copy);
+	REQUIRE(copy.is_null());
+	REQUIRE(moved.to_var() == var::make<byte_string_t>("boxed"));
+
+	var n = compact_var(numeric_t(7LL)).to_var();
+	REQUIRE(n.is_type_of<numeric_t>());
+	REQUIRE(n.const_val<numeric_t>() == 7);
+	REQUIRE(compact_var(n).as_numeric() == 7);
+}
+
+TEST_CASE("compact_var: container element", "[compact_var]")
+{
+	compact_array arr;
+	for (integer_t i = 0; i < 1000; ++i)
+		arr.emplace_back(numeric_t(i));
+	arr.emplace_back(var::make<byte_string_t>("tail"));
+	numeric_t sum;
+	for (auto &it : arr)
+		if (it.tag() == var_tag::numeric)
+			sum = sum + it.as_numeric();
+	REQUIRE(sum == 499500);
+	REQUIRE(arr.back().tag() == var_tag::string);
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <covscript/types/numeric.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 2'000'000;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+int main()
+{
+	std::cout << "=== Performance of numeric formatting and parsing ===\n";
+
+	std::vector<cs::numeric_t> ints, floats;
+	for (size_t i = 0; i < N; ++i)
+	{
+		ints.emplace_back(cs::integer_t(i * 7919));
+		floats.emplace_back(cs::float_t(i) / 7 + 0.1L);
+	}
+
+	TIME_BLOCK("std::to_string integer", {
+		size_t len = 0;
+		for (auto &num : ints)
+			len += std::to_string(num.as_integer()).size();
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("numeric_t::to_chars integer", {
+		size_t len = 0;
+		char buff[cs::numeric_t::max_chars];
+		for (auto &num : ints)
+			len += num.to_chars(buff, buff + sizeof(buff)).ptr - buff;
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("std::to_string float", {
+		size_t len = 0;
+		for (auto &num : floats)
+			len += std::to_string(num.as_float()).size();
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("numeric_t::to_chars float", {
+		size_t len = 0;
+		char buff[cs::numeric_t::max_chars];
+		for (auto &num : floats)
+			len += num.to_chars(buff, buff + sizeof(buff)).ptr - buff;
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("numeric_t::to_string float", {
+		size_t len = 0;
+		for (auto &num : floats)
+			len += num.to_string().size();
+		volatile size_t dummy = len;
+	});
+
+	std::vector<std::string> int_texts, float_texts;
+	for (size_t i = 0; i < N; ++i)
+	{
+		int_texts.push_back(ints[i].to_string());
+		float_texts.push_back(floats[i].to_string());
+	}
+
+	TIME_BLOCK("std::stoll integer", {
+		cs::integer_t sum = 0;
+		for (auto &text : int_texts)
+			sum += std::stoll(text);
+		volatile cs::integer_t dummy = sum;
+	});
+
+	TIME_BLOCK("numeric_t::from_chars integer", {
+		cs::integer_t sum = 0;
+		cs::numeric_t num;
+		for (auto &text : int_texts)
+		{
+			cs::numeric_t::from_chars(text.data(), text.data() + text.size(), num);
+			sum += num.as_integer();
+		}
+		volatile cs::integer_t dummy = sum;
+	});
+
+	TIME_BLOCK("std::stold float", {
+		cs::float_t sum = 0;
+		for (auto &text : float_texts)
+			sum += std::stold(text);
+		volatile cs::float_t dummy = sum;
+	});
+
+	TIME_BLOCK("numeric_t::from_chars float", {
+		cs::float_t sum = 0;
+		cs::numeric_t num;
+		for (auto &text : float_texts)
+		{
+			cs::numeric_t::from_chars(text.data(), text.data() + text.size(), num);
+			sum += num.as_float();
+		}
+		volatile cs::float_t dummy = sum;
+	});
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <list>
+#include <covscript/context/memory.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 2'000'000;
+// One object of K stays reachable
+constexpr size_t K = 4;
+constexpr size_t R = 3;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+// Heap of the previous memory_manager, a list with a reachable count in every node
+struct list_object
+{
+	mutable size_t reachable_count = 0;
+	cs::var data;
+
+	explicit list_object(cs::var val) : data(std::move(val)) {}
+};
+
+struct paged_object
+{
+	cs::var data;
+
+	explicit paged_object(cs::var val) : data(std::move(val)) {}
+};
+
+size_t list_heap()
+{
+	size_t freed = 0;
+	std::list<list_object> heap;
+	std::vector<const list_object *> roots;
+	for (size_t r = 0; r < R; ++r)
+	{
+		roots.clear();
+		for (size_t i = 0; i < N; ++i)
+		{
+			heap.emplace_front(cs::var(cs::numeric_t(i)));
+			if (i % K == 0)
+				roots.push_back(&heap.front());
+		}
+		for (auto &obj : heap)
+			obj.reachable_count = 0;
+		for (auto ptr : roots)
+			++ptr->reachable_count;
+		for (auto it = heap.begin(); it != heap.end();)
+		{
+			if (it->reachable_count == 0)
+			{
+				it = heap.erase(it);
+				++freed;
+			}
+			else
+				++it;
+		}
+	}
+	return freed;
+}
+
+size_t paged_heap()
+{
+	size_t freed = 0;
+	cs::gc_heap<paged_object> heap;
+	std::vector<const paged_object *> roots;
+	for (size_t r = 0; r < R; ++r)
+	{
+		roots.clear();
+		for (size_t i = 0; i < N; ++i)
+		{
+			paged_object *ptr = heap.allocate(cs::var(cs::numeric_t(i)));
+			if (i % K == 0)
+				roots.push_back(ptr);
+		}
+		freed += heap.collect([&]() {
+			for (auto ptr : roots)
+				cs::gc_heap<paged_object>::mark(ptr);
+		}, [](const paged_object &) {});
+	}
+	return freed;
+}
+
+int main()
+{
+	std::cout << "=== Performance of garbage collection ===\n";
+	std::cout << R << " rounds of " << N << " objects, 1/" << K << " reachable\n";
+
+	TIME_BLOCK("allocate and collect std::list heap", {
+		volatile size_t dummy = list_heap();
+	});
+	TIME_BLOCK("allocate and collect gc_heap", {
+		volatile size_t dummy = paged_heap();
+	});
+
+	// Mark and sweep alone, swept at once
+	{
+		std::list<list_object> heap;
+		std::vector<const list_object *> roots;
+		for (size_t i = 0; i < N; ++i)
+		{
+			heap.emplace_front(cs::var(cs::numeric_t(i)));
+			if (i % K == 0)
+				roots.push_back(&heap.front());
+		}
+		TIME_BLOCK("full collection std::list heap", {
+			for (auto &obj : heap)
+				obj.reachable_count = 0;
+			for (auto ptr : roots)
+				++ptr->reachable_count;
+			for (auto it = heap.begin(); it != heap.end();)
+			{
+				if (it->reachable_count == 0)
+					it = heap.erase(it);
+				else
+					++it;
+			}
+		});
+	}
+	{
+		cs::gc_heap<paged_object> heap;
+		std::vector<const paged_object *> roots;
+		for (size_t i = 0; i < N; ++i)
+		{
+			paged_object *ptr = heap.allocate(cs::var(cs::numeric_t(i)));
+			if (i % K == 0)
+				roots.push_back(ptr);
+		}
+		TIME_BLOCK("full collection gc_heap mark", {
+			heap.collect([&]() {
+				for (auto ptr : roots)
+					cs::gc_heap<paged_object>::mark(ptr);
+			}, [](const paged_object &) {});
+		});
+		TIME_BLOCK("full collection gc_heap sweep", {
+			heap.sweep_all();
+		});
+	}
+
+	// Through memory_manager, chains of K objects referred from an array on the stack, half of them
+	TIME_BLOCK("memory_manager gcnew and gc", {
+		using heap_pointer = cs::memory_manager::heap_pointer;
+		cs::memory_manager manager;
+		manager.declare_var("roots", cs::var::make<cs::array>());
+		cs::memory_manager::stack_visitor visitor("roots");
+		for (size_t r = 0; r < R; ++r)
+		{
+			cs::array &roots = manager.access(visitor).val<cs::array>();
+			roots.clear();
+			heap_pointer *prev = nullptr;
+			for (size_t i = 0; i < N; ++i)
+			{
+				heap_pointer *ptr = manager.gcnew<heap_pointer *>(prev);
+				prev = i % K == K - 1 ? nullptr : ptr;
+				if (i % K == K - 1 && i / K % 2 == 0)
+					roots.push_back(cs::var::make<heap_pointer *>(ptr));
+			}
+			volatile size_t dummy = manager.gc(true);
+		}
+	});
+
+	return 0;
+}
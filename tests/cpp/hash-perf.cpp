@@ -0,0 +1,100 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <covscript/types/types.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 10'000'000;
+constexpr size_t KEYS = 1000;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+static std::vector<cs::string> make_keys(std::size_t length)
+{
+	std::vector<cs::string> keys;
+	for (size_t i = 0; i < KEYS; ++i)
+	{
+		cs::string key = std::to_string(i);
+		key.resize(length, '_');
+		keys.push_back(std::move(key));
+	}
+	return keys;
+}
+
+static void bench(std::size_t length)
+{
+	std::cout << "--- key length " << length << " ---\n";
+	std::vector<cs::string> keys = make_keys(length);
+
+	TIME_BLOCK("std::hash<string_view>", {
+		size_t sum = 0;
+		for (size_t i = 0; i < N; ++i)
+			sum += std::hash<cs::string_view>{}(keys[i % KEYS]);
+		volatile size_t dummy = sum;
+	});
+
+	TIME_BLOCK("cs_impl::hash_bytes", {
+		size_t sum = 0;
+		for (size_t i = 0; i < N; ++i)
+			sum += cs_impl::hash_bytes(keys[i % KEYS].data(), length);
+		volatile size_t dummy = sum;
+	});
+
+	cs::hash_map map;
+	std::vector<cs::var> var_keys;
+	for (auto &key : keys)
+	{
+		map.emplace(key, cs::numeric_t(1LL));
+		var_keys.emplace_back(key);
+	}
+
+	TIME_BLOCK("cs::hash_map lookup, same key variables", {
+		size_t count = 0;
+		for (size_t i = 0; i < N; ++i)
+			count += map.count(var_keys[i % KEYS]);
+		volatile size_t dummy = count;
+	});
+
+	TIME_BLOCK("cs::hash_map lookup, mutated key variables", {
+		size_t count = 0;
+		for (size_t i = 0; i < N; ++i)
+		{
+			cs::var &key = var_keys[i % KEYS];
+			// Write access drops the cached hash
+			key.val<cs::string>()[0] = key.const_val<cs::string>()[0];
+			count += map.count(key);
+		}
+		volatile size_t dummy = count;
+	});
+
+	TIME_BLOCK("cs::hash_map lookup, temporary key variables", {
+		size_t count = 0;
+		for (size_t i = 0; i < N; ++i)
+			count += map.count(cs::var(keys[i % KEYS]));
+		volatile size_t dummy = count;
+	});
+
+	TIME_BLOCK("cs::hash_map lookup, string_view keys", {
+		size_t count = 0;
+		for (size_t i = 0; i < N; ++i)
+			count += cs::hash_count(map, cs::string_view(keys[i % KEYS]));
+		volatile size_t dummy = count;
+	});
+}
+
+int main()
+{
+	std::cout << "=== Performance of string hashing ===\n";
+	bench(8);
+	bench(32);
+	bench(256);
+	return 0;
+}
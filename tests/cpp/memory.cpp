@@ -0,0 +1,341 @@
+#include <covscript/context/memory.hpp>
+#include <catch2/catch_all.hpp>
+#include <thread>
+
+using namespace cs;
+
+// Too large for the small buffer of variables
+struct arena_payload
+{
+	integer_t data[12];
+
+	explicit arena_payload(integer_t val = 0)
+	{
+		std::fill(std::begin(data), std::end(data), val);
+	}
+
+	bool holds(integer_t val) const
+	{
+		return std::all_of(std::begin(data), std::end(data), [val](integer_t it) { return it == val; });
+	}
+};
+
+TEST_CASE("domain_arena releases frames at once", "[memory]")
+{
+	domain_arena arena;
+	REQUIRE(arena.empty());
+	for (int round = 0; round < 3; ++round)
+	{
+		arena.enter();
+		{
+			std::vector<var> temps;
+			for (int i = 0; i < 5000; ++i)
+				temps.emplace_back(var::make<arena_payload>(i));
+			REQUIRE(arena.used() > 5000 * sizeof(arena_payload));
+			for (int i = 0; i < 5000; ++i)
+				REQUIRE(temps[i].const_val<arena_payload>().holds(i));
+		}
+		arena.leave();
+		REQUIRE(arena.empty());
+		REQUIRE(arena.used() == 0);
+	}
+	// Nothing is taken from the arena once left
+	var after = var::make<arena_payload>(1);
+	REQUIRE(arena.used() == 0);
+}
+
+TEST_CASE("domain_arena keeps values that escaped", "[memory]")
+{
+	domain_arena arena;
+	var kept;
+	arena.enter();
+	kept = var::make<arena_payload>(42);
+	arena.leave();
+	REQUIRE(arena.used() == 0);
+
+	// Later frames never reuse the memory of a survivor
+	for (int round = 0; round < 10; ++round)
+	{
+		arena.enter();
+		std::vector<var> temps(1000, var::make<arena_payload>(round));
+		temps.clear();
+		arena.leave();
+	}
+	REQUIRE(kept.const_val<arena_payload>().holds(42));
+
+	// Escaped from an inner frame into the outer one, released before the outer frame is left
+	arena.enter();
+	{
+		var outer;
+		arena.enter();
+		outer = var::make<arena_payload>(7);
+		var inner = var::make<arena_payload>(8);
+		arena.leave();
+		REQUIRE(outer.const_val<arena_payload>().holds(7));
+	}
+	arena.leave();
+	REQUIRE(arena.used() == 0);
+
+	// Survivors of nested frames freed on another thread after the arena is gone
+	std::vector<var> survivors;
+	{
+		domain_arena local;
+		local.enter();
+		for (int i = 0; i < 3; ++i)
+		{
+			local.enter();
+			survivors.push_back(var::make<arena_payload>(i));
+			local.enter();
+			survivors.push_back(var::make<arena_payload>(i + 100));
+			local.leave();
+			local.leave();
+		}
+		local.leave();
+	}
+	bool intact = true;
+	std::thread([&]() {
+		for (int i = 0; i < 3; ++i)
+			intact = intact && survivors[2 * i].const_val<arena_payload>().holds(i) && survivors[2 * i + 1].const_val<arena_payload>().holds(i + 100);
+		survivors.clear();
+	}).join();
+	REQUIRE(intact);
+	kept = var();
+}
+
+TEST_CASE("domain_arena stays bounded", "[memory]")
+{
+	constexpr std::size_t bound = 2 * 1024 * 1024;
+	domain_arena arena;
+	arena.enter();
+	// Short lived values of one long frame, nothing freed is reused before the frame is left
+	bool intact = true;
+	for (integer_t i = 0; i < 200000; ++i)
+	{
+		var temp = var::make<arena_payload>(i);
+		intact = intact && temp.const_val<arena_payload>().holds(i);
+	}
+	REQUIRE(intact);
+	REQUIRE(arena.used() <= bound);
+
+	// Every child leaves a survivor behind
+	std::vector<var> kept;
+	for (integer_t i = 0; i < 20000; ++i)
+	{
+		arena.enter();
+		std::vector<var> temps;
+		for (integer_t j = 0; j < 20; ++j)
+			temps.push_back(var::make<arena_payload>(j));
+		kept.push_back(var::make<arena_payload>(i));
+		arena.leave();
+		if (kept.size() > 100)
+			kept.erase(kept.begin());
+	}
+	REQUIRE(arena.used() <= bound);
+	for (std::size_t i = 0; i < kept.size(); ++i)
+		intact = intact && kept[i].const_val<arena_payload>().holds(integer_t(20000 - kept.size() + i));
+	REQUIRE(intact);
+	kept.clear();
+	arena.leave();
+	REQUIRE(arena.used() == 0);
+}
+
+TEST_CASE("memory_manager domains on the arena", "[memory]")
+{
+	memory_manager manager;
+	manager.declare_var("outer", var());
+	memory_manager::stack_visitor outer("outer"), temp("temp");
+	for (integer_t i = 0; i < 200; ++i)
+	{
+		manager.enter_domain();
+		manager.declare_var("temp", var::make<arena_payload>(i));
+		manager.enter_domain();
+		manager.declare_var("nested", var::make<arena_payload>(-i));
+		manager.leave_domain();
+		if (i == 100)
+			manager.access(outer) = manager.access(temp);
+		manager.leave_domain();
+	}
+	REQUIRE(manager.access(outer).const_val<arena_payload>().holds(100));
+	REQUIRE(manager.access_opt(temp) == nullptr);
+
+	// References to values survive deep growth of the stack
+	var &ref = manager.access(outer);
+	for (integer_t i = 0; i < 1000; ++i)
+	{
+		manager.enter_domain();
+		manager.declare_var("level", var(numeric_t(i)));
+	}
+	REQUIRE(&ref == &manager.access(outer));
+	REQUIRE(ref.const_val<arena_payload>().holds(100));
+	for (integer_t i = 0; i < 1000; ++i)
+		manager.leave_domain();
+}
+
+TEST_CASE("memory_manager domains interleaved on one thread", "[memory]")
+{
+	// Managers of two fibers running on the same thread
+	memory_manager a, b;
+	memory_manager::stack_visitor va("a"), vb("b");
+	a.enter_domain();
+	b.enter_domain();
+	a.declare_var("a", var::make<arena_payload>(1));
+	b.declare_var("b", var::make<arena_payload>(2));
+	a.leave_domain();
+	// The arena of b is still entered and serves the thread
+	var in_b = var::make<arena_payload>(3);
+	REQUIRE(b.access(vb).const_val<arena_payload>().holds(2));
+	b.leave_domain();
+	var after = var::make<arena_payload>(4);
+	REQUIRE(in_b.const_val<arena_payload>().holds(3));
+	REQUIRE(after.const_val<arena_payload>().holds(4));
+
+	for (integer_t i = 0; i < 100; ++i)
+	{
+		a.enter_domain();
+		a.declare_var("a", var::make<arena_payload>(i));
+		b.enter_domain();
+		b.declare_var("b", var::make<arena_payload>(-i));
+		if (i % 2 == 0)
+		{
+			a.leave_domain();
+			REQUIRE(b.access(vb).const_val<arena_payload>().holds(-i));
+			b.leave_domain();
+		}
+		else
+		{
+			b.leave_domain();
+			REQUIRE(a.access(va).const_val<arena_payload>().holds(i));
+			a.leave_domain();
+		}
+		var temp = var::make<arena_payload>(i);
+		REQUIRE(temp.const_val<arena_payload>().holds(i));
+	}
+
+	// A manager destroyed while the other one is still in a domain
+	{
+		memory_manager c;
+		c.enter_domain();
+		b.enter_domain();
+		c.leave_domain();
+	}
+	var in_b_again = var::make<arena_payload>(5);
+	b.leave_domain();
+	var last = var::make<arena_payload>(6);
+	REQUIRE(in_b_again.const_val<arena_payload>().holds(5));
+	REQUIRE(last.const_val<arena_payload>().holds(6));
+}
+
+struct gc_node
+{
+	gc_node *ref = nullptr;
+	std::size_t *destroyed = nullptr;
+	std::size_t id = 0;
+
+	gc_node(std::size_t *counter, std::size_t val) : destroyed(counter), id(val) {}
+
+	~gc_node()
+	{
+		++*destroyed;
+	}
+};
+
+TEST_CASE("gc_heap marks from roots and sweeps by page", "[memory]")
+{
+	std::size_t destroyed = 0;
+	{
+		gc_heap<gc_node> heap;
+		const std::size_t count = gc_heap<gc_node>::objects_per_page() * 5 + 7;
+		std::vector<gc_node *> nodes;
+		for (std::size_t i = 0; i < count; ++i)
+			nodes.push_back(heap.allocate(&destroyed, i));
+		REQUIRE(heap.size() == count);
+		REQUIRE(heap.page_count() == 6);
+
+		// A chain from one root through every third node, ended by a cycle
+		for (std::size_t i = 0; i + 3 < count; i += 3)
+			nodes[i]->ref = nodes[i + 3];
+		std::size_t reachable = (count + 2) / 3;
+		nodes[(reachable - 1) * 3]->ref = nodes[0];
+		auto trace = [](const gc_node &node) {
+			if (node.ref != nullptr)
+				gc_heap<gc_node>::mark(node.ref);
+		};
+		std::size_t garbage = heap.collect([&]() { gc_heap<gc_node>::mark(nodes[0]); }, trace);
+		REQUIRE(garbage == count - reachable);
+		REQUIRE(heap.size() == reachable);
+		// Sweeping is deferred to allocation
+		REQUIRE(destroyed == 0);
+
+		// Reuses the slots of one swept page without growing
+		std::size_t per_page = gc_heap<gc_node>::objects_per_page();
+		for (std::size_t i = 0; i < per_page / 2; ++i)
+			heap.allocate(&destroyed, 0);
+		REQUIRE(destroyed > 0);
+		REQUIRE(destroyed < count - reachable);
+		REQUIRE(heap.page_count() == 6);
+
+		heap.sweep_all();
+		REQUIRE(destroyed == count - reachable);
+		for (std::size_t i = 0; i < count; i += 3)
+			REQUIRE(nodes[i]->id == i);
+
+		// Nothing reachable, every page is returned by the next collection
+		REQUIRE(heap.collect([]() {}, trace) == reachable + per_page / 2);
+		heap.collect([]() {}, trace);
+		REQUIRE(heap.size() == 0);
+		REQUIRE(heap.page_count() == 0);
+		REQUIRE(destroyed == count + per_page / 2);
+
+		heap.allocate(&destroyed, 1);
+	}
+	// Live objects are destroyed with the heap
+	REQUIRE(destroyed == gc_heap<gc_node>::objects_per_page() * 5 + 7 + gc_heap<gc_node>::objects_per_page() / 2 + 1);
+}
+
+TEST_CASE("memory_manager collects unreachable heap objects", "[memory]")
+{
+	using heap_pointer = memory_manager::heap_pointer;
+	memory_manager manager("<Global>", COVSCRIPT_STACK_PRESERVE, 0);
+	manager.declare_var("root", var());
+	memory_manager::stack_visitor root("root");
+
+	// A long list kept alive through the root, traced without recursion
+	heap_pointer *head = nullptr;
+	for (integer_t i = 0; i < 100000; ++i)
+	{
+		heap_pointer *node = manager.gcnew<array>();
+		array &arr = node->data.val<array>();
+		arr.push_back(var(numeric_t(i)));
+		arr.push_back(var::make<heap_pointer *>(head));
+		head = node;
+	}
+	manager.access(root) = var::make<heap_pointer *>(head);
+	// Garbage, including a cycle
+	heap_pointer *first = manager.gcnew<array>();
+	heap_pointer *second = manager.gcnew<array>();
+	first->data.val<array>().push_back(var::make<heap_pointer *>(second));
+	second->data.val<array>().push_back(var::make<heap_pointer *>(first));
+	for (integer_t i = 0; i < 1000; ++i)
+		manager.gcnew<numeric_t>(i);
+	REQUIRE(manager.heap_size() == 101002);
+
+	REQUIRE(manager.gc() == 1002);
+	REQUIRE(manager.heap_size() == 100000);
+	// Nothing allocated since, nothing to do
+	REQUIRE(manager.gc(true) == 0);
+
+	integer_t expected = 99999;
+	for (heap_pointer *it = head; it != nullptr; --expected)
+	{
+		const array &arr = it->data.const_val<array>();
+		REQUIRE(arr.front().const_val<numeric_t>() == expected);
+		it = arr.back().const_val<heap_pointer *>();
+	}
+	REQUIRE(expected == -1);
+
+	// Dropping the root releases the whole list
+	manager.access(root) = var();
+	manager.gcnew();
+	REQUIRE(manager.gc(true) == 100001);
+	REQUIRE(manager.heap_size() == 0);
+}
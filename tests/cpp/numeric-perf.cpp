@@ -0,0 +1,217 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <covscript/types/types.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 1'000'000;
+constexpr size_t R = 50;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+template <typename numeric_type>
+static void bench(const char *policy)
+{
+	using value_type = typename numeric_type::value_type;
+	std::cout << "--- " << policy << " ---\n";
+	std::cout << "sizeof(numeric): " << sizeof(numeric_type) << " bytes\n";
+	std::cout << "memory of " << N << " numerics: " << sizeof(numeric_type) * N / 1024 << " KiB\n";
+
+	std::vector<numeric_type> floats, ints;
+	floats.reserve(N);
+	ints.reserve(N);
+	for (size_t i = 0; i < N; ++i)
+	{
+		floats.emplace_back(value_type(i) + value_type(0.5));
+		ints.emplace_back(cs::integer_t(i));
+	}
+
+	TIME_BLOCK("float add", {
+		numeric_type sum(value_type(0));
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : floats)
+				sum = sum + v;
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("float multiply-add", {
+		numeric_type sum(value_type(0));
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : floats)
+				sum = sum + v * v;
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("float divide", {
+		numeric_type sum(value_type(0));
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : floats)
+				sum = sum + v / value_type(3);
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("mixed add", {
+		numeric_type sum(value_type(0));
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : ints)
+				sum = sum + v;
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	numeric_type factor(cs::integer_t(7));
+	TIME_BLOCK("integer multiply-add", {
+		numeric_type sum(cs::integer_t(0));
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : ints)
+				sum = sum + v * factor;
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("float compare", {
+		size_t count = 0;
+		numeric_type pivot(value_type(N / 2));
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : floats)
+				count += v < pivot;
+		volatile size_t dummy = count;
+	});
+}
+
+// Factorials overflow integer_t at 21!, then continue as bigint
+static void bench_bigint()
+{
+	std::cout << "--- bigint ---\n";
+	TIME_BLOCK("factorial of 1000", {
+		size_t digits = 0;
+		for (size_t r = 0; r < 10; ++r)
+		{
+			cs::numeric_t fact(cs::integer_t(1));
+			for (cs::integer_t i = 2; i <= 1000; ++i)
+				fact = fact * cs::numeric_t(i);
+			digits += fact.to_string().size();
+		}
+		volatile size_t dummy = digits;
+	});
+}
+
+// The divisor is only known at runtime, as in scripts
+static void bench_divisor()
+{
+	std::cout << "--- invariant divisor ---\n";
+	volatile cs::integer_t runtime_divisor = 1000000007;
+	cs::integer_t divisor = runtime_divisor;
+	std::vector<cs::integer_t> values(N);
+	for (size_t i = 0; i < N; ++i)
+		values[i] = cs::integer_t(i) * 2654435761LL;
+
+	TIME_BLOCK("integer_t modulo", {
+		cs::integer_t sum = 0;
+		for (size_t r = 0; r < R; ++r)
+			for (auto v : values)
+				sum += v % divisor;
+		volatile cs::integer_t dummy = sum;
+	});
+
+	cs::integer_divisor div(divisor);
+	TIME_BLOCK("integer_divisor modulo", {
+		cs::integer_t sum = 0;
+		for (size_t r = 0; r < R; ++r)
+			for (auto v : values)
+				sum += div.rem(v);
+		volatile cs::integer_t dummy = sum;
+	});
+
+	std::vector<cs::numeric_t> nums(values.begin(), values.end());
+	cs::numeric_t num_divisor(divisor);
+	TIME_BLOCK("numeric_t modulo", {
+		cs::numeric_t sum(cs::integer_t(0));
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : nums)
+				sum = sum + v % num_divisor;
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("numeric_t integer power", {
+		cs::integer_t sum = 0;
+		cs::numeric_t base(cs::integer_t(3));
+		for (size_t r = 0; r < R; ++r)
+			for (size_t i = 0; i < N; ++i)
+				sum += (base ^ cs::numeric_t(cs::integer_t(i % 40))).as_integer();
+		volatile cs::integer_t dummy = sum;
+	});
+}
+
+// Shortest text and parsing against the standard library
+static void bench_text()
+{
+	std::cout << "--- text ---\n";
+	std::vector<cs::long_double_numeric_t> thirds, quarters;
+	std::vector<std::string> shortest, long_double_text, large_text;
+	for (size_t i = 0; i < N; ++i)
+	{
+		thirds.emplace_back(static_cast<long double>(i) / 7);
+		quarters.emplace_back(static_cast<long double>(i) / 4);
+		shortest.push_back(cs::double_numeric_t(double(i) / 7).to_string());
+		long_double_text.push_back(thirds.back().to_string());
+		large_text.push_back(cs::double_numeric_t(double(i) / 7 * 1e100).to_string());
+	}
+
+	TIME_BLOCK("std::to_string(long double)", {
+		size_t len = 0;
+		for (size_t i = 0; i < N; ++i)
+			len += std::to_string(static_cast<long double>(i) / 7).size();
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("long double to_string", {
+		size_t len = 0;
+		for (auto &num : thirds)
+			len += num.to_string().size();
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("long double holding a double to_string", {
+		size_t len = 0;
+		for (auto &num : quarters)
+			len += num.to_string().size();
+		volatile size_t dummy = len;
+	});
+
+	const char *names[] = {"17 digits", "20 digits", "17 digits e+100"};
+	std::vector<std::string> *texts[] = {&shortest, &long_double_text, &large_text};
+	for (size_t k = 0; k < 3; ++k)
+	{
+		TIME_BLOCK(std::string("std::strtold ") + names[k], {
+			long double sum = 0;
+			for (auto &str : *texts[k])
+				sum += std::strtold(str.c_str(), nullptr);
+			volatile long double dummy = sum;
+		});
+
+		TIME_BLOCK(std::string("long double parse ") + names[k], {
+			long double sum = 0;
+			for (auto &str : *texts[k])
+				sum += cs::long_double_numeric_t::parse(str).as_float();
+			volatile long double dummy = sum;
+		});
+	}
+}
+
+int main()
+{
+	std::cout << "=== Performance of numeric precision policies ===\n";
+	bench<cs::double_numeric_t>("double");
+	bench<cs::long_double_numeric_t>("long double");
+	bench_bigint();
+	bench_divisor();
+	bench_text();
+	std::cout << "numeric_t uses " << (sizeof(cs::float_t) == sizeof(double) ? "double" : "long double") << "\n";
+	return 0;
+}
@@ -1,5 +1,11 @@
 #include <covscript/types/numeric.hpp>
+#include <covscript/types/exception.hpp>
 #include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <cstdio>
+#include <random>
+#include <cmath>
+#include <limits>
 
 using namespace cs;
 
@@ -130,3 +136,276 @@ TEST_CASE("numeric_t negation", "[numeric_t]")
 	REQUIRE((-i).as_integer() == -10);
 	REQUIRE((-f).as_float() == Catch::Approx(-2.5L));
 }
+
+TEMPLATE_TEST_CASE("basic_numeric precision policies", "[numeric_t]", double_numeric_t, long_double_numeric_t)
+{
+	using value_type = typename TestType::value_type;
+	TestType i(7LL), f(0.5), g(0.25L);
+	REQUIRE(f.is_float());
+	REQUIRE(g.is_float());
+	REQUIRE((i / TestType(2LL)).as_float() == value_type(3.5));
+	REQUIRE((i + f).as_float() == value_type(7.5));
+	REQUIRE((f * g).as_float() == value_type(0.125));
+	REQUIRE(f > g);
+	REQUIRE(TestType(2.0) == TestType(2LL));
+	REQUIRE(TestType(2.0).hash() == TestType(2LL).hash());
+	REQUIRE((-f).to_string() == "-0.5");
+	REQUIRE(TestType(12LL).to_string() == "12");
+
+	f = 1.5f;
+	REQUIRE(f.as_float() == value_type(1.5));
+	f = 3LL;
+	REQUIRE(f.is_integer());
+}
+
+TEST_CASE("numeric_t follows the build precision", "[numeric_t]")
+{
+	REQUIRE(std::is_same_v<numeric_t::value_type, cs::float_t>);
+	REQUIRE(sizeof(double_numeric_t) <= sizeof(long_double_numeric_t));
+	REQUIRE(std::is_nothrow_move_constructible_v<double_numeric_t>);
+	REQUIRE(std::is_nothrow_move_constructible_v<long_double_numeric_t>);
+}
+
+TEST_CASE("numeric_t promotes to bigint on overflow", "[numeric_t][bigint]")
+{
+	const integer_t max = std::numeric_limits<integer_t>::max(), min = std::numeric_limits<integer_t>::min();
+	numeric_t a(max), one(1LL);
+
+	numeric_t sum = a + one;
+	REQUIRE(sum.is_integer());
+	REQUIRE(sum.is_big());
+	REQUIRE(sum.to_string() == "9223372036854775808");
+	REQUIRE(sum > a);
+	REQUIRE(a < sum);
+	// Demoted once fits again
+	numeric_t back = sum - one;
+	REQUIRE_FALSE(back.is_big());
+	REQUIRE(back == a);
+
+	numeric_t product = a * a;
+	REQUIRE(product.to_string() == "85070591730234615847396907784232501249");
+	REQUIRE((product / a) == a);
+	REQUIRE_FALSE((product / a).is_big());
+	REQUIRE((product / numeric_t(2LL)).is_float());
+
+	numeric_t low(min);
+	REQUIRE((low - one).to_string() == "-9223372036854775809");
+	REQUIRE((-low).to_string() == "9223372036854775808");
+	REQUIRE((low / numeric_t(-1LL)).is_big());
+	REQUIRE((-(-low)) == low);
+	REQUIRE((low * numeric_t(-1LL)) == -low);
+
+	numeric_t counter(max);
+	++counter;
+	REQUIRE(counter.is_big());
+	--counter;
+	REQUIRE(counter == max);
+	REQUIRE_FALSE(counter.is_big());
+	REQUIRE((counter++).as_integer() == max);
+	REQUIRE(counter == sum);
+
+	// Mixed with floats, bigints behave like integers
+	REQUIRE((sum + numeric_t(0.5L)).is_float());
+	REQUIRE(sum == numeric_t(9223372036854775808.0L));
+	REQUIRE(sum.hash() == numeric_t(9223372036854775808.0L).hash());
+	REQUIRE(sum.as_integer() == max);
+	REQUIRE(sum < numeric_t(1e30L));
+	REQUIRE(low - one < numeric_t(0.0L));
+
+	// Copies share the payload
+	numeric_t copy = product;
+	copy = copy + one;
+	REQUIRE(copy != product);
+	REQUIRE(copy - product == 1);
+	numeric_t moved = std::move(copy);
+	REQUIRE(moved.is_big());
+	copy = moved;
+	REQUIRE(copy == moved);
+	copy = 3LL;
+	REQUIRE(copy == 3);
+}
+
+TEMPLATE_TEST_CASE("basic_numeric text round trip", "[numeric_t]", double_numeric_t, long_double_numeric_t)
+{
+	using value_type = typename TestType::value_type;
+	REQUIRE(TestType(0.1L).to_string() == "0.1");
+	REQUIRE(TestType(value_type(1) / 3).to_string().size() == std::numeric_limits<value_type>::max_digits10 + 1);
+	REQUIRE(TestType(1e300L).to_string() == "1e+300");
+	REQUIRE(TestType(-42LL).to_string() == "-42");
+
+	const value_type samples[] = {0.1L, -2.5L, 1.0L / 3, 6.02214076e23L, 5e-324L, std::numeric_limits<value_type>::max()};
+	for (value_type val : samples)
+	{
+		TestType num(val);
+		char buff[TestType::max_chars];
+		auto res = num.to_chars(buff, buff + sizeof(buff));
+		REQUIRE(res.ec == std::errc());
+		TestType back;
+		REQUIRE(TestType::from_chars(buff, res.ptr, back).ptr == res.ptr);
+		REQUIRE(back.as_float() == val);
+	}
+
+	char small[2];
+	REQUIRE(TestType(12345LL).to_chars(small, small + sizeof(small)).ec == std::errc::value_too_large);
+
+	TestType num = TestType::parse("12345");
+	REQUIRE(num.is_integer());
+	REQUIRE(num == 12345);
+	REQUIRE(TestType::parse("+7") == 7);
+	REQUIRE(TestType::parse("-7.5").as_float() == value_type(-7.5));
+	REQUIRE(TestType::parse("1e3").is_float());
+	REQUIRE(TestType::parse("1e3") == 1000);
+	REQUIRE(TestType::parse("2.").is_float());
+	num = TestType::parse("-123456789012345678901234567890");
+	REQUIRE(num.is_big());
+	REQUIRE(num.to_string() == "-123456789012345678901234567890");
+	REQUIRE(TestType::parse("inf").as_float() == std::numeric_limits<value_type>::infinity());
+
+	REQUIRE_THROWS_AS(TestType::parse(""), lang_error);
+	REQUIRE_THROWS_AS(TestType::parse("12abc"), lang_error);
+	REQUIRE_THROWS_AS(TestType::parse("abc"), lang_error);
+	REQUIRE_THROWS_AS(TestType::parse("+-1"), lang_error);
+
+	// Stops at the first character not belonging to the numeric
+	const char text[] = "3.25, rest";
+	auto res = TestType::from_chars(text, text + sizeof(text) - 1, num);
+	REQUIRE(res.ec == std::errc());
+	REQUIRE(*res.ptr == ',');
+	REQUIRE(num.as_float() == value_type(3.25));
+
+	// Short decimals take the exact fast path, it must agree with the correctly rounded parser
+	const char *decimals[] = {"0.1", "-0.3", "123.456", "1.5e-7", "9007199254740993.0", "4.35e22", "0.000001", "7e-22"};
+	for (const char *dec : decimals)
+	{
+		num = TestType::parse(dec);
+		REQUIRE(num.as_float() == (sizeof(value_type) == sizeof(double) ? std::strtod(dec, nullptr) : std::strtold(dec, nullptr)));
+	}
+	const char exp_text[] = "1e+";
+	res = TestType::from_chars(exp_text, exp_text + sizeof(exp_text) - 1, num);
+	REQUIRE(res.ptr == exp_text + 1);
+	REQUIRE(num == 1);
+}
+
+TEMPLATE_TEST_CASE("basic_numeric text of long mantissas", "[numeric_t]", double_numeric_t, long_double_numeric_t)
+{
+	using value_type = typename TestType::value_type;
+	auto correctly_rounded = [](const byte_string_t &str) -> value_type {
+		return sizeof(value_type) == sizeof(double) ? std::strtod(str.c_str(), nullptr) : std::strtold(str.c_str(), nullptr);
+	};
+	// Mantissas past 19 and 38 digits and exponents past the exact powers of ten
+	std::mt19937_64 rng(2024);
+	for (int i = 0; i < 20000; ++i)
+	{
+		byte_string_t digits;
+		for (int n = 1 + i % 45; n > 0; --n)
+			digits += static_cast<char>('0' + rng() % 10);
+		byte_string_t str = digits.substr(0, 1) + "." + digits.substr(1) + "e" + std::to_string(static_cast<int>(rng() % 600) - 300);
+		REQUIRE(TestType::parse(str).as_float() == correctly_rounded(str));
+	}
+	// Halfway between two long doubles and close to it
+	for (int i = 0; i < 2000; ++i)
+	{
+		value_type val = std::ldexp(static_cast<value_type>(rng() >> 11), static_cast<int>(rng() % 400) - 200);
+		value_type next = std::nextafter(val, std::numeric_limits<value_type>::infinity());
+		char buff[64];
+		std::snprintf(buff, sizeof(buff), "%.40Lg", static_cast<long double>(val) / 2 + static_cast<long double>(next) / 2);
+		REQUIRE(TestType::parse(buff).as_float() == correctly_rounded(buff));
+		TestType num(val);
+		REQUIRE(TestType::parse(num.to_string()).as_float() == val);
+	}
+	// Long doubles holding a double print its shortest text only when it reads back the same
+	REQUIRE(TestType(value_type(0.25)).to_string() == "0.25");
+	REQUIRE(TestType(value_type(1e22)).to_string() == "1e+22");
+	REQUIRE(TestType::parse(TestType(value_type(0.1)).to_string()).as_float() == value_type(0.1));
+	REQUIRE(TestType(value_type(-0.0)).to_string() == "-0");
+}
+
+TEST_CASE("numeric_t modulo", "[numeric_t]")
+{
+	REQUIRE((numeric_t(7LL) % numeric_t(3LL)).is_integer());
+	REQUIRE(numeric_t(7LL) % 3LL == 1);
+	REQUIRE(numeric_t(-7LL) % 3LL == -1);
+	REQUIRE(numeric_t(7LL) % -3LL == 1);
+	REQUIRE(numeric_t(INT64_MIN) % -1LL == 0);
+	REQUIRE(numeric_t(7.5L) % 2LL == 1.5L);
+	REQUIRE((numeric_t(7LL) % 2.5L).is_float());
+	REQUIRE(numeric_t(7LL) % 2.5L == 2);
+	REQUIRE(std::isnan((numeric_t(7LL) % 0LL).as_float()));
+
+	// Division by an integer zero falls back to floats as well
+	numeric_t inf = numeric_t(7LL) / numeric_t(0LL);
+	REQUIRE(inf.is_float());
+	REQUIRE(std::isinf(inf.as_float()));
+	REQUIRE(inf.as_float() > 0);
+	REQUIRE((numeric_t(-7LL) / 0LL).as_float() < 0);
+	REQUIRE(std::isnan((numeric_t(0LL) / 0LL).as_float()));
+
+	numeric_t big = numeric_t::parse("123456789012345678901234567890");
+	REQUIRE(big % 1000000007LL == 197434842);
+	REQUIRE((-big) % 1000000007LL == -197434842);
+	REQUIRE((big % big).is_integer());
+	REQUIRE(big % big == 0);
+}
+
+TEST_CASE("numeric_t power", "[numeric_t]")
+{
+	REQUIRE((numeric_t(3LL) ^ 4LL).is_integer());
+	REQUIRE((numeric_t(3LL) ^ 4LL) == 81);
+	REQUIRE((numeric_t(-2LL) ^ 63LL) == INT64_MIN);
+	REQUIRE((numeric_t(0LL) ^ 0LL) == 1);
+	REQUIRE((numeric_t(-1LL) ^ INT64_MAX) == -1);
+	REQUIRE((numeric_t(2LL) ^ -1LL).is_float());
+	REQUIRE((numeric_t(2LL) ^ -1LL) == 0.5L);
+	REQUIRE((numeric_t(4LL) ^ 0.5L) == 2);
+	REQUIRE((numeric_t(1.5L) ^ 2LL) == 2.25L);
+
+	numeric_t big = numeric_t(2LL) ^ 64LL;
+	REQUIRE(big.is_big());
+	REQUIRE(big.to_string() == "18446744073709551616");
+	REQUIRE((numeric_t(-3LL) ^ 41LL).to_string() == "-36472996377170786403");
+	REQUIRE(((big ^ 2LL) / big) == big);
+	// Far beyond the exact limit, floats take over
+	REQUIRE((numeric_t(10LL) ^ 100000LL).is_float());
+}
+
+TEST_CASE("integer_divisor matches builtin division", "[numeric_t]")
+{
+	const integer_t divisors[] = {1, -1, 2, -2, 3, -3, 7, 10, -10, 641, 1000000007, -1000000007, 1LL << 32, (1LL << 32) + 1,
+	                              INT64_MAX, -INT64_MAX, INT64_MIN, INT64_MIN + 1, 6700417, 0x5555555555555555LL};
+	const integer_t numers[] = {0, 1, -1, 2, -2, 6, -6, 7, -7, 1000, -1000, 1LL << 40, -(1LL << 40), 123456789012345LL,
+	                            -123456789012345LL, INT64_MAX, INT64_MAX - 1, INT64_MIN + 1, INT64_MIN};
+	for (integer_t d : divisors)
+	{
+		integer_divisor div(d);
+		REQUIRE(div.divisor() == d);
+		for (integer_t n : numers)
+		{
+			if (n == INT64_MIN && d == -1)
+				continue;
+			REQUIRE(div.quot(n) == n / d);
+			REQUIRE(div.rem(n) == n % d);
+		}
+	}
+	// Pseudo random sweep over small and large divisors
+	std::uint64_t state = 0x9e3779b97f4a7c15ull;
+	auto next = [&state]() {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return static_cast<integer_t>(state);
+	};
+	for (int i = 0; i < 2000; ++i)
+	{
+		integer_t d = next() >> (i % 62);
+		if (d == 0 || d == -1)
+			continue;
+		integer_divisor div(d);
+		for (int j = 0; j < 50; ++j)
+		{
+			integer_t n = next() >> (j % 63);
+			REQUIRE(div.quot(n) == n / d);
+			REQUIRE(div.rem(n) == n % d);
+		}
+	}
+	REQUIRE_THROWS_AS(integer_divisor(0), lang_error);
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <covscript/types/types.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 10'000'000;
+
+static std::size_t alloc_count = 0;
+
+void *operator new(std::size_t size)
+{
+	++alloc_count;
+	if (void *ptr = std::malloc(size))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+#define TIME_BLOCK(name, code)                                                                   \
+	do                                                                                           \
+	{                                                                                            \
+		std::size_t alloc_start = alloc_count;                                                   \
+		auto start = high_resolution_clock::now();                                               \
+		code auto end = high_resolution_clock::now();                                            \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms, " \
+		          << alloc_count - alloc_start << " allocations\n";                              \
+	} while (0)
+
+int main()
+{
+	using op = cs::var::operators_type;
+
+	std::cout << "=== Performance of cs::var operators ===\n";
+	std::cout << "sizeof(cs::var_borrower): " << sizeof(cs::var_borrower) << std::endl;
+
+	cs::var a = cs::numeric_t(1LL), b = cs::numeric_t(2LL), s = cs::string("str"), n = cs::numeric_t(1LL);
+
+	TIME_BLOCK("numeric a + b", {
+		cs::numeric_t sum;
+		for (size_t i = 0; i < N; ++i)
+			sum = sum + a.operate(op::add, &b).const_data()->const_val<cs::numeric_t>();
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("numeric a == b", {
+		size_t count = 0;
+		for (size_t i = 0; i < N; ++i)
+			count += a.operate(op::compare, &b).const_data()->const_val<cs::bool_t>();
+		volatile size_t dummy = count;
+	});
+
+	TIME_BLOCK("numeric a < b", {
+		size_t count = 0;
+		for (size_t i = 0; i < N; ++i)
+			count += a.operate(op::undcmp, &b).const_data()->const_val<cs::bool_t>();
+		volatile size_t dummy = count;
+	});
+
+	TIME_BLOCK("string + numeric", {
+		size_t length = 0;
+		for (size_t i = 0; i < N / 10; ++i)
+			length += s.operate(op::add, &n).const_data()->const_val<cs::string>().size();
+		volatile size_t dummy = length;
+	});
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <covscript/types/types.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 20'000;
+constexpr size_t M = 1'000'000;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+int main()
+{
+	std::cout << "=== Performance of rope strings ===\n";
+	std::vector<cs::string> pieces;
+	for (size_t i = 0; i < N; ++i)
+		pieces.push_back("piece-" + std::to_string(i) + ";");
+
+	// Script style concatenation, every step produces a new immutable value
+	TIME_BLOCK("string s = s + piece", {
+		cs::string s;
+		for (auto &piece : pieces)
+			s = s + piece;
+		volatile size_t dummy = s.size();
+	});
+
+	TIME_BLOCK("rope s = s + piece", {
+		cs::rope s;
+		for (auto &piece : pieces)
+			s = s + cs::rope(piece);
+		volatile size_t dummy = s.view().size();
+	});
+
+	// Pieces longer than short_limit become a node each
+	TIME_BLOCK("rope s = s + long piece, 4x", {
+		cs::rope s;
+		for (size_t i = 0; i < 4 * N; ++i)
+			s = s + cs::rope(cs::string(200, 'a' + i % 26));
+		volatile size_t dummy = s.view().size();
+	});
+
+	TIME_BLOCK("var string concatenation", {
+		cs::var s = cs::string();
+		for (auto &piece : pieces)
+		{
+			cs::var p = piece;
+			s = s.operate(cs::var::operators_type::add, &p).const_data()->const_val<cs::string>();
+		}
+		volatile size_t dummy = s.const_val<cs::string>().size();
+	});
+
+	TIME_BLOCK("var rope concatenation", {
+		cs::var s = cs::var::make<cs::rope>();
+		for (auto &piece : pieces)
+		{
+			cs::var p = piece;
+			s = s.operate(cs::var::operators_type::add, &p).const_data()->const_val<cs::rope>();
+		}
+		volatile size_t dummy = s.const_val<cs::rope>().view().size();
+	});
+
+	cs::string text;
+	for (auto &piece : pieces)
+		text += piece;
+	cs::rope text_rope(text);
+
+	TIME_BLOCK("string substr", {
+		size_t len = 0;
+		for (size_t i = 0; i < M; ++i)
+			len += text.substr(i % (text.size() / 2), 1024).size();
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("rope substr", {
+		size_t len = 0;
+		for (size_t i = 0; i < M; ++i)
+			len += text_rope.substr(i % (text.size() / 2), 1024).size();
+		volatile size_t dummy = len;
+	});
+
+	return 0;
+}
@@ -0,0 +1,179 @@
+#include <covscript/types/types.hpp>
+#include <catch2/catch_all.hpp>
+#include <thread>
+
+using namespace cs;
+
+TEST_CASE("rope construction and slicing", "[rope]")
+{
+	rope empty;
+	REQUIRE(empty.empty());
+	REQUIRE(empty.view().empty());
+	REQUIRE(empty.borrow().view().empty());
+
+	rope r("hello, world");
+	REQUIRE(r.size() == 12);
+	REQUIRE(r.is_flat());
+	REQUIRE(r.view() == "hello, world");
+	REQUIRE(r[7] == 'w');
+	REQUIRE_THROWS_AS(r.at(12), std::out_of_range);
+
+	rope hello = r.substr(0, 5), world = r.substr(7);
+	REQUIRE(hello.view() == "hello");
+	REQUIRE(world.view() == "world");
+	// Slices share the buffer
+	REQUIRE(hello.data() == r.data());
+	REQUIRE(world.data() == r.data() + 7);
+	REQUIRE(r.substr(12).empty());
+	REQUIRE(r.substr(3, 100).view() == "lo, world");
+	REQUIRE_THROWS_AS(r.substr(13), std::out_of_range);
+
+	// Only slices reaching the end of buffer are null terminated, others are copied
+	REQUIRE(world.borrow().data() == world.data());
+	REQUIRE(hello.borrow().data() != hello.data());
+	REQUIRE(hello.borrow().view() == "hello");
+}
+
+TEST_CASE("rope concatenation", "[rope]")
+{
+	byte_string_t long_a(200, 'a'), long_b(300, 'b');
+	rope a(long_a), b(long_b);
+	rope ab = a + b;
+	REQUIRE(ab.size() == 500);
+	REQUIRE(!ab.is_flat());
+	REQUIRE(ab.str() == long_a + long_b);
+	// str() walks the pieces without flattening
+	REQUIRE(!ab.is_flat());
+	REQUIRE(ab[199] == 'a');
+	REQUIRE(ab[200] == 'b');
+	REQUIRE(ab.is_flat());
+	REQUIRE(ab == rope(long_a + long_b));
+	REQUIRE(a < b);
+	REQUIRE(ab != a);
+
+	// Slices across the boundary and inside one side
+	rope c = a + b;
+	rope inside = c.substr(250, 10);
+	REQUIRE(inside.view() == byte_string_t(10, 'b'));
+	REQUIRE(inside.data() == b.data() + 50);
+	REQUIRE(!c.is_flat());
+	// Flattening for a slice across the boundary keeps the flat buffer in the node
+	REQUIRE(c.substr(190, 20).view() == byte_string_t(10, 'a') + byte_string_t(10, 'b'));
+	REQUIRE(c.is_flat());
+
+	// Short concatenations are flat
+	rope small = rope("ab") + rope("cd");
+	REQUIRE(small.is_flat());
+	REQUIRE(small.view() == "abcd");
+}
+
+TEST_CASE("rope repeated appends", "[rope]")
+{
+	rope r;
+	byte_string_t expect;
+	for (int i = 0; i < 20000; ++i)
+	{
+		byte_string_t piece = std::to_string(i) + ",";
+		r += rope(piece);
+		expect += piece;
+	}
+	REQUIRE(r.size() == expect.size());
+	std::size_t pieces = 0;
+	r.for_each_piece([&pieces](byte_string_view) { ++pieces; });
+	// Small appends are merged into leaves of at most short_limit
+	REQUIRE(pieces <= 2 * expect.size() / rope::short_limit + 1);
+	REQUIRE(r.str() == expect);
+	REQUIRE(r.view() == expect);
+	REQUIRE(r.substr(1000, 50).view() == expect.substr(1000, 50));
+}
+
+TEST_CASE("rope appends of long pieces", "[rope]")
+{
+	// Pieces above short_limit become a node each, the tree must stay logarithmic
+	rope r, front;
+	byte_string_t expect, expect_front;
+	for (int i = 0; i < 50000; ++i)
+	{
+		byte_string_t piece(200, 'a' + i % 26);
+		piece += std::to_string(i);
+		r += rope(piece);
+		expect += piece;
+		if (i % 10 == 0)
+		{
+			front = rope(piece) + front;
+			expect_front.insert(0, piece);
+		}
+	}
+	std::size_t log2_pieces = 0;
+	for (std::size_t n = 50000; n > 1; n >>= 1)
+		++log2_pieces;
+	REQUIRE(r.depth() <= 3 * log2_pieces / 2 + 2);
+	REQUIRE(front.depth() <= 3 * log2_pieces / 2 + 2);
+	REQUIRE(r.size() == expect.size());
+	REQUIRE(r.str() == expect);
+	REQUIRE(front.str() == expect_front);
+	REQUIRE(r.substr(123456, 1000).view() == expect.substr(123456, 1000));
+	// Concatenation of two deep trees
+	rope both = r + front;
+	REQUIRE(both.depth() <= r.depth() + 2);
+	REQUIRE(both.str() == expect + expect_front);
+}
+
+TEST_CASE("rope shared between threads", "[rope]")
+{
+	rope r;
+	for (int i = 0; i < 1000; ++i)
+		r += rope(byte_string_t(100, char('a' + i % 26)));
+	std::vector<std::thread> threads;
+	std::vector<const char *> data(4);
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([&, t]() {
+			rope copy = r;
+			data[t] = copy.data();
+		});
+	for (auto &th : threads)
+		th.join();
+	for (auto ptr : data)
+		REQUIRE(ptr == r.data());
+	REQUIRE(r[100 * 27] == 'b');
+}
+
+TEST_CASE("rope in variables", "[rope][basic_var]")
+{
+	using op = var::operators_type;
+	var a = var::make<rope>(byte_string_t(200, 'x')), b = var::make<rope>("yz");
+	var ab = a.operate(op::add, &b).const_data()->const_val<rope>();
+	REQUIRE(ab.const_val<rope>().size() == 202);
+	REQUIRE(ab.to_string().view() == byte_string_t(200, 'x') + "yz");
+	REQUIRE(ab.relocatable());
+
+	var s = byte_string_t("yz"), n = numeric_t(3LL);
+	REQUIRE(b.operate(op::compare, &s).const_data()->const_val<bool_t>());
+	REQUIRE(s.operate(op::compare, &b).const_data()->const_val<bool_t>());
+	REQUIRE(b.operate(op::add, &s).const_data()->const_val<rope>().view() == "yzyz");
+	REQUIRE(s.operate(op::add, &b).const_data()->const_val<rope>().view() == "yzyz");
+	REQUIRE(b.operate(op::add, &n).const_data()->const_val<rope>().view() == "yz3");
+	REQUIRE(b.operate(op::undcmp, &a).const_data()->const_val<bool_t>() == false);
+
+	// Hashes equal to strings of the same content
+	REQUIRE(b.hash() == s.hash());
+	var same = var::make<rope>("yz");
+	REQUIRE(b.compare(same));
+	// Equality of variables agrees with the compare operator, so both are one key of a map
+	REQUIRE(s == b);
+	REQUIRE(b == s);
+	REQUIRE(b != var(byte_string_t("yy")));
+	hash_map map;
+	map.emplace(s, numeric_t(1LL));
+	REQUIRE(map.count(b) == 1);
+	// Rope keys found by strings without a variable, and by strings of a different content not
+	hash_map ropes;
+	ropes.emplace(var::make<rope>(byte_string_t(150, 'r') + "key"), numeric_t(2LL));
+	ropes.emplace(b, numeric_t(3LL));
+	const byte_string_t long_key = byte_string_t(150, 'r') + "key";
+	REQUIRE(hash_count(ropes, byte_string_view(long_key)) == 1);
+	REQUIRE(hash_find(ropes, long_key)->second.const_val<numeric_t>() == 2);
+	REQUIRE(hash_find(ropes, "yz")->second.const_val<numeric_t>() == 3);
+	REQUIRE(hash_count(ropes, "yy") == 0);
+	REQUIRE(hash_count(ropes, byte_string_view(long_key).substr(1)) == 0);
+}
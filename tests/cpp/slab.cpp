@@ -0,0 +1,186 @@
+#include <covscript/types/types.hpp>
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <mutex>
+
+using namespace cs;
+
+TEST_CASE("slab_allocator size classes", "[slab]")
+{
+	slab_allocator<char> alloc;
+	std::vector<std::pair<char *, std::size_t>> blocks;
+	for (std::size_t size = 1; size <= 1024; size += 7)
+	{
+		for (int i = 0; i < 10; ++i)
+		{
+			char *ptr = alloc.allocate(size);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(ptr) % slab_detail::granularity == 0);
+			std::memset(ptr, int(size & 0xFF), size);
+			blocks.emplace_back(ptr, size);
+		}
+	}
+	for (auto &[ptr, size] : blocks)
+	{
+		bool intact = true;
+		for (std::size_t i = 0; i < size; ++i)
+			intact = intact && ptr[i] == char(size & 0xFF);
+		REQUIRE(intact);
+		alloc.deallocate(ptr, size);
+	}
+
+	// Freed blocks are served again
+	char *first = alloc.allocate(48);
+	alloc.deallocate(first, 48);
+	char *second = alloc.allocate(48);
+	REQUIRE(first == second);
+	alloc.deallocate(second, 48);
+
+	struct alignas(64) wide
+	{
+		char data[64];
+	};
+	slab_allocator<wide> wide_alloc = alloc;
+	wide *ptr = wide_alloc.allocate(3);
+	REQUIRE(reinterpret_cast<std::uintptr_t>(ptr) % 64 == 0);
+	wide_alloc.deallocate(ptr, 3);
+	REQUIRE(alloc == wide_alloc);
+	REQUIRE_THROWS_AS(slab_allocator<wide>().allocate(std::size_t(-1) / 2), std::bad_array_new_length);
+}
+
+TEST_CASE("slab_allocator many slabs", "[slab]")
+{
+	// Several slabs of one class, released in an order other than allocation
+	slab_allocator<std::uint64_t> alloc;
+	std::vector<std::uint64_t *> blocks;
+	for (std::uint64_t i = 0; i < 50000; ++i)
+	{
+		blocks.push_back(alloc.allocate(4));
+		blocks.back()[0] = i;
+		blocks.back()[3] = ~i;
+	}
+	for (std::size_t i = 0; i < blocks.size(); i += 2)
+		alloc.deallocate(blocks[i], 4);
+	for (std::size_t i = 0; i < blocks.size(); i += 2)
+		blocks[i] = alloc.allocate(4);
+	for (std::uint64_t i = 0; i < blocks.size(); ++i)
+	{
+		if (i % 2 == 1)
+			REQUIRE((blocks[i][0] == i && blocks[i][3] == ~i));
+		alloc.deallocate(blocks[i], 4);
+	}
+}
+
+TEST_CASE("slab_allocator frees across threads", "[slab]")
+{
+	slab_allocator<char> alloc;
+	std::vector<char *> blocks;
+	for (int i = 0; i < 10000; ++i)
+		blocks.push_back(alloc.allocate(32));
+	// Freed by another thread while the owner keeps allocating
+	std::thread other([&]() {
+		for (char *ptr : blocks)
+			alloc.deallocate(ptr, 32);
+	});
+	std::vector<char *> more;
+	for (int i = 0; i < 10000; ++i)
+		more.push_back(alloc.allocate(32));
+	other.join();
+	for (char *ptr : more)
+		alloc.deallocate(ptr, 32);
+
+	// Blocks outliving the thread that allocated them
+	std::vector<char *> orphans;
+	std::thread owner([&]() {
+		for (int i = 0; i < 10000; ++i)
+		{
+			orphans.push_back(alloc.allocate(64));
+			std::memset(orphans.back(), 'o', 64);
+		}
+	});
+	owner.join();
+	for (char *ptr : orphans)
+	{
+		REQUIRE(ptr[63] == 'o');
+		alloc.deallocate(ptr, 64);
+	}
+	// Slabs left behind are adopted
+	std::thread adopter([&]() {
+		for (int i = 0; i < 10000; ++i)
+			orphans[i] = alloc.allocate(64);
+		for (char *ptr : orphans)
+			alloc.deallocate(ptr, 64);
+	});
+	adopter.join();
+}
+
+TEST_CASE("slab_allocator multi-threaded stress", "[slab][basic_var]")
+{
+	// Producers hand variables to consumers, which destroy them on another thread
+	constexpr int producers = 4, per_producer = 20000;
+	auto make = [](int p, int i) -> var {
+		switch (i % 3)
+		{
+		case 0:
+			return numeric_t(integer_t(p * per_producer + i));
+		case 1:
+			return byte_string_t(40 + i % 200, 'a' + p);
+		default:
+			return array{var(numeric_t(integer_t(i))), var(byte_string_t(i % 50, 'x'))};
+		}
+	};
+	std::mutex lock;
+	std::vector<var> queue;
+	std::atomic<int> produced_done{0};
+	std::atomic<long long> checksum{0};
+	std::vector<std::thread> threads;
+	for (int p = 0; p < producers; ++p)
+	{
+		threads.emplace_back([&, p]() {
+			for (int i = 0; i < per_producer; ++i)
+			{
+				var val = make(p, i);
+				std::lock_guard<std::mutex> guard(lock);
+				queue.push_back(std::move(val));
+			}
+			++produced_done;
+		});
+		threads.emplace_back([&]() {
+			long long sum = 0;
+			for (;;)
+			{
+				std::vector<var> taken;
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					taken.swap(queue);
+				}
+				if (taken.empty())
+				{
+					if (produced_done == producers)
+					{
+						std::lock_guard<std::mutex> guard(lock);
+						if (queue.empty())
+							break;
+					}
+					std::this_thread::yield();
+					continue;
+				}
+				for (auto &val : taken)
+				{
+					var copy = val;
+					sum += copy.to_string().view().size();
+				}
+			}
+			checksum += sum;
+		});
+	}
+	for (auto &th : threads)
+		th.join();
+	long long expect = 0;
+	for (int p = 0; p < producers; ++p)
+		for (int i = 0; i < per_producer; ++i)
+			expect += make(p, i).to_string().view().size();
+	REQUIRE(checksum == expect);
+	REQUIRE(queue.empty());
+}
@@ -99,3 +99,70 @@ TEST_CASE("stack with different types", "[stack]")
 	REQUIRE(val == "world");
 	REQUIRE(s.top() == "hello");
 }
+
+TEST_CASE("segmented_stack keeps elements in place", "[stack]")
+{
+	segmented_stack<std::string, 4> s(0);
+	REQUIRE(s.empty());
+	s.push("bottom");
+	std::string &first = s.top();
+	std::vector<const std::string *> addresses;
+	for (int i = 0; i < 100; ++i)
+	{
+		s.push(std::to_string(i));
+		addresses.push_back(&s.top());
+	}
+	REQUIRE(s.size() == 101);
+	REQUIRE(&first == &s.bottom());
+	REQUIRE(first == "bottom");
+	for (int i = 0; i < 100; ++i)
+	{
+		REQUIRE(addresses[i] == &s[i + 1]);
+		REQUIRE(s.index(i + 1) == std::to_string(i));
+	}
+	REQUIRE_THROWS_AS(s.index(101), std::out_of_range);
+
+	int expected = 99;
+	for (auto &val : s)
+	{
+		if (expected >= 0)
+			REQUIRE(val == std::to_string(expected));
+		--expected;
+	}
+	REQUIRE(expected == -2);
+
+	// Popping across segment boundaries and pushing again
+	for (int i = 99; i >= 10; --i)
+		REQUIRE(s.pop() == std::to_string(i));
+	for (int i = 0; i < 3; ++i)
+	{
+		s.push("again");
+		s.pop_no_return();
+	}
+	REQUIRE(s.top() == "9");
+	REQUIRE(&first == &s.bottom());
+	s.clear();
+	REQUIRE(s.empty());
+	s.push("reused");
+	REQUIRE(s.top() == "reused");
+}
+
+TEST_CASE("segmented_stack destroys its elements", "[stack]")
+{
+	auto counter = std::make_shared<int>(0);
+	{
+		segmented_stack<std::shared_ptr<int>, 8> s;
+		for (int i = 0; i < 50; ++i)
+			s.push(counter);
+		REQUIRE(counter.use_count() == 51);
+		for (int i = 0; i < 20; ++i)
+			s.pop_no_return();
+		REQUIRE(counter.use_count() == 31);
+		const auto &cs = s;
+		std::size_t count = 0;
+		for (auto it = cs.begin(); it != cs.end(); ++it)
+			count += *it == counter;
+		REQUIRE(count == 30);
+	}
+	REQUIRE(counter.use_count() == 1);
+}
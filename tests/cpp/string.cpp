@@ -1,4 +1,5 @@
 #include <covscript/types/string.hpp>
+#include <covscript/types/exception.hpp>
 #include <catch2/catch_all.hpp>
 
 using namespace cs;
@@ -19,6 +20,101 @@ TEST_CASE("String: unicode operations", "[string]")
 	REQUIRE(unicode::unicode_to_byte(unicode_str.substr(0, 2)) == "你好");
 }
 
+// Straightforward decoder as reference, empty result if ill-formed
+static bool reference_decode(byte_string_view str, unicode_string_t &out)
+{
+	out.clear();
+	for (std::size_t i = 0; i < str.size();)
+	{
+		unsigned char c = str[i];
+		std::size_t len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+		if (len == 0 || i + len > str.size())
+			return false;
+		uchar_t cp = len == 1 ? c : c & (0x7F >> len);
+		for (std::size_t k = 1; k < len; ++k)
+		{
+			unsigned char d = str[i + k];
+			if ((d & 0xC0) != 0x80)
+				return false;
+			cp = cp << 6 | (d & 0x3F);
+		}
+		const uchar_t min_cp[] = {0, 0, 0x80, 0x800, 0x10000};
+		if (cp < min_cp[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+			return false;
+		out.push_back(cp);
+		i += len;
+	}
+	return true;
+}
+
+TEST_CASE("String: UTF-8 validation", "[string]")
+{
+	REQUIRE(unicode::is_valid(""));
+	REQUIRE(unicode::is_valid("plain ascii"));
+	REQUIRE(unicode::is_valid("\xF0\x9F\x98\x80 \xE4\xBD\xA0 \xC3\xA9"));
+	const char *invalid[] = {"\x80", "\xC0\xAF", "\xC3", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+	                         "\xF8\x88\x80\x80\x80", "\xFF", "\xE4\xBD", "\xC3\xA9\xA9"};
+	// Errors at every offset around the blocks of vector kernels
+	for (const char *bad : invalid)
+	{
+		for (std::size_t pos : {0, 1, 15, 16, 31, 32, 63, 64, 100})
+		{
+			byte_string_t str(pos, 'a');
+			str += bad;
+			REQUIRE(!unicode::is_valid(str));
+			str += byte_string_t(70, 'b');
+			REQUIRE(!unicode::is_valid(str));
+			REQUIRE_THROWS_AS(unicode::byte_to_unicode(str), lang_error);
+		}
+	}
+
+	// Random mixtures compared with the reference decoder
+	const char *pieces[] = {"a", "Hello, ", "\xC3\xA9", "\xE4\xBD\xA0\xE5\xA5\xBD", "\xF0\x9F\x98\x80", "\xEF\xBF\xBD",
+	                        "\xF4\x8F\xBF\xBF", "\x80", "\xC3", "\xED\xBF\xBF", "\xF0\x8F\xBF\xBF", "0123456789abcdef0123456789"};
+	std::uint32_t state = 12345;
+	unicode_string_t expect;
+	for (int round = 0; round < 3000; ++round)
+	{
+		byte_string_t str;
+		int count = round % 40;
+		for (int k = 0; k < count; ++k)
+		{
+			state = state * 1103515245u + 12345u;
+			// Mostly well-formed pieces
+			std::size_t idx = (state >> 16) % 12;
+			if (idx >= 7 && idx <= 10 && (state >> 8) % 8 != 0)
+				idx = 11;
+			str += pieces[idx];
+		}
+		bool valid = reference_decode(str, expect);
+		REQUIRE(unicode::is_valid(str) == valid);
+		if (valid)
+		{
+			REQUIRE(unicode::byte_to_unicode(str) == expect);
+			REQUIRE(unicode::unicode_to_byte(expect) == str);
+		}
+	}
+}
+
+TEST_CASE("String: UTF-32 to UTF-8 of invalid code points", "[string]")
+{
+	unicode_string_t ustr = U"ok";
+	ustr.push_back(0xD800);
+	ustr.push_back(0x110000);
+	ustr.push_back(0xFFFFFFFF);
+	ustr += U"\U0001F600";
+	byte_string_t str = unicode::unicode_to_byte(ustr);
+	REQUIRE(str == "ok\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xF0\x9F\x98\x80");
+	REQUIRE(unicode::is_valid(str));
+	// Long runs go through the vector paths
+	unicode_string_t long_str(1000, U'x');
+	long_str[500] = 0x7FFFFFFF;
+	long_str[501] = 0x80000000;
+	str = unicode::unicode_to_byte(long_str);
+	REQUIRE(str.size() == 998 + 6);
+	REQUIRE(str.substr(500, 6) == "\xEF\xBF\xBD\xEF\xBF\xBD");
+}
+
 TEST_CASE("basic_string_borrower default and borrow constructors", "[basic_string_borrower]")
 {
 	SECTION("default constructor")
@@ -116,4 +212,45 @@ TEST_CASE("basic_string_borrower access returns nullptr for borrowed", "[basic_s
 	const char *s = "borrowed";
 	byte_string_borrower b(s);
 	REQUIRE(b.access() == nullptr);
-}
\ No newline at end of file
+}
+TEST_CASE("basic_string_borrower keeps the length", "[basic_string_borrower]")
+{
+	byte_string_t str = "hello, world";
+	byte_string_borrower part = byte_string_view(str).substr(0, 5);
+	REQUIRE(part.view() == "hello");
+	REQUIRE(part.size() == 5);
+	REQUIRE(part.data() == str.data());
+
+	byte_string_borrower null_str(static_cast<const char *>(nullptr));
+	REQUIRE(!null_str.usable());
+	REQUIRE(null_str.view().empty());
+	REQUIRE(byte_string_borrower("").usable());
+
+	// Owned strings are stored in place, no matter short or long
+	byte_string_borrower short_str(byte_string_t("abc")), long_str(byte_string_t(100, 'x'));
+	REQUIRE(short_str.size() == 3);
+	REQUIRE(long_str.size() == 100);
+	const char *long_data = long_str.data();
+	byte_string_borrower moved = std::move(long_str);
+	REQUIRE(moved.data() == long_data);
+}
+
+TEST_CASE("basic_string_borrower assignment between kinds", "[basic_string_borrower]")
+{
+	byte_string_borrower owned(byte_string_t("owned")), borrowed("borrowed");
+	byte_string_borrower a = owned, b = borrowed;
+	a = borrowed;
+	REQUIRE(a.view() == "borrowed");
+	REQUIRE(a.access() == nullptr);
+	b = owned;
+	REQUIRE(b.view() == "owned");
+	REQUIRE(b.access() != nullptr);
+	b = b;
+	REQUIRE(b.view() == "owned");
+	a = std::move(b);
+	REQUIRE(a.view() == "owned");
+	REQUIRE(b.view().empty());
+	REQUIRE(!b.usable());
+	a = byte_string_borrower(byte_string_t(64, 'y'));
+	REQUIRE(a.view() == byte_string_t(64, 'y'));
+}
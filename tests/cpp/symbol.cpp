@@ -0,0 +1,100 @@
+#include <covscript/types/types.hpp>
+#include <catch2/catch_all.hpp>
+
+using namespace cs;
+
+struct Point
+{
+	var x = numeric_t(1LL);
+	var y = numeric_t(2LL);
+};
+
+struct Named
+{
+	var name = string("named");
+};
+
+static const symbol_t sym_x("x"), sym_y("y");
+
+namespace cs_impl::operators
+{
+	// Resolved by symbol comparison
+	template <>
+	var_borrower access<var_borrower, Point>(const Point &p, const cs::symbol_t &member)
+	{
+		if (member == sym_x)
+			return p.x;
+		else if (member == sym_y)
+			return p.y;
+		else
+			throw cs::runtime_error("No member " + cs::string(member.view()));
+	}
+
+	// Only access by name, symbols fall back to it
+	template <>
+	var_borrower access<var_borrower, Named>(const Named &n, const cs::byte_string_view &member)
+	{
+		if (member == "name")
+			return n.name;
+		else
+			throw cs::runtime_error("No member " + cs::string(member));
+	}
+} // namespace cs_impl::operators
+
+TEST_CASE("symbol interning", "[symbol]")
+{
+	symbol_t a("member"), b(string("member")), c("other");
+	REQUIRE(a == b);
+	REQUIRE(a != c);
+	REQUIRE(a.id() == b.id());
+	REQUIRE(a.id() != c.id());
+	REQUIRE(a.view() == "member");
+	REQUIRE(std::string(a.data()) == "member");
+	REQUIRE(a.hash() == std::hash<string_view>{}("member"));
+
+	std::size_t count = symbol_t::table_size();
+	symbol_t again("member");
+	REQUIRE(symbol_t::table_size() == count);
+
+	SECTION("null symbol")
+	{
+		symbol_t empty, empty_str("");
+		REQUIRE(empty == empty_str);
+		REQUIRE(empty.empty());
+		REQUIRE(empty.id() == 0);
+		REQUIRE(empty.view().empty());
+		REQUIRE(empty != a);
+	}
+}
+
+TEST_CASE("symbol as key", "[symbol]")
+{
+	map_t<symbol_t, int> slots;
+	slots.emplace(symbol_t("a"), 1);
+	slots.emplace(symbol_t("b"), 2);
+	REQUIRE(slots.at(symbol_t("a")) == 1);
+	REQUIRE(slots.at(symbol_t("b")) == 2);
+
+	hash_map vars;
+	vars.emplace(symbol_t("key"), numeric_t(42LL));
+	REQUIRE(vars.at(symbol_t("key")).const_val<numeric_t>() == 42);
+	// Symbols and strings are different types
+	REQUIRE(vars.count(string("key")) == 0);
+
+	var sym = symbol_t("key");
+	REQUIRE(sym.hash() == symbol_t("key").hash());
+	REQUIRE(sym.to_string().view() == "key");
+}
+
+TEST_CASE("member access by symbol", "[symbol]")
+{
+	using op = var::operators_type;
+	const var p = Point();
+	var member = sym_y;
+	REQUIRE(p.operate(op::access, &member).const_data()->const_val<numeric_t>() == 2);
+
+	const var n = Named();
+	var name_sym = symbol_t("name"), name_str = string("name");
+	REQUIRE(n.operate(op::access, &name_sym).const_data()->const_val<string>() == "named");
+	REQUIRE(n.operate(op::access, &name_str).const_data()->const_val<string>() == "named");
+}
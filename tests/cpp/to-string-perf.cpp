@@ -0,0 +1,164 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <covscript/types/types.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 1'000'000;
+constexpr size_t R = 10;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+// Concatenation of element strings, as a container formatter without a sink would do
+static cs::string concat_to_string(const cs::var &val)
+{
+	if (val.is_type_of<cs::hash_map>())
+	{
+		cs::string res = "{";
+		for (auto &it : val.const_val<cs::hash_map>())
+		{
+			if (res.size() > 1)
+				res += ", ";
+			res += concat_to_string(it.first) + ":" + concat_to_string(it.second);
+		}
+		return res + "}";
+	}
+	else if (val.is_type_of<cs::array>())
+	{
+		cs::string res = "{";
+		for (auto &it : val.const_val<cs::array>())
+		{
+			if (res.size() > 1)
+				res += ", ";
+			res += concat_to_string(it);
+		}
+		return res + "}";
+	}
+	else
+		return cs::string(val.to_string().view());
+}
+
+int main()
+{
+	std::cout << "=== Performance of var::to_string ===\n";
+	std::cout << "sizeof(cs::string_borrower): " << sizeof(cs::string_borrower) << std::endl;
+
+	// Borrowed, short owned, long owned and null values mixed
+	std::vector<cs::var> values;
+	values.reserve(N);
+	for (size_t i = 0; i < N; ++i)
+	{
+		switch (i % 6)
+		{
+		case 0:
+			values.emplace_back(cs::numeric_t(cs::integer_t(i)));
+			break;
+		case 1:
+			values.emplace_back(cs::numeric_t(cs::float_t(i) / 7));
+			break;
+		case 2:
+			values.emplace_back(cs::string("name_" + std::to_string(i % 100)));
+			break;
+		case 3:
+			values.emplace_back(cs::bool_t(i % 2 == 0));
+			break;
+		case 4:
+			values.emplace_back(cs::var::make<cs::rope>(cs::string(200, 'r')));
+			break;
+		default:
+			values.emplace_back();
+			break;
+		}
+	}
+
+	TIME_BLOCK("var::to_string", {
+		size_t len = 0;
+		for (size_t r = 0; r < R; ++r)
+			for (auto &val : values)
+				len += val.to_string().view().size();
+		volatile size_t dummy = len;
+	});
+
+	// Every kind alone, floats are bound by formatting rather than the borrower
+	const char *kinds[] = {"integer", "float", "string", "bool", "rope", "null"};
+	for (size_t kind = 0; kind < 6; ++kind)
+	{
+		std::vector<cs::var> same;
+		for (size_t i = kind; i < N; i += 6)
+			same.push_back(values[i]);
+		TIME_BLOCK(std::string("var::to_string ") + kinds[kind], {
+			size_t len = 0;
+			for (size_t r = 0; r < R * 6; ++r)
+				for (auto &val : same)
+					len += val.to_string().view().size();
+			volatile size_t dummy = len;
+		});
+	}
+
+	TIME_BLOCK("var::type_name", {
+		size_t len = 0;
+		for (size_t r = 0; r < R; ++r)
+			for (auto &val : values)
+				len += val.type_name().view().size();
+		volatile size_t dummy = len;
+	});
+
+	// Copies as taken by exceptions and containers of results
+	TIME_BLOCK("var::to_string copied", {
+		size_t len = 0;
+		for (size_t r = 0; r < R; ++r)
+			for (auto &val : values)
+			{
+				cs::string_borrower str = val.to_string();
+				cs::string_borrower copy = str;
+				len += copy.view().size();
+			}
+		volatile size_t dummy = len;
+	});
+
+	// Nested map of arrays, about 10 MB of text
+	cs::hash_map nested;
+	for (size_t i = 0; i < 10'000; ++i)
+	{
+		cs::array row;
+		for (size_t j = 0; j < 100; ++j)
+			row.emplace_back(cs::numeric_t(cs::integer_t(i * j)));
+		nested.emplace(cs::numeric_t(cs::integer_t(i)), cs::var(std::move(row)));
+	}
+	cs::var nested_var = std::move(nested);
+
+	TIME_BLOCK("nested hash_map by concatenation", {
+		size_t len = 0;
+		for (size_t r = 0; r < R; ++r)
+			len += concat_to_string(nested_var).size();
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("nested hash_map var::to_string", {
+		size_t len = 0;
+		for (size_t r = 0; r < R; ++r)
+			len += nested_var.to_string().view().size();
+		volatile size_t dummy = len;
+	});
+
+	TIME_BLOCK("nested hash_map var::to_stream reused sink", {
+		size_t len = 0;
+		cs::string out;
+		for (size_t r = 0; r < R; ++r)
+		{
+			out.clear();
+			nested_var.to_stream(out);
+			len += out.size();
+		}
+		volatile size_t dummy = len;
+	});
+
+	return 0;
+}
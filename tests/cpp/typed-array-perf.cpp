@@ -0,0 +1,124 @@
+#include <iostream>
+#include <chrono>
+#include <covscript/types/typed_array.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 1'000'000;
+constexpr size_t R = 100;
+
+#define TIME_BLOCK(name, code)                                                                    \
+	do                                                                                            \
+	{                                                                                             \
+		auto start = high_resolution_clock::now();                                                \
+		code auto end = high_resolution_clock::now();                                             \
+		std::cout << name << ": " << duration_cast<milliseconds>(end - start).count() << " ms\n"; \
+	} while (0)
+
+int main()
+{
+	std::cout << "=== Performance of cs::typed_array vs cs::array ===\n";
+	std::cout << "SIMD: " << cs::simd::active_isa() << std::endl;
+
+	cs::array int_arr, float_arr;
+	cs::typed_array int_typed, float_typed;
+	for (size_t i = 0; i < N; ++i)
+	{
+		int_arr.emplace_back(cs::numeric_t(cs::integer_t(i)));
+		float_arr.emplace_back(cs::numeric_t(cs::float_t(i) + 0.5L));
+		int_typed.push_back(cs::numeric_t(cs::integer_t(i)));
+		float_typed.push_back(cs::numeric_t(cs::float_t(i) + 0.5L));
+	}
+
+	TIME_BLOCK("cs::array sum integer", {
+		cs::numeric_t sum;
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : int_arr)
+				sum = sum + v.const_val<cs::numeric_t>();
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("cs::typed_array sum integer", {
+		cs::numeric_t sum;
+		for (size_t r = 0; r < R; ++r)
+			sum = sum + int_typed.sum();
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("cs::array sum float", {
+		cs::numeric_t sum;
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : float_arr)
+				sum = sum + v.const_val<cs::numeric_t>();
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("cs::typed_array sum float", {
+		cs::numeric_t sum;
+		for (size_t r = 0; r < R; ++r)
+			sum = sum + float_typed.sum();
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("cs::array dot float", {
+		cs::numeric_t sum;
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : float_arr)
+				sum = sum + v.const_val<cs::numeric_t>() * v.const_val<cs::numeric_t>();
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("cs::typed_array dot float", {
+		cs::numeric_t sum;
+		for (size_t r = 0; r < R; ++r)
+			sum = sum + float_typed.dot(float_typed);
+		volatile cs::integer_t dummy = sum.as_integer();
+	});
+
+	TIME_BLOCK("cs::typed_array add float", {
+		size_t size = 0;
+		for (size_t r = 0; r < R; ++r)
+			size += float_typed.arith(cs::simd::arith_op::add, float_typed).size();
+		volatile size_t dummy = size;
+	});
+
+	cs::var pivot = cs::numeric_t(cs::integer_t(N / 2));
+
+	TIME_BLOCK("cs::array compare integer", {
+		size_t count = 0;
+		for (size_t r = 0; r < R; ++r)
+			for (auto &v : int_arr)
+				count += v.const_val<cs::numeric_t>() < pivot.const_val<cs::numeric_t>();
+		volatile size_t dummy = count;
+	});
+
+	TIME_BLOCK("cs::typed_array compare integer", {
+		size_t count = 0;
+		for (size_t r = 0; r < R; ++r)
+			count += int_typed.compare(cs::simd::compare_op::lt, pivot).sum().as_integer();
+		volatile size_t dummy = count;
+	});
+
+	cs::var last = cs::numeric_t(cs::integer_t(N - 1));
+
+	TIME_BLOCK("cs::array find integer", {
+		size_t idx = 0;
+		for (size_t r = 0; r < R; ++r)
+			for (size_t i = 0; i < N; ++i)
+				if (int_arr[i].compare(last))
+				{
+					idx += i;
+					break;
+				}
+		volatile size_t dummy = idx;
+	});
+
+	TIME_BLOCK("cs::typed_array find integer", {
+		size_t idx = 0;
+		for (size_t r = 0; r < R; ++r)
+			idx += int_typed.find(last);
+		volatile size_t dummy = idx;
+	});
+
+	return 0;
+}
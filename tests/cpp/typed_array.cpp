@@ -0,0 +1,240 @@
+#include <covscript/types/typed_array.hpp>
+#include <catch2/catch_all.hpp>
+#include <limits>
+
+using namespace cs;
+
+using kind = typed_array::kind_type;
+
+static typed_array make_integers(std::size_t n)
+{
+	typed_array arr;
+	for (std::size_t i = 0; i < n; ++i)
+		arr.push_back(numeric_t(integer_t(i)));
+	return arr;
+}
+
+static typed_array make_floats(std::size_t n)
+{
+	typed_array arr;
+	for (std::size_t i = 0; i < n; ++i)
+		arr.push_back(numeric_t(cs::float_t(i) + 0.5L));
+	return arr;
+}
+
+TEST_CASE("typed array kinds", "[typed_array]")
+{
+	typed_array arr;
+	REQUIRE(arr.kind() == kind::none);
+	REQUIRE(arr.empty());
+
+	SECTION("integer")
+	{
+		arr.push_back(numeric_t(1LL));
+		arr.push_back(numeric_t(2LL));
+		REQUIRE(arr.kind() == kind::integer);
+		REQUIRE(arr.integers()[1] == 2);
+		REQUIRE(arr.get(0).const_val<numeric_t>() == 1);
+		arr.set(1, numeric_t(5LL));
+		REQUIRE(arr.get(1).const_val<numeric_t>() == 5);
+		REQUIRE(arr.kind() == kind::integer);
+	}
+
+	SECTION("floating")
+	{
+		arr.push_back(numeric_t(0.25L));
+		REQUIRE(arr.kind() == kind::floating);
+		REQUIRE(arr.floats()[0] == 0.25);
+		REQUIRE(arr.get(0).const_val<numeric_t>().is_float());
+	}
+
+	SECTION("boolean")
+	{
+		arr.push_back(true);
+		arr.push_back(false);
+		REQUIRE(arr.kind() == kind::boolean);
+		REQUIRE(arr.get(0).const_val<bool_t>());
+		REQUIRE_FALSE(arr.get(1).const_val<bool_t>());
+	}
+
+	SECTION("generic")
+	{
+		arr.push_back(string("str"));
+		REQUIRE(arr.kind() == kind::generic);
+		REQUIRE(arr.get(0).const_val<string>() == "str");
+	}
+
+	REQUIRE_THROWS_AS(arr.get(10), runtime_error);
+}
+
+TEST_CASE("typed array promotion", "[typed_array]")
+{
+	typed_array arr = make_integers(10);
+	REQUIRE(arr.kind() == kind::integer);
+
+	SECTION("push non-matching")
+	{
+		arr.push_back(numeric_t(1.5L));
+		REQUIRE(arr.kind() == kind::generic);
+		REQUIRE(arr.size() == 11);
+		REQUIRE(arr.get(3).const_val<numeric_t>() == 3);
+		REQUIRE(arr.get(10).const_val<numeric_t>() == numeric_t(1.5L));
+		REQUIRE(arr.generic().size() == 11);
+	}
+
+	SECTION("push bigint")
+	{
+		numeric_t big = numeric_t(std::numeric_limits<integer_t>::max()) * numeric_t(4LL);
+		arr.push_back(big);
+		REQUIRE(arr.kind() == kind::generic);
+		REQUIRE(arr.get(10).const_val<numeric_t>() == big);
+	}
+
+		SECTION("set non-matching")
+	{
+		arr.set(4, string("four"));
+		REQUIRE(arr.kind() == kind::generic);
+		REQUIRE(arr.get(4).const_val<string>() == "four");
+		REQUIRE(arr.get(5).const_val<numeric_t>() == 5);
+	}
+
+	SECTION("to array")
+	{
+		array generic = arr.to_array();
+		REQUIRE(arr.kind() == kind::integer);
+		REQUIRE(generic.size() == 10);
+		REQUIRE(generic[9].const_val<numeric_t>() == 9);
+	}
+}
+
+TEST_CASE("typed array kernels", "[typed_array]")
+{
+	// Sizes not multiple of the vector width exercise the scalar tails
+	const std::size_t n = 1003;
+	typed_array ints = make_integers(n), floats = make_floats(n);
+
+	SECTION("sum and dot")
+	{
+		REQUIRE(ints.sum() == integer_t(n * (n - 1) / 2));
+		REQUIRE(floats.sum().as_float() == Catch::Approx(double(n * (n - 1) / 2) + 0.5 * n));
+		REQUIRE(ints.dot(ints) == integer_t((n - 1) * n * (2 * n - 1) / 6));
+
+		typed_array flags;
+		for (std::size_t i = 0; i < n; ++i)
+			flags.push_back(i % 3 == 0);
+		REQUIRE(flags.sum() == integer_t((n + 2) / 3));
+	}
+
+	SECTION("elementwise")
+	{
+		typed_array res = ints.arith(simd::arith_op::add, ints);
+		REQUIRE(res.kind() == kind::integer);
+		REQUIRE(res.get(n - 1).const_val<numeric_t>() == integer_t(2 * (n - 1)));
+
+		res = ints.arith(simd::arith_op::mul, ints);
+		REQUIRE(res.get(7).const_val<numeric_t>() == 49);
+
+		res = floats.arith(simd::arith_op::sub, floats);
+		REQUIRE(res.kind() == kind::floating);
+		REQUIRE(res.sum() == numeric_t(0.0L));
+
+		// Same as numeric_t, 3 / 2 is a float
+		typed_array twos;
+		for (std::size_t i = 0; i < n; ++i)
+			twos.push_back(numeric_t(2LL));
+		res = ints.arith(simd::arith_op::div, twos);
+		REQUIRE(res.get(3).const_val<numeric_t>() == numeric_t(1.5L));
+		REQUIRE(res.get(4).const_val<numeric_t>().is_integer());
+
+		REQUIRE_THROWS_AS(ints.arith(simd::arith_op::add, make_integers(3)), lang_error);
+	}
+
+	SECTION("compare")
+	{
+		typed_array mask = ints.compare(simd::compare_op::lt, numeric_t(100LL));
+		REQUIRE(mask.kind() == kind::boolean);
+		REQUIRE(mask.size() == n);
+		REQUIRE(mask.sum() == 100);
+		REQUIRE(ints.compare(simd::compare_op::ge, numeric_t(100LL)).sum() == integer_t(n - 100));
+		REQUIRE(ints.compare(simd::compare_op::ne, numeric_t(5LL)).sum() == integer_t(n - 1));
+		REQUIRE(ints.compare(simd::compare_op::le, numeric_t(5LL)).sum() == 6);
+		REQUIRE(ints.compare(simd::compare_op::gt, numeric_t(5LL)).sum() == integer_t(n - 6));
+		REQUIRE(floats.compare(simd::compare_op::eq, numeric_t(10.5L)).sum() == 1);
+		REQUIRE(floats.compare(simd::compare_op::gt, numeric_t(10.5L)).sum() == integer_t(n - 11));
+		// Mixed kinds go through numeric comparison
+		REQUIRE(ints.compare(simd::compare_op::lt, numeric_t(2.5L)).sum() == 3);
+	}
+
+	SECTION("find")
+	{
+		REQUIRE(ints.find(numeric_t(integer_t(n - 1))) == n - 1);
+		REQUIRE(ints.find(numeric_t(-1LL)) == typed_array::npos);
+		REQUIRE(ints.find(numeric_t(7.0L)) == 7);
+		REQUIRE(floats.find(numeric_t(500.5L)) == 500);
+		REQUIRE(ints.find(string("7")) == typed_array::npos);
+
+		typed_array flags;
+		for (std::size_t i = 0; i < n; ++i)
+			flags.push_back(i == 777);
+		REQUIRE(flags.find(true) == 777);
+	}
+}
+
+TEST_CASE("typed array integer overflow", "[typed_array]")
+{
+	const numeric_t max(std::numeric_limits<integer_t>::max()), min(std::numeric_limits<integer_t>::min());
+	// Results agree with numeric_t, which promotes to bigint
+	typed_array small{max, numeric_t(1LL)};
+	REQUIRE(small.sum() == max + numeric_t(1LL));
+	REQUIRE(small.sum().is_big());
+
+	// Overflow in a vector lane and in the scalar tail
+	for (std::size_t n : {16, 17, 33})
+	{
+		typed_array arr;
+		numeric_t expected_sum, expected_dot;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			numeric_t val = i + 1 == n ? max : numeric_t(integer_t(i));
+			arr.push_back(val);
+			expected_sum = expected_sum + val;
+			expected_dot = expected_dot + val * val;
+		}
+		REQUIRE(arr.kind() == kind::integer);
+		REQUIRE(arr.sum() == expected_sum);
+		REQUIRE(arr.dot(arr) == expected_dot);
+		REQUIRE(arr.dot(arr).is_big());
+	}
+
+	// Lanes overflowing back and forth, the sequential sum fits
+	typed_array swing;
+	for (int i = 0; i < 8; ++i)
+		swing.push_back(i % 4 < 2 ? max : min);
+	REQUIRE(swing.kind() == kind::integer);
+	REQUIRE(swing.sum() == numeric_t(-4LL));
+	REQUIRE_FALSE(swing.sum().is_big());
+
+	// Elementwise results fall back to generic arrays holding bigints
+	typed_array lhs, rhs;
+	for (int i = 0; i < 9; ++i)
+	{
+		lhs.push_back(i == 5 ? max : numeric_t(integer_t(i)));
+		rhs.push_back(i == 5 ? max : numeric_t(integer_t(i)));
+	}
+	for (auto op : {simd::arith_op::add, simd::arith_op::mul})
+	{
+		typed_array res = lhs.arith(op, rhs);
+		REQUIRE(res.is_generic());
+		numeric_t expected = op == simd::arith_op::add ? max + max : max * max;
+		REQUIRE(res.get(5).const_val<numeric_t>() == expected);
+		REQUIRE(res.get(3).const_val<numeric_t>() == (op == simd::arith_op::add ? 6 : 9));
+	}
+	typed_array neg;
+	for (int i = 0; i < 9; ++i)
+		neg.push_back(i == 2 ? min : numeric_t(integer_t(i)));
+	typed_array diff = neg.arith(simd::arith_op::sub, lhs);
+	REQUIRE(diff.get(2).const_val<numeric_t>() == min - numeric_t(2LL));
+	REQUIRE(diff.get(2).const_val<numeric_t>().is_big());
+	// No overflow, stays unboxed
+	REQUIRE(lhs.arith(simd::arith_op::sub, rhs).kind() == kind::integer);
+}
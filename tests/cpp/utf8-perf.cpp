@@ -0,0 +1,118 @@
+#include <iostream>
+#include <chrono>
+#include <iterator>
+#include <string>
+#include <utfcpp/utf8.h>
+#include <covscript/types/simd.hpp>
+#include <covscript/types/string.hpp>
+#include <covscript/types/utf8_string.hpp>
+
+using namespace std::chrono;
+
+constexpr size_t N = 8'000'000;
+constexpr size_t R = 10;
+
+#define TIME_BLOCK(name, code)                                                                                              \
+	do                                                                                                                      \
+	{                                                                                                                       \
+		auto start = high_resolution_clock::now();                                                                          \
+		code auto end = high_resolution_clock::now();                                                                       \
+		double secs = duration_cast<duration<double>>(end - start).count();                                                 \
+		std::cout << name << ": " << static_cast<long long>(secs * 1000) << " ms, " << R * N / secs / 1e9 << " GB/s\n"; \
+	} while (0)
+
+static void bench(const char *title, const std::string &text)
+{
+	std::cout << "--- " << title << " ---\n";
+
+	TIME_BLOCK("utf8::is_valid", {
+		size_t valid = 0;
+		for (size_t r = 0; r < R; ++r)
+			valid += utf8::is_valid(text.begin(), text.end());
+		volatile size_t dummy = valid;
+	});
+
+	TIME_BLOCK("cs::unicode::is_valid", {
+		size_t valid = 0;
+		for (size_t r = 0; r < R; ++r)
+			valid += cs::unicode::is_valid(text);
+		volatile size_t dummy = valid;
+	});
+
+	std::u32string wide;
+	TIME_BLOCK("utf8::utf8to32", {
+		for (size_t r = 0; r < R; ++r)
+		{
+			wide.clear();
+			utf8::utf8to32(text.begin(), text.end(), std::back_inserter(wide));
+		}
+		volatile size_t dummy = wide.size();
+	});
+
+	TIME_BLOCK("cs::unicode::byte_to_unicode", {
+		for (size_t r = 0; r < R; ++r)
+			wide = cs::unicode::byte_to_unicode(text);
+		volatile size_t dummy = wide.size();
+	});
+
+	std::string narrow;
+	TIME_BLOCK("utf8::unchecked::utf32to8", {
+		for (size_t r = 0; r < R; ++r)
+		{
+			narrow.clear();
+			utf8::unchecked::utf32to8(wide.begin(), wide.end(), std::back_inserter(narrow));
+		}
+		volatile size_t dummy = narrow.size();
+	});
+
+	TIME_BLOCK("cs::unicode::unicode_to_byte", {
+		for (size_t r = 0; r < R; ++r)
+			narrow = cs::unicode::unicode_to_byte(wide);
+		volatile size_t dummy = narrow.size();
+	});
+}
+
+// Random code point access, including the conversion or index built for it
+static void bench_access(const std::string &text, size_t count)
+{
+	std::cout << "--- " << count << " random code point accesses, Mixed ---\n";
+	auto start = high_resolution_clock::now();
+	{
+		std::u32string wide = cs::unicode::byte_to_unicode(text);
+		char32_t sum = 0;
+		for (size_t i = 0, r = 1; i < count; ++i, r = r * 6364136223846793005ull + 1442695040888963407ull)
+			sum += wide[(r >> 33) % wide.size()];
+		volatile char32_t dummy = sum;
+	}
+	auto mid = high_resolution_clock::now();
+	{
+		cs::utf8_string_t str(text);
+		char32_t sum = 0;
+		for (size_t i = 0, r = 1; i < count; ++i, r = r * 6364136223846793005ull + 1442695040888963407ull)
+			sum += str[(r >> 33) % str.length()];
+		volatile char32_t dummy = sum;
+	}
+	auto end = high_resolution_clock::now();
+	std::cout << "byte_to_unicode then index: " << duration_cast<microseconds>(mid - start).count() << " us\n";
+	std::cout << "utf8_string_t then index: " << duration_cast<microseconds>(end - mid).count() << " us\n";
+}
+
+int main()
+{
+	std::cout << "=== Performance of UTF-8 validation and transcoding (" << cs::simd::active_isa() << ") ===\n";
+	std::string ascii, mixed;
+	while (ascii.size() < N)
+		ascii += "The quick brown fox jumps over the lazy dog. ";
+	ascii.resize(N);
+	// Mostly ASCII with Latin, CJK and emoji scattered in
+	while (mixed.size() < N)
+		mixed += "covscript \xC3\xA9t\xC3\xA9 \xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C \xF0\x9F\x98\x80 text ";
+	while (!cs::unicode::is_valid(mixed))
+		mixed.pop_back();
+	bench("ASCII", ascii);
+	bench("Mixed", mixed);
+
+	bench_access(mixed, 1'000);
+	bench_access(mixed, 10'000'000);
+	return 0;
+}
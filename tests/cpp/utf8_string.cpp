@@ -0,0 +1,129 @@
+#include <covscript/types/types.hpp>
+#include <catch2/catch_all.hpp>
+#include <thread>
+
+using namespace cs;
+
+TEST_CASE("utf8_string basic operations", "[utf8_string]")
+{
+	utf8_string empty;
+	REQUIRE(empty.empty());
+	REQUIRE(empty.length() == 0);
+	REQUIRE(empty.begin() == empty.end());
+	REQUIRE(empty.substr(0).empty());
+
+	utf8_string str("你好，world！");
+	REQUIRE(str.length() == 9);
+	REQUIRE(str.size() == 17);
+	REQUIRE(!str.is_ascii());
+	REQUIRE(str[0] == U'你');
+	REQUIRE(str[3] == U'w');
+	REQUIRE(str.at(8) == U'！');
+	REQUIRE_THROWS_AS(str.at(9), std::out_of_range);
+	REQUIRE(str.offset_of(9) == str.size());
+	REQUIRE_THROWS_AS(str.offset_of(10), std::out_of_range);
+	REQUIRE(str.view(0, 2) == "你好");
+	REQUIRE(str.substr(3, 5).str() == "world");
+	REQUIRE(str.substr(8).str() == "！");
+	REQUIRE(str.substr(9).empty());
+	REQUIRE_THROWS_AS(str.substr(10), std::out_of_range);
+	REQUIRE(str.to_unicode() == U"你好，world！");
+	REQUIRE(unicode_string_t(str.begin(), str.end()) == U"你好，world！");
+
+	REQUIRE_THROWS_AS(utf8_string("\xC3\x28"), lang_error);
+	utf8_string from_unicode(unicode_string_view(U"\U0001F600!"));
+	REQUIRE(from_unicode.str() == "\xF0\x9F\x98\x80!");
+	REQUIRE(from_unicode.length() == 2);
+
+	utf8_string joined = str + utf8_string("\xF0\x9F\x98\x80");
+	REQUIRE(joined.length() == 10);
+	REQUIRE(joined[9] == U'\U0001F600');
+	joined += joined;
+	REQUIRE(joined.length() == 20);
+	REQUIRE(joined[19] == U'\U0001F600');
+	REQUIRE(utf8_string("a") < utf8_string("\xC3\xA9"));
+}
+
+TEST_CASE("utf8_string indexing long content", "[utf8_string]")
+{
+	// Code points of every encoded length, crossing many index strides
+	const uchar_t samples[] = {U'a', U'é', U'你', U'\U0001F600', U'z'};
+	unicode_string_t expect;
+	for (std::size_t i = 0; i < 5000; ++i)
+		expect.push_back(samples[(i * 7 + i / 13) % 5]);
+	utf8_string str(expect);
+	REQUIRE(str.length() == expect.size());
+	for (std::size_t i = 0; i < expect.size(); ++i)
+		REQUIRE(str[i] == expect[i]);
+	for (std::size_t pos : {0, 1, 63, 64, 65, 127, 128, 1000, 4990})
+	{
+		for (std::size_t len : {0, 1, 10, 64, 65, 200, 5000})
+		{
+			utf8_string sub = str.substr(pos, len);
+			unicode_string_t part = expect.substr(pos, len);
+			REQUIRE(sub.length() == part.size());
+			REQUIRE(sub.to_unicode() == part);
+			REQUIRE(sub.view() == str.view(pos, len));
+		}
+	}
+
+	// Copies keep the index, moves take it
+	utf8_string copy = str;
+	REQUIRE(copy[4321] == expect[4321]);
+	utf8_string moved = std::move(copy);
+	REQUIRE(moved[4999] == expect[4999]);
+	REQUIRE(copy.empty());
+
+	utf8_string ascii(byte_string_t(1000, 'x') + "y");
+	REQUIRE(ascii.is_ascii());
+	REQUIRE(ascii[1000] == U'y');
+	REQUIRE(ascii.offset_of(500) == 500);
+}
+
+TEST_CASE("utf8_string shared between threads", "[utf8_string]")
+{
+	unicode_string_t expect;
+	for (std::size_t i = 0; i < 10000; ++i)
+		expect.push_back(i % 3 == 0 ? U'你' : U'a' + i % 26);
+	utf8_string str(expect);
+	std::vector<std::thread> threads;
+	std::vector<int> ok(4, 0);
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([&, t]() {
+			bool same = true;
+			for (std::size_t i = t; i < expect.size(); i += 7)
+				same = same && str[i] == expect[i];
+			ok[t] = same;
+		});
+	for (auto &th : threads)
+		th.join();
+	for (int val : ok)
+		REQUIRE(val);
+}
+
+TEST_CASE("utf8_string in variables", "[utf8_string][basic_var]")
+{
+	using op = var::operators_type;
+	var a = var::make<utf8_string>("你好"), b = var::make<utf8_string>("世界");
+	var ab = a.operate(op::add, &b).const_data()->const_val<utf8_string>();
+	REQUIRE(ab.const_val<utf8_string>().length() == 4);
+	REQUIRE(ab.to_string().view() == "你好世界");
+
+	var s = byte_string_t("你好");
+	REQUIRE(a.operate(op::compare, &s).const_data()->const_val<bool_t>());
+	REQUIRE(s.operate(op::compare, &a).const_data()->const_val<bool_t>());
+	REQUIRE(a.operate(op::add, &s).const_data()->const_val<utf8_string>().length() == 4);
+	var bad = byte_string_t("\xFF");
+	REQUIRE_THROWS_AS(a.operate(op::add, &bad), lang_error);
+	REQUIRE(a.hash() == s.hash());
+
+	// Keys found by strings without a variable
+	hash_map map;
+	map.emplace(a, numeric_t(1LL));
+	map.emplace(var::make<utf8_string>("ascii"), numeric_t(2LL));
+	REQUIRE(map.count(s) == 1);
+	REQUIRE(hash_count(map, byte_string_view("你好")) == 1);
+	REQUIRE(hash_find(map, "ascii")->second.const_val<numeric_t>() == 2);
+	REQUIRE(hash_find(map, byte_string_t("你好"))->second.const_val<numeric_t>() == 1);
+	REQUIRE(hash_count(map, "你") == 0);
+}
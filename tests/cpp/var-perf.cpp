@@ -33,6 +33,7 @@ int main()
 	std::cout << "sizeof(std::any): " << sizeof(std::any) << std::endl;
 	std::cout << "sizeof(cs::basic_var<32>): " << sizeof(cs::basic_var<32>) << std::endl;
 	std::cout << "sizeof(cs::basic_var<64>): " << sizeof(cs::basic_var<64>) << std::endl;
+	std::cout << "sizeof(cs::compact_var): " << sizeof(cs::compact_var) << std::endl;
 
 	TIME_BLOCK("std::any construct Small", {
 		std::vector<std::any> vec;
@@ -166,5 +167,108 @@ int main()
 		});
 	}
 
+	{
+		cs::array var_arr;
+		cs::compact_array compact_arr;
+
+		TIME_BLOCK("cs::array construct numeric", {
+			for (size_t i = 0; i < N; ++i)
+				var_arr.emplace_back(cs::numeric_t(cs::integer_t(i)));
+		});
+
+		TIME_BLOCK("cs::compact_array construct numeric", {
+			for (size_t i = 0; i < N; ++i)
+				compact_arr.emplace_back(cs::numeric_t(cs::integer_t(i)));
+		});
+
+		TIME_BLOCK("cs::array sum numeric", {
+			cs::numeric_t sum;
+			for (auto &v : var_arr)
+				sum = sum + v.const_val<cs::numeric_t>();
+			volatile cs::integer_t dummy = sum.as_integer();
+		});
+
+		TIME_BLOCK("cs::compact_array sum numeric", {
+			cs::numeric_t sum;
+			for (auto &v : compact_arr)
+				sum = sum + v.as_numeric();
+			volatile cs::integer_t dummy = sum.as_integer();
+		});
+	}
+
+	// Growth of small arrays kept in cache, dominated by relocation of elements
+	constexpr size_t M = 1000;
+
+	TIME_BLOCK("std::vector<cs::var> growth numeric", {
+		for (size_t n = 0; n < N / M; ++n)
+		{
+			std::vector<cs::var> vec;
+			for (size_t i = 0; i < M; ++i)
+				vec.emplace_back(cs::numeric_t(cs::integer_t(i)));
+		}
+	});
+
+	TIME_BLOCK("cs::fwd_array growth numeric", {
+		for (size_t n = 0; n < N / M; ++n)
+		{
+			cs::fwd_array vec;
+			for (size_t i = 0; i < M; ++i)
+				vec.emplace_back(cs::numeric_t(cs::integer_t(i)));
+		}
+	});
+
+	TIME_BLOCK("std::vector<cs::var> growth Large", {
+		for (size_t n = 0; n < N / M; ++n)
+		{
+			std::vector<cs::var> vec;
+			for (size_t i = 0; i < M; ++i)
+				vec.emplace_back(Large{});
+		}
+	});
+
+	TIME_BLOCK("cs::fwd_array growth Large", {
+		for (size_t n = 0; n < N / M; ++n)
+		{
+			cs::fwd_array vec;
+			for (size_t i = 0; i < M; ++i)
+				vec.emplace_back(Large{});
+		}
+	});
+
+	TIME_BLOCK("cs::stack<cs::var> push growth numeric", {
+		for (size_t n = 0; n < N / M; ++n)
+		{
+			cs::stack<cs::var> stack;
+			for (size_t i = 0; i < M; ++i)
+				stack.push(cs::numeric_t(cs::integer_t(i)));
+		}
+	});
+
+	TIME_BLOCK("cs::segmented_stack<cs::var> push growth numeric", {
+		for (size_t n = 0; n < N / M; ++n)
+		{
+			cs::segmented_stack<cs::var> stack;
+			for (size_t i = 0; i < M; ++i)
+				stack.push(cs::numeric_t(cs::integer_t(i)));
+		}
+	});
+
+	// Deep recursion, one large stack pushed and popped
+	TIME_BLOCK("cs::stack<cs::var> deep push pop", {
+		cs::stack<cs::var> stack;
+		for (size_t i = 0; i < N; ++i)
+			stack.push(cs::numeric_t(cs::integer_t(i)));
+		while (!stack.empty())
+			stack.pop_no_return();
+	});
+
+	TIME_BLOCK("cs::segmented_stack<cs::var> deep push pop", {
+		cs::segmented_stack<cs::var> stack;
+		for (size_t i = 0; i < N; ++i)
+			stack.push(cs::numeric_t(cs::integer_t(i)));
+		while (!stack.empty())
+			stack.pop_no_return();
+	});
+
 	return 0;
 }
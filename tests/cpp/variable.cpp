@@ -44,6 +44,18 @@ struct Large
 	}
 };
 
+struct Shared
+{
+	std::vector<int> data;
+	explicit Shared(std::size_t n) : data(n, 1) {}
+};
+
+template <>
+struct cs_impl::var_cow<Shared>
+{
+	static constexpr bool value = true;
+};
+
 TEST_CASE("basic_var: default/null behavior", "[basic_var]")
 {
 	cs::var v;
@@ -140,3 +152,297 @@ TEST_CASE("basic_var: swap and hash", "[basic_var][misc]")
 	REQUIRE(a.const_val<Small>().v == 2);
 	REQUIRE(b.const_val<Small>().v == 1);
 }
+
+TEST_CASE("basic_var: move keeps non-trivial payloads intact", "[basic_var][move]")
+{
+	cs::var a = cs::var::make<byte_string_t>("short");
+	cs::var b = cs::var::make<Large>(char(3));
+	cs::var c, d;
+	c = std::move(a);
+	d = std::move(b);
+	REQUIRE(a.is_null());
+	REQUIRE(b.is_null());
+	// Short strings keep their buffer inside the object, a bitwise move would dangle here
+	REQUIRE(c.const_val<byte_string_t>() == "short");
+	REQUIRE(d.const_val<Large>().data[1023] == 3);
+	c = std::move(d);
+	REQUIRE(c.is_type_of<Large>());
+	REQUIRE(d.is_null());
+
+	// Swapping short strings, with each other and with other storage
+	cs::var sa = byte_string_t("short-a"), sb = byte_string_t("short-b");
+	sa.swap(sb);
+	REQUIRE(sa.const_val<byte_string_t>() == "short-b");
+	REQUIRE(sb.const_val<byte_string_t>() == "short-a");
+	sa.swap(c);
+	REQUIRE(sa.is_type_of<Large>());
+	REQUIRE(c.const_val<byte_string_t>() == "short-b");
+	sb.swap(d);
+	REQUIRE(sb.is_null());
+	REQUIRE(d.const_val<byte_string_t>() == "short-a");
+}
+
+TEST_CASE("basic_var: builtin type tags", "[basic_var][tag]")
+{
+	cs::var n = numeric_t(1LL), b = true, s = byte_string_t("str"), u = cs::var::make<Small>(1), nullv;
+	REQUIRE(n.tag() == var_tag::numeric);
+	REQUIRE(b.tag() == var_tag::boolean);
+	REQUIRE(s.tag() == var_tag::string);
+	REQUIRE(u.tag() == var_tag::other);
+	REQUIRE(nullv.tag() == var_tag::null);
+	REQUIRE(n.is_type_of<numeric_t>());
+	REQUIRE(!n.is_type_of<bool_t>());
+	REQUIRE(s.is_type_of<byte_string_t>());
+	REQUIRE(b.const_val<bool_t>());
+	REQUIRE_THROWS_AS(n.const_val<byte_string_t>(), runtime_error);
+	REQUIRE_THROWS_AS(nullv.const_val<numeric_t>(), runtime_error);
+	cs::var moved = std::move(n);
+	REQUIRE(moved.tag() == var_tag::numeric);
+	REQUIRE(n.tag() == var_tag::null);
+	REQUIRE(n != moved);
+	REQUIRE(moved != nullv);
+	REQUIRE(nullv == cs::var());
+}
+
+TEST_CASE("basic_var: operators on builtin types", "[basic_var][operator]")
+{
+	using op = cs::var::operators_type;
+	cs::var a = numeric_t(6LL), b = numeric_t(4LL), c = numeric_t(2.5L);
+	REQUIRE(a.operate(op::add, &b).const_data()->const_val<numeric_t>() == 10);
+	REQUIRE(a.operate(op::sub, &b).const_data()->const_val<numeric_t>() == 2);
+	REQUIRE(a.operate(op::mul, &c).const_data()->const_val<numeric_t>() == 15);
+	REQUIRE(a.operate(op::div, &b).const_data()->const_val<numeric_t>() == 1.5L);
+	REQUIRE(a.operate(op::mod, &b).const_data()->const_val<numeric_t>() == 2);
+	REQUIRE(a.operate(op::pow, &b).const_data()->const_val<numeric_t>() == 1296);
+	REQUIRE(a.operate(op::abocmp, &b).const_data()->const_val<bool_t>());
+	REQUIRE(!a.operate(op::compare, &b).const_data()->const_val<bool_t>());
+	REQUIRE(a.operate(op::minus).const_data()->const_val<numeric_t>() == -6);
+	a.operate(op::selfinc);
+	REQUIRE(a.const_val<numeric_t>() == 7);
+
+	cs::var s1 = byte_string_t("ab"), s2 = byte_string_t("cd");
+	REQUIRE(s1.operate(op::add, &s2).const_data()->const_val<byte_string_t>() == "abcd");
+	REQUIRE(s1.operate(op::undcmp, &s2).const_data()->const_val<bool_t>());
+	REQUIRE(!s1.operate(op::compare, &a).const_data()->const_val<bool_t>());
+	REQUIRE_THROWS_AS(s1.operate(op::abocmp, &a), lang_error);
+}
+
+TEST_CASE("basic_var: mixed-type operator registry", "[basic_var][operator]")
+{
+	using op = cs::var::operators_type;
+	cs::var s = byte_string_t("n="), n = numeric_t(3LL), small = cs::var::make<Small>(4);
+	REQUIRE(s.type_id() == static_cast<std::size_t>(var_tag::string));
+	REQUIRE(small.type_id() == cs_impl::get_type_id<Small>());
+	REQUIRE(small.type_id() >= static_cast<std::size_t>(var_tag::other));
+	REQUIRE(s.operate(op::add, &n).const_data()->const_val<byte_string_t>() == "n=3");
+	REQUIRE_THROWS(small.operate(op::mul, &n));
+
+	cs::var::register_operator<Small, numeric_t>(op::mul, [](const cs::var &lhs, const cs::var &rhs) -> cs::var {
+		return cs::var::make<Small>(lhs.const_val<Small>().v * static_cast<int>(rhs.const_val<numeric_t>().as_integer()));
+	});
+	REQUIRE(small.operate(op::mul, &n).const_data()->const_val<Small>().v == 12);
+	// Registered kernels are directional
+	REQUIRE_THROWS(n.operate(op::mul, &small));
+	REQUIRE_THROWS_AS((cs::var::register_operator<Small, numeric_t>(op::minus, nullptr)), internal_error);
+}
+
+TEST_CASE("basic_var_borrower: owned results are stored inline", "[basic_var_borrower]")
+{
+	var_borrower owned(cs::var::make<Small>(9));
+	REQUIRE(owned.usable());
+	REQUIRE(owned.data() != nullptr);
+	var_borrower copied = owned;
+	REQUIRE(copied.const_data() != owned.const_data());
+	REQUIRE(copied.const_data()->const_val<Small>().v == 9);
+	var_borrower moved = std::move(owned);
+	REQUIRE(moved.const_data()->const_val<Small>().v == 9);
+	REQUIRE(owned.is_null());
+	copied = moved;
+	moved = var_borrower(cs::var::make<Small>(10));
+	REQUIRE(copied.const_data()->const_val<Small>().v == 9);
+	REQUIRE(moved.const_data()->const_val<Small>().v == 10);
+
+	const cs::var borrowed = cs::var::make<Small>(1);
+	var_borrower ref(borrowed);
+	REQUIRE(ref.data() == nullptr);
+	REQUIRE(ref.const_data() == &borrowed);
+}
+
+TEST_CASE("basic_var: copy-on-write payload", "[basic_var][cow]")
+{
+	cs::var a = cs::var::make<Shared>(16);
+	cs::var b = a;
+	// Copies share payload until written
+	REQUIRE(&a.const_val<Shared>() == &b.const_val<Shared>());
+	b.val<Shared>().data[0] = 2;
+	REQUIRE(&a.const_val<Shared>() != &b.const_val<Shared>());
+	REQUIRE(a.const_val<Shared>().data[0] == 1);
+	REQUIRE(b.const_val<Shared>().data[0] == 2);
+	// Sole owner is written in place
+	const Shared *addr = &b.const_val<Shared>();
+	b.val<Shared>().data[1] = 3;
+	REQUIRE(&b.const_val<Shared>() == addr);
+
+	cs::var c = a, d = a;
+	c = cs::var();
+	REQUIRE(d.const_val<Shared>().data.size() == 16);
+	cs::var e = std::move(d);
+	REQUIRE(&e.const_val<Shared>() == &a.const_val<Shared>());
+
+	// A reference taken before a copy writes to the original only
+	cs::var f = cs::var::make<Shared>(4);
+	Shared &ref = f.val<Shared>();
+	cs::var g = f;
+	ref.data.push_back(2);
+	REQUIRE(f.const_val<Shared>().data.size() == 5);
+	REQUIRE(g.const_val<Shared>().data.size() == 4);
+	// Copies of the copy share again
+	cs::var h = g;
+	REQUIRE(&h.const_val<Shared>() == &g.const_val<Shared>());
+
+	// Same for containers, shared or not depending on COVSCRIPT_COW_CONTAINERS
+	cs::var arr = cs::array{cs::var(cs::numeric_t(1LL))};
+	cs::array &arr_ref = arr.val<cs::array>();
+	cs::var arr_copy = arr;
+	arr_ref.push_back(cs::var(cs::numeric_t(2LL)));
+	REQUIRE(arr.const_val<cs::array>().size() == 2);
+	REQUIRE(arr_copy.const_val<cs::array>().size() == 1);
+}
+
+TEST_CASE("basic_var: cached hash of strings", "[basic_var][hash]")
+{
+	cs::string text(100, 'x');
+	std::size_t code = cs_impl::hash_bytes(text.data(), text.size());
+	REQUIRE(cs_impl::hash_bytes("", 0) != cs_impl::hash_bytes("a", 1));
+	REQUIRE(cs_impl::hash_bytes("ab", 2) != cs_impl::hash_bytes("ba", 2));
+
+	cs::var a = text;
+	REQUIRE(a.hash() == code);
+	REQUIRE(a.hash() == code);
+	// Copies and moves keep the cached hash valid
+	cs::var b = a;
+	REQUIRE(b.hash() == code);
+	cs::var c = std::move(b);
+	REQUIRE(c.hash() == code);
+
+	// Mutable access invalidates it
+	c.val<cs::string>() += "y";
+	REQUIRE(c.hash() == cs_impl::hash_bytes((text + "y").data(), text.size() + 1));
+	REQUIRE(a.hash() == code);
+
+	// Writes through a reference kept after hashing are seen as well
+	cs::var s = cs::string("xyz");
+	cs::string &rs = s.val<cs::string>();
+	REQUIRE(s.hash() == cs_impl::hash_bytes("xyz", 3));
+	rs[0] = 'y';
+	REQUIRE(s.hash() == cs_impl::hash_bytes("yyz", 3));
+	cs::var s_copy = s;
+	REQUIRE(s_copy.hash() == cs_impl::hash_bytes("yyz", 3));
+	rs += "long enough for the heap of any small buffer";
+	REQUIRE(s.hash() == cs_impl::hash_bytes(rs.data(), rs.size()));
+	REQUIRE(s_copy.hash() == cs_impl::hash_bytes("yyz", 3));
+
+	// Heap stored strings of small variables are cached as well
+	cs::basic_var<32> small = text;
+	REQUIRE(small.hash() == code);
+	small.val<cs::string>().clear();
+	REQUIRE(small.hash() == cs_impl::hash_bytes("", 0));
+
+	cs::hash_map map;
+	map.emplace(a, cs::numeric_t(1LL));
+	REQUIRE(map.count(c) == 0);
+	REQUIRE(map.at(cs::var(text)).const_val<cs::numeric_t>() == 1);
+}
+
+TEST_CASE("hash_map: lookup without key variables", "[hash_map][hash]")
+{
+	cs::var_hash hasher;
+	REQUIRE(hasher(cs::string_view("key")) == cs::var(cs::string("key")).hash());
+	REQUIRE(hasher(cs::integer_t(42)) == cs::var(cs::numeric_t(42LL)).hash());
+	REQUIRE(hasher(cs::numeric_t(0.5L)) == cs::var(cs::numeric_t(0.5L)).hash());
+	// Numerics comparing equal hash equally
+	REQUIRE(cs::numeric_t(3.0L).hash() == cs::numeric_t(3LL).hash());
+	REQUIRE(cs::numeric_t(-7.0L).hash() == cs::numeric_t(-7LL).hash());
+	REQUIRE(cs::var(cs::numeric_t(1e30L)).hash() == cs::numeric_t(1e30L).hash());
+
+	cs::hash_map map;
+	map.emplace(cs::string("name"), cs::numeric_t(1LL));
+	map.emplace(cs::numeric_t(2LL), cs::numeric_t(2LL));
+	map.emplace(cs::numeric_t(2.5L), cs::numeric_t(3LL));
+
+	auto it = cs::hash_find(map, cs::string_view("name"));
+	REQUIRE(it != map.end());
+	REQUIRE(it->second.const_val<cs::numeric_t>() == 1);
+	REQUIRE(cs::hash_count(map, "name") == 1);
+	REQUIRE(cs::hash_count(map, "other") == 0);
+	// Strings convert to var and string_view alike
+	const cs::string name("name");
+	REQUIRE(cs::hash_count(map, name) == 1);
+	REQUIRE(cs::hash_find(map, name)->second.const_val<cs::numeric_t>() == 1);
+	REQUIRE(map.count(name) == 1);
+	REQUIRE(map.find(name) != map.end());
+	REQUIRE(map[name].const_val<cs::numeric_t>() == 1);
+	REQUIRE(hasher(name) == cs::var(name).hash());
+	REQUIRE(cs::var_equal()(name, cs::var(name)));
+	REQUIRE(cs::hash_find(map, cs::integer_t(2))->second.const_val<cs::numeric_t>() == 2);
+	REQUIRE(cs::hash_find(map, cs::numeric_t(2.0L))->second.const_val<cs::numeric_t>() == 2);
+	REQUIRE(cs::hash_find(map, cs::numeric_t(2.5L))->second.const_val<cs::numeric_t>() == 3);
+	REQUIRE(cs::hash_find(map, cs::integer_t(3)) == map.end());
+	// Types must match as well
+	REQUIRE(cs::hash_count(map, "2") == 0);
+	REQUIRE(cs::hash_count(map, cs::var(cs::numeric_t(2.0L))) == 1);
+
+	cs::hash_set set;
+	set.emplace(cs::string("a"));
+	set.emplace(cs::numeric_t(1LL));
+	REQUIRE(cs::hash_count(set, cs::string_view("a")) == 1);
+	REQUIRE(cs::hash_count(set, cs::numeric_t(1.0L)) == 1);
+	REQUIRE(cs::hash_count(set, cs::integer_t(2)) == 0);
+}
+
+TEST_CASE("basic_var: streaming to_string of containers", "[basic_var][to_string]")
+{
+	cs::array arr{cs::var(cs::numeric_t(1LL)), cs::var(cs::string("a\"b\\c\n")), cs::var(true), cs::var(), cs::var(cs::numeric_t(0.5L))};
+	cs::var a = arr;
+	REQUIRE(a.to_string().view() == "{1, \"a\\\"b\\\\c\\n\", true, null, 0.5}");
+
+	// Every control byte is escaped, text outside ASCII is kept as is
+	cs::var ctrl = cs::array{cs::var(cs::string("r\r\0z\x01\x1b\x7f\xe4\xb8\xad", 10))};
+	REQUIRE(ctrl.to_string().view() == "{\"r\\r\\0z\\x01\\x1b\\x7f\xe4\xb8\xad\"}");
+
+	// Appends to what is already in the sink
+	cs::string out = "value: ";
+	a.to_stream(out);
+	REQUIRE(out == cs::string("value: ") + cs::string(a.to_string().view()));
+
+	// Top level strings are not quoted, same as to_string
+	cs::var str = cs::string("plain");
+	out.clear();
+	str.to_stream(out);
+	REQUIRE(out == "plain");
+
+	cs::var big = cs::numeric_t(cs::bigint::parse("123456789012345678901234567890"));
+	out.clear();
+	big.to_stream(out);
+	REQUIRE(out == "123456789012345678901234567890");
+
+	cs::var p = cs::pair(cs::var(cs::string("k")), cs::var(cs::list{cs::var(cs::numeric_t(2LL))}));
+	REQUIRE(p.to_string().view() == "\"k\":{2}");
+
+	cs::hash_map map;
+	map.emplace(cs::string("x"), a);
+	cs::var m = map;
+	REQUIRE(m.to_string().view() == "{\"x\":{1, \"a\\\"b\\\\c\\n\", true, null, 0.5}}");
+	REQUIRE(cs::var(cs::hash_map()).to_string().view() == "{}");
+
+	cs::compact_array compact;
+	compact.emplace_back(cs::numeric_t(3LL));
+	compact.emplace_back(cs::var(cs::string("s")));
+	REQUIRE(cs::var(compact).to_string().view() == "{3, \"s\"}");
+
+	// Other types fall back to to_string
+	cs::var r = cs::var::make<cs::rope>("rope");
+	out.clear();
+	r.to_stream(out);
+	REQUIRE(out == "rope");
+}
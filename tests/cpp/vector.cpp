@@ -0,0 +1,185 @@
+#include <covscript/types/types.hpp>
+#include <catch2/catch_all.hpp>
+
+using namespace cs;
+
+TEST_CASE("vector basic operations", "[vector]")
+{
+	vector<int> v;
+	REQUIRE(v.empty());
+
+	for (int i = 0; i < 100; ++i)
+		v.push_back(i);
+	REQUIRE(v.size() == 100);
+	REQUIRE(v.capacity() >= 100);
+	REQUIRE(v.front() == 0);
+	REQUIRE(v.back() == 99);
+	REQUIRE(v.at(42) == 42);
+	REQUIRE_THROWS_AS(v.at(100), std::out_of_range);
+
+	v.pop_back();
+	REQUIRE(v.size() == 99);
+
+	v.resize(10);
+	REQUIRE(v.size() == 10);
+	v.resize(12, 7);
+	REQUIRE(v[11] == 7);
+
+	v.clear();
+	REQUIRE(v.empty());
+}
+
+TEST_CASE("vector insert and erase", "[vector]")
+{
+	vector<std::string> v{"a", "b", "d"};
+
+	v.insert(v.begin() + 2, "c");
+	REQUIRE(v == vector<std::string>{"a", "b", "c", "d"});
+
+	v.erase(v.begin());
+	REQUIRE(v == vector<std::string>{"b", "c", "d"});
+
+	std::vector<std::string> more{"x", "y"};
+	v.insert(v.begin() + 1, more.begin(), more.end());
+	REQUIRE(v == vector<std::string>{"b", "x", "y", "c", "d"});
+
+	v.erase(v.begin() + 1, v.begin() + 3);
+	REQUIRE(v == vector<std::string>{"b", "c", "d"});
+
+	// Argument refers to an element of the vector being grown
+	v.shrink_to_fit();
+	v.push_back(v.front());
+	REQUIRE(v.back() == "b");
+}
+
+// Copies throw once the budget is used up
+struct throwing_copy
+{
+	static int live;
+	static int budget;
+	int value;
+
+	explicit throwing_copy(int val) : value(val)
+	{
+		++live;
+	}
+
+	throwing_copy(const throwing_copy &other) : value(other.value)
+	{
+		if (budget-- == 0)
+			throw std::runtime_error("copy");
+		++live;
+	}
+
+	throwing_copy(throwing_copy &&other) noexcept : value(other.value)
+	{
+		++live;
+	}
+
+	~throwing_copy()
+	{
+		--live;
+	}
+};
+
+int throwing_copy::live = 0;
+int throwing_copy::budget = 0;
+
+TEST_CASE("vector releases elements when a copy throws", "[vector]")
+{
+	{
+		vector<throwing_copy> v;
+		for (int i = 0; i < 10; ++i)
+			v.emplace_back(i);
+		REQUIRE(throwing_copy::live == 10);
+
+		throwing_copy::budget = 5;
+		REQUIRE_THROWS_AS(vector<throwing_copy>(v), std::runtime_error);
+		REQUIRE(throwing_copy::live == 10);
+
+		throwing_copy::budget = 3;
+		REQUIRE_THROWS_AS(vector<throwing_copy>(v.begin(), v.end()), std::runtime_error);
+		REQUIRE(throwing_copy::live == 10);
+
+		throwing_copy::budget = 4;
+		REQUIRE_THROWS_AS(vector<throwing_copy>(20, v.front()), std::runtime_error);
+		REQUIRE(throwing_copy::live == 10);
+
+		// Size is unchanged when growing fails
+		throwing_copy::budget = 2;
+		REQUIRE_THROWS_AS(v.resize(20, v.back()), std::runtime_error);
+		REQUIRE(v.size() == 10);
+		REQUIRE(throwing_copy::live == 10);
+		REQUIRE(v.back().value == 9);
+	}
+	REQUIRE(throwing_copy::live == 0);
+}
+
+TEST_CASE("vector copy and move", "[vector]")
+{
+	vector<std::string> v{"hello", "world"};
+	vector<std::string> copy(v);
+	REQUIRE(copy == v);
+
+	vector<std::string> moved(std::move(copy));
+	REQUIRE(moved == v);
+	REQUIRE(copy.empty());
+
+	copy = moved;
+	REQUIRE(copy == v);
+}
+
+TEST_CASE("variable relocation", "[vector][var]")
+{
+	REQUIRE(var().relocatable());
+	REQUIRE(var(numeric_t(1LL)).relocatable());
+	REQUIRE(var(true).relocatable());
+	// Heap stored payloads are relocated by stealing the pointer
+	REQUIRE(var(array{numeric_t(1LL)}).relocatable());
+	// Short strings point into their own buffer, unless strings are shared payloads
+	REQUIRE(var(string("str")).relocatable() == cs_impl::var_cow<string>::value);
+
+	SECTION("all relocatable")
+	{
+		fwd_array v;
+		for (integer_t i = 0; i < 1000; ++i)
+			v.emplace_back(numeric_t(i));
+		for (integer_t i = 0; i < 1000; ++i)
+			REQUIRE(v[i].const_val<numeric_t>() == i);
+	}
+
+	SECTION("mixed with non-relocatable")
+	{
+		fwd_array v;
+		for (integer_t i = 0; i < 1000; ++i)
+		{
+			if (i % 3 == 0)
+				v.emplace_back(string(std::to_string(i)));
+			else if (i % 3 == 1)
+				v.emplace_back(array{numeric_t(i)});
+			else
+				v.emplace_back(numeric_t(i));
+		}
+		for (integer_t i = 0; i < 1000; ++i)
+		{
+			if (i % 3 == 0)
+				REQUIRE(v[i].const_val<string>() == std::to_string(i));
+			else if (i % 3 == 1)
+				REQUIRE(v[i].const_val<array>().front().const_val<numeric_t>() == i);
+			else
+				REQUIRE(v[i].const_val<numeric_t>() == i);
+		}
+		v.erase(v.begin());
+		REQUIRE(v.front().const_val<array>().front().const_val<numeric_t>() == 1);
+	}
+
+	SECTION("stack growth")
+	{
+		stack<var> s(1);
+		for (integer_t i = 0; i < 200; ++i)
+			s.push(numeric_t(i));
+		REQUIRE(s.size() == 200);
+		REQUIRE(s.top().const_val<numeric_t>() == 199);
+		REQUIRE(s.bottom().const_val<numeric_t>() == 0);
+	}
+}